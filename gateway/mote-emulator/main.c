@@ -0,0 +1,709 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory,
+ * University of Colombo School of Computting.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ */
+
+/**
+ * \file
+ *         Mote emulator. Stands in for a gateway mote running tikiridb on a
+ *         pseudo-terminal, so that sf and its clients can be run and load
+ *         tested without Contiki, Cooja or hardware.
+ *
+ *         Query requests arriving on the serial line are handled like
+ *         tikiridb.c and qprocessor.c do it and every virtual node of the
+ *         network answers them with synthetic sensor readings.
+ */
+
+#define _GNU_SOURCE /* posix_openpt(), cfmakeraw() */
+
+#include "messages.h"
+#include "nw-types.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEBUG 0
+
+#if DEBUG
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+/* SLIP characters, the same as node/packetizer.c */
+#define SLIP_END     0300
+#define SLIP_ESC     0333
+#define SLIP_ESC_END 0334
+#define SLIP_ESC_ESC 0335
+
+/* SLIP states */
+enum {
+  STATE_OK = 1,
+  STATE_ESC = 2,
+  STATE_RUBBISH = 3,
+};
+
+/* Receive buffer of the packetizer on the mote. */
+#define PACKETIZER_BUF_SIZE 128
+
+/* Size of the buffer qprocessor builds query results in. */
+#define QRESULT_BUF_SIZE 64
+
+#ifdef CONF_MAX_QUERIES
+#define MAX_QUERIES CONF_MAX_QUERIES
+#else
+#define MAX_QUERIES 16
+#endif
+
+/*
+ * Bytes waiting to be read by sf. Results produced while the buffer is full
+ * are dropped, as they would be lost on a serial line nobody listens to.
+ */
+#ifdef CONF_OUT_BUF_SIZE
+#define OUT_BUF_SIZE CONF_OUT_BUF_SIZE
+#else
+#define OUT_BUF_SIZE 65536
+#endif
+
+/* Attribute ids, see gateway/tikirisql/attr-index.h */
+#define ATTR_NODE 1
+#define MAX_ATTRS 16
+
+#define MAX_NODES 65534
+
+typedef struct query {
+  uint8_t used;
+  uint8_t qid;
+  uint8_t nfields;
+  uint8_t nexprs;
+  uint16_t nepochs;
+  uint64_t start;            /* time the query was received, us */
+  uint64_t period;           /* epoch duration, us */
+  unsigned int running;      /* nodes which still have epochs to run */
+  field_t fields[PACKETIZER_BUF_SIZE / sizeof(field_t)];
+  expression_t exprs[PACKETIZER_BUF_SIZE / sizeof(expression_t)];
+} query_t;
+
+/* Next result due from a node for a query. */
+typedef struct event {
+  uint64_t due;
+  uint16_t epoch;
+  uint8_t query;
+  uint16_t node;
+} event_t;
+
+/* Range and step of the random walk of the synthetic readings. */
+typedef struct attr_range {
+  int16_t min;
+  int16_t max;
+  int16_t step;
+} attr_range_t;
+
+static const attr_range_t attr_ranges[MAX_ATTRS] = {
+  {0, 0, 0},        /* unused */
+  {0, 0, 0},        /* NODE, the node address */
+  {20, 40, 1},      /* TEMP */
+  {30, 90, 2},      /* HUMID */
+  {0, 1000, 25},    /* LIGHT */
+  {400, 600, 10},   /* ACCELX */
+  {400, 600, 10},   /* ACCELY */
+  {400, 600, 10},   /* MAGX */
+  {400, 600, 10},   /* MAGY */
+  {0, 255, 255},    /* ECHO */
+};
+
+static unsigned int nodes = 8;
+static double rate = 0;
+static unsigned int jitter = 0;
+static int verbose = 0;
+
+static int master = -1;
+static query_t queries[MAX_QUERIES];
+static event_t * events;
+static unsigned int nevents;
+static int16_t * readings;
+
+static unsigned char rxbuf[PACKETIZER_BUF_SIZE];
+static int rxlen;
+static int rxstate = STATE_OK;
+
+static unsigned char outbuf[OUT_BUF_SIZE];
+static int outlen;
+
+static unsigned long nqueries, nresults, ndropped;
+static volatile sig_atomic_t stop;
+
+/*---------------------------------------------------------------------------*/
+static uint64_t
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sig_handler(int sig)
+{
+  stop = 1;
+}
+/*---------------------------------------------------------------------------*/
+/* Min-heap of the pending results, ordered by due time. */
+static void
+event_push(const event_t * e)
+{
+  unsigned int i = nevents++;
+
+  while(i > 0 && events[(i - 1) / 2].due > e->due) {
+    events[i] = events[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  events[i] = *e;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event_pop(event_t * e)
+{
+  unsigned int i = 0, child;
+  event_t last = events[--nevents];
+
+  *e = events[0];
+  while((child = 2 * i + 1) < nevents) {
+    if(child + 1 < nevents && events[child + 1].due < events[child].due) {
+      child++;
+    }
+    if(last.due <= events[child].due) {
+      break;
+    }
+    events[i] = events[child];
+    i = child;
+  }
+  events[i] = last;
+}
+/*---------------------------------------------------------------------------*/
+static void
+event_remove_query(int slot)
+{
+  unsigned int i, n = nevents;
+  event_t * e = malloc(sizeof(event_t) * n);
+
+  memcpy(e, events, sizeof(event_t) * n);
+  nevents = 0;
+  for(i = 0; i < n; i++) {
+    if(e[i].query != slot) {
+      event_push(&e[i]);
+    }
+  }
+  free(e);
+}
+/*---------------------------------------------------------------------------*/
+static void
+schedule(int slot, unsigned int node, uint16_t epoch)
+{
+  event_t e;
+  query_t * q = &queries[slot];
+
+  /* Like a ctimer on the mote, the first result comes after one epoch. */
+  e.due = q->start + (epoch + 1) * q->period;
+  if(jitter > 0) {
+    e.due += (uint64_t)(random() % (jitter + 1)) * 1000;
+  }
+  e.epoch = epoch;
+  e.query = slot;
+  e.node = node;
+  event_push(&e);
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush_output(void)
+{
+  int k;
+
+  while(outlen > 0) {
+    k = write(master, outbuf, outlen);
+    if(k < 0) {
+      if(errno != EAGAIN && errno != EINTR && errno != EIO) {
+        perror("Can not write to the pseudo-terminal");
+      }
+      return;
+    }
+    memmove(outbuf, outbuf + k, outlen - k);
+    outlen -= k;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Frame the message the way packetizer_send() does. */
+static void
+packetizer_send(const unsigned char * buffer, int len)
+{
+  unsigned char frame[2 * QRESULT_BUF_SIZE + 2];
+  int i, n = 0;
+
+  frame[n++] = SLIP_END;
+  for(i = 0; i < len; i++) {
+    switch(buffer[i]) {
+      case SLIP_END:
+        frame[n++] = SLIP_ESC;
+        frame[n++] = SLIP_ESC_END;
+        break;
+      case SLIP_ESC:
+        frame[n++] = SLIP_ESC;
+        frame[n++] = SLIP_ESC_ESC;
+        break;
+      default:
+        frame[n++] = buffer[i];
+    }
+  }
+  frame[n++] = SLIP_END;
+
+  if(outlen + n > OUT_BUF_SIZE) {
+    ndropped++;
+    return;
+  }
+  memcpy(outbuf + outlen, frame, n);
+  outlen += n;
+  nresults++;
+}
+/*---------------------------------------------------------------------------*/
+static void
+get_data(unsigned int node, uint8_t id, attr_data_t * data)
+{
+  int16_t * value;
+  const attr_range_t * r;
+
+  memset(data, 0, sizeof(attr_data_t));
+  if(id == ATTR_NODE) {
+    hton_leuint16(data, node + 1);
+    return;
+  }
+  if(id >= MAX_ATTRS || attr_ranges[id].step == 0) {
+    hton_leuint16(data, random() % 255);
+    return;
+  }
+
+  r = &attr_ranges[id];
+  value = &readings[node * MAX_ATTRS + id];
+  *value += random() % (2 * r->step + 1) - r->step;
+  if(*value < r->min) {
+    *value = r->min;
+  } else if(*value > r->max) {
+    *value = r->max;
+  }
+  hton_leuint16(data, *value);
+}
+/*---------------------------------------------------------------------------*/
+static int
+evaluate_expression(expression_t * expr, attr_data_t * data)
+{
+  uint16_t u_A = ntoh_leuint16(&data[expr->l_value_index]);
+  uint16_t u_B = ntoh_leuint16(&expr->r_value);
+
+  switch(expr->op) {
+    case EQ:
+      return u_A == u_B;
+    case NEQ:
+      return u_A != u_B;
+    case GT:
+      return u_A > u_B;
+    case GE:
+      return u_A >= u_B;
+    case LT:
+      return u_A < u_B;
+    case LE:
+      return u_A <= u_B;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Run one epoch of a query on a node, as execute_select_query() does. The
+ * result lists the in_result fields back to back with nrfields set to their
+ * count, which is how sf clients read it.
+ */
+static void
+execute_select_query(int slot, unsigned int node, uint16_t epoch)
+{
+  int i, len;
+  query_t * q = &queries[slot];
+  attr_data_t data[PACKETIZER_BUF_SIZE / sizeof(field_t)];
+  unsigned char buffer[QRESULT_BUF_SIZE];
+  message_header_t * message_header = (message_header_t *)buffer;
+  qresult_header_t * qresult_header = (qresult_header_t *)(message_header + 1);
+  rfield_t * rfield = (rfield_t *)(qresult_header + 1);
+
+  for(i = 0; i < q->nfields; i++) {
+    get_data(node, q->fields[i].id, &data[i]);
+  }
+  for(i = 0; i < q->nexprs; i++) {
+    if(!evaluate_expression(&q->exprs[i], data)) {
+      return;
+    }
+  }
+
+  message_header->type = MSG_QREPLY;
+  qresult_header->qid = q->qid;
+  qresult_header->type = 1;
+  qresult_header->nrfields = 0;
+  hton_leuint16(&qresult_header->epoch, epoch);
+  qresult_header->nodeaddr.u8[0] = (node + 1) & 0xFF;
+  qresult_header->nodeaddr.u8[1] = (node + 1) >> 8;
+
+  len = sizeof(message_header_t) + sizeof(qresult_header_t);
+  for(i = 0; i < q->nfields; i++) {
+    if(!q->fields[i].in_result) {
+      continue;
+    }
+    if(len + sizeof(rfield_t) > QRESULT_BUF_SIZE) {
+      PRINTF("Not enough space in buffer, qid %d\n", q->qid);
+      return;
+    }
+    rfield->id = q->fields[i].id;
+    memcpy(&rfield->data, &data[i], sizeof(attr_data_t));
+    qresult_header->nrfields++;
+    rfield++;
+    len += sizeof(rfield_t);
+  }
+
+  packetizer_send(buffer, len);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run_query(const event_t * e)
+{
+  query_t * q = &queries[e->query];
+
+  execute_select_query(e->query, e->node, e->epoch);
+
+  if(q->nepochs == 0 || e->epoch + 1 < q->nepochs) {
+    schedule(e->query, e->node, e->epoch + 1);
+  } else if(--q->running == 0) {
+    if(verbose) {
+      printf("Query %d finished\n", q->qid);
+    }
+    q->used = 0;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+add_query(message_header_t * message_header, int len)
+{
+  int i, slot = -1;
+  unsigned int node;
+  uint16_t epoch_duration;
+  qmessage_header_t * qmessage_header = (qmessage_header_t *)(message_header + 1);
+  smessage_header_t * smessage_header = (smessage_header_t *)(qmessage_header + 1);
+  query_t * q;
+
+  /* The same checks tikiridb_process does before flooding the query. */
+  if(len <= sizeof(message_header_t) + sizeof(qmessage_header_t) ||
+     message_header->type != MSG_QREQUEST) {
+    PRINTF("Not a query request, length %d\n", len);
+    return;
+  }
+  if(qmessage_header->qtype != QTYPE_SELECT) {
+    fprintf(stderr, "Query %d: only SELECT queries are supported\n",
+            qmessage_header->qid);
+    return;
+  }
+  if(len < sizeof(message_header_t) + sizeof(qmessage_header_t) +
+           sizeof(smessage_header_t) ||
+     len != get_message_length(message_header)) {
+    fprintf(stderr, "Invalid query message, length %d\n", len);
+    return;
+  }
+
+  /* A query with a running qid replaces it. */
+  for(i = 0; i < MAX_QUERIES; i++) {
+    if(queries[i].used && queries[i].qid == qmessage_header->qid) {
+      event_remove_query(i);
+      slot = i;
+      break;
+    }
+    if(slot < 0 && !queries[i].used) {
+      slot = i;
+    }
+  }
+  if(slot < 0) {
+    fprintf(stderr, "Query %d: query table is full\n", qmessage_header->qid);
+    return;
+  }
+
+  q = &queries[slot];
+  q->used = 1;
+  q->qid = qmessage_header->qid;
+  q->nfields = smessage_header->nfields;
+  q->nexprs = smessage_header->nexprs;
+  q->nepochs = ntoh_leuint16(&smessage_header->nepochs);
+  memcpy(q->fields, smessage_header + 1, sizeof(field_t) * q->nfields);
+  memcpy(q->exprs, (field_t *)(smessage_header + 1) + q->nfields,
+         sizeof(expression_t) * q->nexprs);
+  for(i = 0; i < q->nexprs; i++) {
+    if(q->exprs[i].l_value_index >= q->nfields) {
+      fprintf(stderr, "Query %d: invalid expression\n", q->qid);
+      q->used = 0;
+      return;
+    }
+  }
+
+  epoch_duration = ntoh_leuint16(&smessage_header->epoch_duration);
+  if(rate > 0) {
+    q->period = 1000000 / rate;
+  } else {
+    q->period = (epoch_duration > 0 ? epoch_duration : 1) * 1000000ULL;
+  }
+  q->start = now();
+  q->running = nodes;
+  for(node = 0; node < nodes; node++) {
+    schedule(slot, node, 0);
+  }
+
+  nqueries++;
+  if(verbose) {
+    printf("Query %d: %d fields, %d expressions, epoch %u ms, %d epochs\n",
+           q->qid, q->nfields, q->nexprs, (unsigned int)(q->period / 1000),
+           q->nepochs);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* The receiving side of node/packetizer.c */
+static void
+packetizer_input_byte(unsigned char c)
+{
+  switch(rxstate) {
+  case STATE_RUBBISH:
+    if(c == SLIP_END) {
+      rxstate = STATE_OK;
+    }
+    return;
+
+  case STATE_ESC:
+    if(c == SLIP_ESC_END) {
+      c = SLIP_END;
+    } else if(c == SLIP_ESC_ESC) {
+      c = SLIP_ESC;
+    } else {
+      rxstate = STATE_RUBBISH;
+      rxlen = 0;
+      return;
+    }
+    rxstate = STATE_OK;
+    break;
+
+  case STATE_OK:
+    if(c == SLIP_ESC) {
+      rxstate = STATE_ESC;
+      return;
+    } else if(c == SLIP_END) {
+      if(rxlen > 0) {
+        add_query((message_header_t *)rxbuf, rxlen);
+        rxlen = 0;
+      }
+      return;
+    }
+    break;
+  }
+
+  if(rxlen == PACKETIZER_BUF_SIZE) {
+    rxstate = STATE_RUBBISH;
+    rxlen = 0;
+    return;
+  }
+  rxbuf[rxlen++] = c;
+}
+/*---------------------------------------------------------------------------*/
+static int
+open_pty(const char * link_path)
+{
+  int slave;
+  char * name;
+  struct termios tios;
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+     (name = ptsname(master)) == NULL) {
+    perror("Can not create a pseudo-terminal");
+    return -1;
+  }
+
+  /*
+   * Keep the slave side open, so that the terminal stays usable while sf
+   * is restarted.
+   */
+  slave = open(name, O_RDWR | O_NOCTTY);
+  if(slave < 0) {
+    perror("Can not open the pseudo-terminal");
+    return -1;
+  }
+  tcgetattr(slave, &tios);
+  cfmakeraw(&tios);
+  tcsetattr(slave, TCSANOW, &tios);
+
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if(link_path != NULL) {
+    unlink(link_path);
+    if(symlink(name, link_path) < 0) {
+      perror("Can not link the pseudo-terminal");
+      return -1;
+    }
+  }
+
+  printf("Emulating %u nodes on %s\n", nodes, name);
+  fflush(stdout);
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char * name)
+{
+  fprintf(stderr, "Usage: %s [-n <nodes>] [-r <rate>] [-j <jitter>] "
+          "[-l <link>] [-v]\n", name);
+  fprintf(stderr, "  -n <nodes>  : number of virtual nodes answering queries"
+          " (default 8).\n");
+  fprintf(stderr, "  -r <rate>   : results per second from each node,"
+          " overrides the sample period of\n"
+          "                the queries.\n");
+  fprintf(stderr, "  -j <jitter> : maximum delay of a result within its"
+          " epoch in milliseconds.\n");
+  fprintf(stderr, "  -l <link>   : create a symbolic link to the"
+          " pseudo-terminal.\n");
+  fprintf(stderr, "  -v          : print queries as they arrive.\n");
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char** argv)
+{
+  int c, k, timeout;
+  uint64_t t;
+  int i;
+  unsigned char buf[512];
+  char * link_path = NULL;
+  struct pollfd pfd;
+  event_t e;
+
+  while((c = getopt(argc, argv, "n:r:j:l:vh")) != -1) {
+    switch(c) {
+      case 'n':
+        nodes = atoi(optarg);
+        break;
+      case 'r':
+        rate = atof(optarg);
+        break;
+      case 'j':
+        jitter = atoi(optarg);
+        break;
+      case 'l':
+        link_path = optarg;
+        break;
+      case 'v':
+        verbose = 1;
+        break;
+      default:
+        usage(argv[0]);
+        return -1;
+    }
+  }
+  if(nodes == 0 || nodes > MAX_NODES || rate < 0) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  events = malloc(sizeof(event_t) * MAX_QUERIES * nodes);
+  readings = malloc(sizeof(int16_t) * MAX_ATTRS * nodes);
+  if(events == NULL || readings == NULL) {
+    perror("Can not allocate memory");
+    return -1;
+  }
+  srandom(time(NULL));
+  for(i = 0; i < (int)(MAX_ATTRS * nodes); i++) {
+    c = i % MAX_ATTRS;
+    readings[i] = attr_ranges[c].min +
+                  random() % (attr_ranges[c].max - attr_ranges[c].min + 1);
+  }
+
+  signal(SIGINT, sig_handler);
+  signal(SIGTERM, sig_handler);
+
+  if(open_pty(link_path) < 0) {
+    return -1;
+  }
+
+  while(!stop) {
+    t = now();
+    while(nevents > 0 && events[0].due <= t) {
+      event_pop(&e);
+      run_query(&e);
+    }
+    flush_output();
+
+    timeout = -1;
+    if(nevents > 0) {
+      timeout = (events[0].due - t + 999) / 1000;
+    }
+    pfd.fd = master;
+    pfd.events = POLLIN | (outlen > 0 ? POLLOUT : 0);
+    k = poll(&pfd, 1, timeout);
+    if(k < 0) {
+      if(errno != EINTR) {
+        perror("poll failed");
+        break;
+      }
+      continue;
+    }
+
+    if(pfd.revents & POLLIN) {
+      k = read(master, buf, sizeof(buf));
+      if(k < 0) {
+        if(errno != EAGAIN && errno != EINTR && errno != EIO) {
+          perror("Can not read from the pseudo-terminal");
+          break;
+        }
+        continue;
+      }
+      for(i = 0; i < k; i++) {
+        packetizer_input_byte(buf[i]);
+      }
+    }
+  }
+
+  if(link_path != NULL) {
+    unlink(link_path);
+  }
+  printf("queries=%lu results=%lu dropped=%lu\n", nqueries, nresults, ndropped);
+  return 0;
+}
@@ -81,7 +81,7 @@ BaseComm::fdWait(int fd, int mask, unsigned int mSecs)
   }
 
   tv.tv_sec = mSecs / 1000;
-  tv.tv_usec = mSecs % 1000;
+  tv.tv_usec = (mSecs % 1000) * 1000;
 
   do {
     retval =  select(fd + 1, &rfds, &wfds,NULL,&tv);
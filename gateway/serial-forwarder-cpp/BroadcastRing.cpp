@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Broadcast ring source file.
+ */
+
+#include "BroadcastRing.h"
+
+/*----------------------------------------------------------------------------*/
+BroadcastRing::BroadcastRing(int size)
+{
+  this->size = 1;
+  while(this->size < size) {
+    this->size <<= 1;
+  }
+  mask = this->size - 1;
+  slots = new Packet[this->size];
+  published = 0;
+}
+/*----------------------------------------------------------------------------*/
+BroadcastRing::~BroadcastRing()
+{
+  delete[] slots;
+}
+/*----------------------------------------------------------------------------*/
+void
+BroadcastRing::publish(const Packet &packet)
+{
+  slots[published & mask] = packet;
+  // readers see the packet before the sequence that makes it theirs
+  __atomic_store_n(&published, published + 1, __ATOMIC_RELEASE);
+}
+/*----------------------------------------------------------------------------*/
+uint64_t
+BroadcastRing::getPublished() const
+{
+  return __atomic_load_n(&published, __ATOMIC_ACQUIRE);
+}
+/*----------------------------------------------------------------------------*/
+const Packet &
+BroadcastRing::get(uint64_t seq) const
+{
+  return slots[seq & mask];
+}
+/*----------------------------------------------------------------------------*/
+int
+BroadcastRing::getCapacity() const
+{
+  return size;
+}
+/*----------------------------------------------------------------------------*/
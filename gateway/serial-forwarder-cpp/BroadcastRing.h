@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Broadcast ring header file.
+ *      A ring of packets written by one thread and read by any number of
+ *      readers, each with a cursor of its own. Nothing is taken out of the
+ *      ring, a reader only moves its cursor, so one packet is stored once
+ *      however many readers get it. The writer has to make sure it does not
+ *      overwrite a packet a reader still needs, see TCPComm.
+ */
+
+#ifndef BROADCASTRING_H
+#define BROADCASTRING_H
+
+#include <stdint.h>
+#include "PacketBuffer.h"
+
+class BroadcastRing
+{
+  protected:
+
+    /* a power of two */
+    int size;
+    uint64_t mask;
+
+    Packet *slots;
+
+    // sequence of the next packet to publish, packets before it are in
+    // the ring unless overwritten
+    volatile uint64_t published __attribute__((aligned(CACHE_LINE_SIZE)));
+
+  private:
+    /* disable standard constructor */
+    BroadcastRing();
+
+  public:
+    /* size is rounded up to a power of two */
+    BroadcastRing(int size);
+
+    ~BroadcastRing();
+
+    /* stores packet at the next sequence, only one thread may publish */
+    void publish(const Packet &packet);
+
+    uint64_t getPublished() const;
+
+    /* packet of sequence seq, which has to be published and not yet
+     * overwritten */
+    const Packet & get(uint64_t seq) const;
+
+    int getCapacity() const;
+
+};
+
+#endif /* BROADCASTRING_H */
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the capture log.
+ */
+
+#include "CaptureLog.h"
+#include "Metrics.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+/*----------------------------------------------------------------------------*/
+CaptureLog::CaptureLog(const std::string path)
+{
+  this->path = path;
+  this->fd = -1;
+  this->written = 0;
+  pthread_mutex_init(&lock, NULL);
+}
+/*----------------------------------------------------------------------------*/
+CaptureLog::~CaptureLog()
+{
+  close();
+  pthread_mutex_destroy(&lock);
+}
+/*----------------------------------------------------------------------------*/
+int
+CaptureLog::open()
+{
+  captureHeader_t header;
+  captureRecord_t record;
+  struct stat st;
+  uint64_t pos;
+
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if(fd < 0) {
+    ERROR("Can not open capture log " << path);
+    return -1;
+  }
+  if(fstat(fd, &st) < 0) {
+    ERROR("Can not stat capture log " << path);
+    close();
+    return -1;
+  }
+
+  if(st.st_size == 0) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.headerLen = sizeof(header);
+    if(writeAll(fd, (const char *)&header, sizeof(header)) != sizeof(header)) {
+      ERROR("Can not write capture log " << path);
+      close();
+      return -1;
+    }
+    written = sizeof(header);
+    return 0;
+  }
+
+  if(pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+     memcmp(header.magic, CAPTURE_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != CAPTURE_VERSION) {
+    errno = EINVAL;
+    ERROR("Not a capture log " << path);
+    close();
+    return -1;
+  }
+
+  // a record cut short by a crash is dropped, or the records appended
+  // after it could not be read
+  pos = header.headerLen;
+  while(pos + sizeof(record) <= (uint64_t)st.st_size &&
+        pread(fd, &record, sizeof(record), pos) == sizeof(record) &&
+        pos + CAPTURE_RECORD_SIZE(record.length) <= (uint64_t)st.st_size) {
+    pos += CAPTURE_RECORD_SIZE(record.length);
+  }
+  if(pos != (uint64_t)st.st_size) {
+    DEBUG("CaptureLog::open : dropping a partial record at " << pos);
+    if(ftruncate(fd, pos) < 0) {
+      ERROR("Can not truncate capture log " << path);
+      close();
+      return -1;
+    }
+  }
+  written = pos;
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+CaptureLog::append(const Packet &packet)
+{
+  char buf[CAPTURE_RECORD_SIZE(MAX_PKT_SIZE)];
+  captureRecord_t *record = (captureRecord_t *)buf;
+  int len = packet.getPacketLength();
+  int size = CAPTURE_RECORD_SIZE(len);
+  int ret = 0;
+
+  memset(buf, 0, size);
+  record->timestamp = packet.getTimestamp();
+  if(record->timestamp == 0) {
+    record->timestamp = Metrics::now();
+  }
+  record->length = len;
+  record->type = packet.getPacketType();
+  record->source = packet.getSource();
+  memcpy(buf + sizeof(captureRecord_t), packet.getPayload(), len);
+
+  // one write per record, so records of different sinks do not mix
+  pthread_mutex_lock(&lock);
+  if(fd < 0) {
+    ret = -1;
+  } else if(writeAll(fd, buf, size) != (uint64_t)size) {
+    ERROR("Can not write capture log " << path);
+    ret = -1;
+  } else {
+    written += size;
+  }
+  pthread_mutex_unlock(&lock);
+  return ret;
+}
+/*----------------------------------------------------------------------------*/
+void
+CaptureLog::close()
+{
+  if(fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+/*----------------------------------------------------------------------------*/
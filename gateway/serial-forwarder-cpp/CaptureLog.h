@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the capture log.
+ *      The log is an append-only file of the frames read from the serial
+ *      side, each one stamped with the monotonic clock. Everything is in
+ *      host byte order and aligned to 8 bytes, so a reader can mmap the
+ *      file and walk it in place.
+ *
+ *      file header  : magic (8) | version (2) | header length (2) | 0 (4)
+ *      every record : time in ns (8) | length (2) | type (1) | sink (1) |
+ *                     0 (4) | payload, padded to a multiple of 8 bytes
+ */
+
+#ifndef CAPTURELOG_H
+#define CAPTURELOG_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "BaseComm.h"
+#include "Packet.h"
+
+#define CAPTURE_MAGIC "TIKIRISF"
+#define CAPTURE_VERSION 1
+
+typedef struct captureHeader {
+  char magic[8];
+  uint16_t version;
+  uint16_t headerLen;
+  uint32_t reserved;
+} captureHeader_t;
+
+typedef struct captureRecord {
+  uint64_t timestamp;
+  uint16_t length;
+  uint8_t type;
+  uint8_t source;
+  uint32_t reserved;
+} captureRecord_t;
+
+/* bytes a record with a payload of len bytes takes in the log */
+#define CAPTURE_RECORD_SIZE(len) \
+  (sizeof(captureRecord_t) + (((len) + 7) & ~7))
+
+class CaptureLog : public BaseComm
+{
+  protected:
+
+    std::string path;
+
+    int fd;
+
+    /* bytes written so far, the log ends at a record boundary */
+    uint64_t written;
+
+    /* taken by every sink thread appending a record */
+    pthread_mutex_t lock;
+
+  public:
+
+    CaptureLog(const std::string path);
+
+    ~CaptureLog();
+
+    /* opens the log for appending, writing the file header to a new one */
+    int open();
+
+    /* appends a record of packet stamped with the time it was read */
+    int append(const Packet &packet);
+
+    void close();
+
+};
+
+#endif /* CAPTURELOG_H */
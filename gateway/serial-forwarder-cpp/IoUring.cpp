@@ -0,0 +1,403 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the io_uring wrapper.
+ */
+
+#include "IoUring.h"
+
+#include <sys/mman.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+
+#if IO_URING
+#include <linux/io_uring.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+#endif /* IO_URING */
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+/*----------------------------------------------------------------------------*/
+IoUring::IoUring()
+{
+  ringFD = -1;
+  sqMap = NULL;
+  sqMapLen = 0;
+  sqHead = sqTail = sqMask = sqArray = NULL;
+  sqEntries = 0;
+  sqTailLocal = 0;
+  sqes = NULL;
+  sqesLen = 0;
+  lastSqe = NULL;
+  toSubmit = 0;
+  cqMap = NULL;
+  cqMapLen = 0;
+  cqHead = cqTail = cqMask = NULL;
+  cqes = NULL;
+}
+/*----------------------------------------------------------------------------*/
+IoUring::~IoUring()
+{
+  close();
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::isReady() const
+{
+  return ringFD >= 0;
+}
+/*----------------------------------------------------------------------------*/
+#if IO_URING
+/*----------------------------------------------------------------------------*/
+int
+IoUring::init(unsigned entries)
+{
+  struct io_uring_params p;
+  char *sq, *cq;
+
+  memset(&p, 0, sizeof(p));
+  ringFD = syscall(__NR_io_uring_setup, entries, &p);
+  if(ringFD < 0) {
+    ERROR("IoUring::init : Can not set up io_uring");
+    ringFD = -1;
+    return -1;
+  }
+
+  sqMapLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cqMapLen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  sqesLen = p.sq_entries * sizeof(struct io_uring_sqe);
+  sqMap = mmap(NULL, sqMapLen, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQ_RING);
+  cqMap = mmap(NULL, cqMapLen, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_CQ_RING);
+  sqes = mmap(NULL, sqesLen, PROT_READ | PROT_WRITE,
+              MAP_SHARED | MAP_POPULATE, ringFD, IORING_OFF_SQES);
+  if(sqMap == MAP_FAILED || cqMap == MAP_FAILED || sqes == MAP_FAILED) {
+    ERROR("IoUring::init : Can not map io_uring");
+    sqMap = (sqMap == MAP_FAILED) ? NULL : sqMap;
+    cqMap = (cqMap == MAP_FAILED) ? NULL : cqMap;
+    sqes = (sqes == MAP_FAILED) ? NULL : sqes;
+    close();
+    return -1;
+  }
+
+  sq = (char *)sqMap;
+  sqHead = (unsigned *)(sq + p.sq_off.head);
+  sqTail = (unsigned *)(sq + p.sq_off.tail);
+  sqMask = (unsigned *)(sq + p.sq_off.ring_mask);
+  sqArray = (unsigned *)(sq + p.sq_off.array);
+  sqEntries = p.sq_entries;
+  sqTailLocal = *sqTail;
+  toSubmit = 0;
+  lastSqe = NULL;
+
+  cq = (char *)cqMap;
+  cqHead = (unsigned *)(cq + p.cq_off.head);
+  cqTail = (unsigned *)(cq + p.cq_off.tail);
+  cqMask = (unsigned *)(cq + p.cq_off.ring_mask);
+  cqes = cq + p.cq_off.cqes;
+
+  DEBUG("IoUring::init : " << sqEntries << " entries");
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+IoUring::registerBuffer(void *buf, size_t len)
+{
+  struct iovec iov;
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  if(syscall(__NR_io_uring_register, ringFD, IORING_REGISTER_BUFFERS,
+             &iov, 1) < 0) {
+    DEBUG("IoUring::registerBuffer : Can not register buffer");
+    return -1;
+  }
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void *
+IoUring::getSqe()
+{
+  struct io_uring_sqe *sqe;
+  unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+  unsigned index;
+
+  if(ringFD < 0 || sqTailLocal - head >= sqEntries) {
+    return NULL;
+  }
+  index = sqTailLocal & *sqMask;
+  sqe = (struct io_uring_sqe *)sqes + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqArray[index] = index;
+  sqTailLocal++;
+  toSubmit++;
+  lastSqe = sqe;
+  return sqe;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepRead(int fd, void *buf, unsigned len, int bufIndex,
+                  uint64_t userData)
+{
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)getSqe();
+
+  if(sqe == NULL) {
+    return false;
+  }
+  sqe->opcode = (bufIndex >= 0) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)buf;
+  sqe->len = len;
+  // -1 reads at the current position, the only one a tty has
+  sqe->off = (uint64_t)-1;
+  sqe->buf_index = (bufIndex >= 0) ? bufIndex : 0;
+  sqe->user_data = userData;
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepSendmsg(int fd, const struct msghdr *msg, int flags,
+                     uint64_t userData)
+{
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)getSqe();
+
+  if(sqe == NULL) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = fd;
+  sqe->addr = (uint64_t)(uintptr_t)msg;
+  sqe->len = 1;
+  sqe->msg_flags = flags;
+  sqe->user_data = userData;
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepPollIn(int fd, uint64_t userData)
+{
+  struct io_uring_sqe *sqe = (struct io_uring_sqe *)getSqe();
+
+  if(sqe == NULL) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll_events = POLLIN;
+  sqe->user_data = userData;
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepLinkTimeout(unsigned int mSecs, uint64_t userData)
+{
+  struct io_uring_sqe *prev = (struct io_uring_sqe *)lastSqe;
+  struct io_uring_sqe *sqe;
+
+  if(prev == NULL) {
+    return false;
+  }
+  sqe = (struct io_uring_sqe *)getSqe();
+  if(sqe == NULL) {
+    return false;
+  }
+  timeout[0] = mSecs / 1000;
+  timeout[1] = (int64_t)(mSecs % 1000) * 1000000;
+  prev->flags |= IOSQE_IO_LINK;
+  sqe->opcode = IORING_OP_LINK_TIMEOUT;
+  sqe->fd = -1;
+  sqe->addr = (uint64_t)(uintptr_t)timeout;
+  sqe->len = 1;
+  sqe->user_data = userData;
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+int
+IoUring::submitAndWait(unsigned waitNr)
+{
+  int ret;
+  unsigned submitted = 0;
+
+  __atomic_store_n(sqTail, sqTailLocal, __ATOMIC_RELEASE);
+  lastSqe = NULL;
+  while(true) {
+    ret = syscall(__NR_io_uring_enter, ringFD, toSubmit, waitNr,
+                  (waitNr > 0) ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if(ret >= 0) {
+      toSubmit -= ret;
+      submitted += ret;
+      return submitted;
+    }
+    if(errno != EINTR) {
+      DEBUG("IoUring::submitAndWait : io_uring_enter failed");
+      return -1;
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::popCompletion(uint64_t &userData, int &res)
+{
+  struct io_uring_cqe *cqe;
+  unsigned head;
+
+  if(ringFD < 0) {
+    return false;
+  }
+  head = *cqHead;
+  if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  cqe = (struct io_uring_cqe *)cqes + (head & *cqMask);
+  userData = cqe->user_data;
+  res = cqe->res;
+  __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+#else /* IO_URING */
+/*----------------------------------------------------------------------------*/
+int
+IoUring::init(unsigned entries)
+{
+  errno = ENOSYS;
+  return -1;
+}
+/*----------------------------------------------------------------------------*/
+int
+IoUring::registerBuffer(void *buf, size_t len)
+{
+  errno = ENOSYS;
+  return -1;
+}
+/*----------------------------------------------------------------------------*/
+void *
+IoUring::getSqe()
+{
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepRead(int fd, void *buf, unsigned len, int bufIndex,
+                  uint64_t userData)
+{
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepSendmsg(int fd, const struct msghdr *msg, int flags,
+                     uint64_t userData)
+{
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepPollIn(int fd, uint64_t userData)
+{
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::prepLinkTimeout(unsigned int mSecs, uint64_t userData)
+{
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+int
+IoUring::submitAndWait(unsigned waitNr)
+{
+  errno = ENOSYS;
+  return -1;
+}
+/*----------------------------------------------------------------------------*/
+bool
+IoUring::popCompletion(uint64_t &userData, int &res)
+{
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+#endif /* IO_URING */
+/*----------------------------------------------------------------------------*/
+void
+IoUring::close()
+{
+  if(sqes != NULL) {
+    munmap(sqes, sqesLen);
+    sqes = NULL;
+  }
+  if(cqMap != NULL) {
+    munmap(cqMap, cqMapLen);
+    cqMap = NULL;
+  }
+  if(sqMap != NULL) {
+    munmap(sqMap, sqMapLen);
+    sqMap = NULL;
+  }
+  if(ringFD >= 0) {
+    ::close(ringFD);
+    ringFD = -1;
+  }
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+
+/* \file
+ *      Header file of the io_uring wrapper.
+ *      A ring of the kernel's io_uring interface, set up with the raw
+ *      system calls so that nothing beyond the kernel headers is needed.
+ *      Only the few operations the forwarder submits are wrapped. A ring
+ *      is used by one thread at a time.
+ *      Built without io_uring, CONF_IO_URING set to 0, init() fails and
+ *      the callers keep to their blocking or epoll path.
+ */
+
+#ifndef IOURING_H
+#define IOURING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+#ifdef CONF_IO_URING
+#define IO_URING CONF_IO_URING
+#else
+#define IO_URING 1
+#endif
+
+class IoUring
+{
+  protected:
+
+    int ringFD;
+
+    /* submission queue, entries are filled at sqTailLocal and handed to
+     * the kernel on submitAndWait() */
+    void *sqMap;
+    size_t sqMapLen;
+    unsigned *sqHead;
+    unsigned *sqTail;
+    unsigned *sqMask;
+    unsigned *sqArray;
+    unsigned sqEntries;
+    unsigned sqTailLocal;
+    void *sqes;
+    size_t sqesLen;
+
+    /* entry filled last, a link timeout is linked to it */
+    void *lastSqe;
+
+    /* entries filled since the last submit */
+    unsigned toSubmit;
+
+    /* completion queue */
+    void *cqMap;
+    size_t cqMapLen;
+    unsigned *cqHead;
+    unsigned *cqTail;
+    unsigned *cqMask;
+    void *cqes;
+
+    /* the struct __kernel_timespec of the link timeout, there is one of
+     * them in flight at a time */
+    int64_t timeout[2];
+
+    /* a cleared submission queue entry, NULL if the queue is full */
+    void *getSqe();
+
+  public:
+
+    IoUring();
+
+    ~IoUring();
+
+    /* sets up a ring of entries submission queue entries */
+    int init(unsigned entries);
+
+    bool isReady() const;
+
+    /* registers buf as fixed buffer 0, for reads with bufIndex 0 */
+    int registerBuffer(void *buf, size_t len);
+
+    /* reads up to len bytes of fd into buf, buf being the fixed buffer
+     * bufIndex or any memory if bufIndex is -1 */
+    bool prepRead(int fd, void *buf, unsigned len, int bufIndex,
+                  uint64_t userData);
+
+    /* sendmsg() on fd, msg has to stay valid until it completes */
+    bool prepSendmsg(int fd, const struct msghdr *msg, int flags,
+                     uint64_t userData);
+
+    /* completes once fd is readable */
+    bool prepPollIn(int fd, uint64_t userData);
+
+    /* cancels the entry filled last if it has not completed in mSecs */
+    bool prepLinkTimeout(unsigned int mSecs, uint64_t userData);
+
+    /* submits what was filled and waits for waitNr completions, returns
+     * the number of entries submitted or -1 */
+    int submitAndWait(unsigned waitNr);
+
+    /* takes the oldest completion, false if there is none */
+    bool popCompletion(uint64_t &userData, int &res);
+
+    void close();
+
+};
+
+#endif /* IOURING_H */
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the forwarder metrics.
+ */
+
+#include "Metrics.h"
+
+#include <time.h>
+#include <cstring>
+
+#define SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+
+const int Histogram::percentiles[HISTOGRAM_PERCENTILES] =
+  {500, 750, 900, 990, 999};
+
+static const char *counterNames[METRIC_COUNTERS] = {
+  "serial_frames_in",
+  "serial_bytes_in",
+  "serial_frames_out",
+  "serial_bytes_out",
+  "slip_errors",
+  "serial_duplicates",
+  "read_buffer_drops",
+  "debug_drops",
+  "write_buffer_drops",
+  "client_frames_in",
+  "client_bytes_in",
+  "client_frames_out",
+  "client_bytes_out",
+  "client_drops",
+  "client_disconnects",
+  "clients_accepted",
+  "queue_grows"
+};
+
+static const char *histogramNames[METRIC_HISTOGRAMS] = {
+  "serial_to_client_ns",
+  "client_to_serial_ns",
+  "serial_ingest_ns",
+  "serial_handoff_ns"
+};
+
+/*----------------------------------------------------------------------------*/
+Histogram::Histogram()
+{
+  memset(buckets, 0, sizeof(buckets));
+  count = 0;
+  sum = 0;
+  max = 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+Histogram::bucketOf(uint64_t value)
+{
+  int e;
+
+  if(value < SUB_BUCKETS) {
+    return value;
+  }
+  e = 63 - __builtin_clzll(value);
+  if(e >= HISTOGRAM_MAX_EXP) {
+    return HISTOGRAM_BUCKETS - 1;
+  }
+  return ((e - HISTOGRAM_SUB_BITS + 1) << HISTOGRAM_SUB_BITS) +
+         ((value >> (e - HISTOGRAM_SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+/*----------------------------------------------------------------------------*/
+uint64_t
+Histogram::bucketValue(int bucket)
+{
+  int shift;
+
+  if(bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  shift = (bucket >> HISTOGRAM_SUB_BITS) - 1;
+  return (((uint64_t)(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) + 1)
+          << shift) - 1;
+}
+/*----------------------------------------------------------------------------*/
+void
+Histogram::record(uint64_t value)
+{
+  uint64_t old;
+
+  __atomic_add_fetch(&buckets[bucketOf(value)], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&count, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&sum, value, __ATOMIC_RELAXED);
+  old = __atomic_load_n(&max, __ATOMIC_RELAXED);
+  while(value > old &&
+        !__atomic_compare_exchange_n(&max, &old, value, true,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+/*----------------------------------------------------------------------------*/
+void
+Histogram::summarize(histogramSummary_t &summary) const
+{
+  uint64_t counts[HISTOGRAM_BUCKETS];
+  uint64_t total = 0, seen = 0, rank;
+  int i, p = 0;
+
+  // the buckets may move on while they are copied, the summary is of the
+  // copy
+  for(i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    counts[i] = __atomic_load_n(&buckets[i], __ATOMIC_RELAXED);
+    total += counts[i];
+  }
+  summary.count = total;
+  summary.sum = __atomic_load_n(&sum, __ATOMIC_RELAXED);
+  summary.max = __atomic_load_n(&max, __ATOMIC_RELAXED);
+  memset(summary.percentile, 0, sizeof(summary.percentile));
+  if(total == 0) {
+    return;
+  }
+
+  for(i = 0; i < HISTOGRAM_BUCKETS && p < HISTOGRAM_PERCENTILES; i++) {
+    seen += counts[i];
+    while(p < HISTOGRAM_PERCENTILES) {
+      rank = (total * percentiles[p] + 999) / 1000;
+      if(seen < rank) {
+        break;
+      }
+      summary.percentile[p] = bucketValue(i);
+      if(summary.percentile[p] > summary.max) {
+        summary.percentile[p] = summary.max;
+      }
+      p++;
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+Metrics::Metrics()
+{
+  memset(counters, 0, sizeof(counters));
+}
+/*----------------------------------------------------------------------------*/
+Metrics &
+Metrics::instance()
+{
+  static Metrics metrics;
+  return metrics;
+}
+/*----------------------------------------------------------------------------*/
+uint64_t
+Metrics::now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*----------------------------------------------------------------------------*/
+int64_t
+Metrics::realtimeOffset()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec - now());
+}
+/*----------------------------------------------------------------------------*/
+void
+Metrics::recordSince(int histogram, uint64_t stamp, uint64_t now)
+{
+  if(stamp != 0 && now >= stamp) {
+    histograms[histogram].record(now - stamp);
+  }
+}
+/*----------------------------------------------------------------------------*/
+const Histogram &
+Metrics::getHistogram(int histogram) const
+{
+  return histograms[histogram];
+}
+/*----------------------------------------------------------------------------*/
+const char *
+Metrics::counterName(int counter)
+{
+  return counterNames[counter];
+}
+/*----------------------------------------------------------------------------*/
+const char *
+Metrics::histogramName(int histogram)
+{
+  return histogramNames[histogram];
+}
+/*----------------------------------------------------------------------------*/
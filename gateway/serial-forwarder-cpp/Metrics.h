@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the forwarder metrics.
+ *      Counters and latency histograms are updated with atomic adds, each
+ *      on its own cache line, so the threads of the packet path never wait
+ *      for each other or for the thread reading them.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <string>
+
+#include "PacketBuffer.h"
+
+/* counters */
+enum {
+  METRIC_SERIAL_FRAMES_IN = 0,  // frames read from the sinks
+  METRIC_SERIAL_BYTES_IN,       // bytes of those frames, after decoding
+  METRIC_SERIAL_FRAMES_OUT,     // frames written to the sinks
+  METRIC_SERIAL_BYTES_OUT,
+  METRIC_SLIP_ERRORS,           // bad escapes and frames too long
+  METRIC_SERIAL_DUPLICATES,     // results dropped as read by another sink
+  METRIC_READ_BUFFER_DROPS,     // frames lost because readBuffer was full
+  METRIC_DEBUG_DROPS,           // debug frames lost the same way
+  METRIC_WRITE_BUFFER_DROPS,    // packets lost because writeBuffer was full
+  METRIC_CLIENT_FRAMES_IN,      // packets received from clients
+  METRIC_CLIENT_BYTES_IN,
+  METRIC_CLIENT_FRAMES_OUT,     // packets sent to clients
+  METRIC_CLIENT_BYTES_OUT,
+  METRIC_CLIENT_DROPS,          // packets dropped by client queue policies
+  METRIC_CLIENT_DISCONNECTS,    // clients closed by the DISCONNECT policy
+  METRIC_CLIENTS_ACCEPTED,
+  METRIC_QUEUE_GROWS,           // buffers grown by QueueTuner
+  METRIC_COUNTERS
+};
+
+/* latency histograms */
+enum {
+  METRIC_SERIAL_TO_CLIENT = 0,  // read from a sink until sent to a client
+  METRIC_CLIENT_TO_SERIAL,      // received from a client until written
+  METRIC_SERIAL_INGEST,         // read from a sink until put in readBuffer
+  METRIC_SERIAL_HANDOFF,        // read from a sink until taken from readBuffer
+  METRIC_HISTOGRAMS
+};
+
+/*
+ * Values below 2^HISTOGRAM_SUB_BITS nanoseconds have a bucket each, every
+ * power of two above is split into 2^HISTOGRAM_SUB_BITS buckets. Values
+ * of 2^HISTOGRAM_MAX_EXP ns and more land in the last bucket.
+ */
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_MAX_EXP  40
+#define HISTOGRAM_BUCKETS  ((HISTOGRAM_MAX_EXP - HISTOGRAM_SUB_BITS + 1) << \
+                            HISTOGRAM_SUB_BITS)
+
+/* percentiles a histogram is summarized with, in tenths of a percent */
+#define HISTOGRAM_PERCENTILES 5
+
+typedef struct histogramSummary {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t percentile[HISTOGRAM_PERCENTILES];
+} histogramSummary_t;
+
+/*
+ * What the stats server shows of a connected client. The event thread
+ * fills a slot and marks it in use by setting fd, the counters are then
+ * updated by the event thread and, for a client with a sender thread, by
+ * that thread too. The stats server reads them at any time, so the
+ * counters are only accessed through the CLIENT_METRIC_* macros.
+ */
+typedef struct clientMetrics {
+  volatile int fd;
+  int port;
+  int mode;
+  int policy;
+  int version;
+  /* packets queued and dropped so far, longest the queue has been */
+  uint32_t queued;
+  uint32_t dropped;
+  uint32_t highWater;
+  /* frames in the queue now */
+  uint32_t length;
+  uint64_t bytesOut;
+  /* ingress time of the oldest frame in the queue, 0 if there is none */
+  uint64_t oldestStamp;
+} clientMetrics_t;
+
+#define CLIENT_METRIC_GET(field) __atomic_load_n(&(field), __ATOMIC_RELAXED)
+#define CLIENT_METRIC_SET(field, value) \
+  __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+#define CLIENT_METRIC_ADD(field, value) \
+  __atomic_fetch_add(&(field), (value), __ATOMIC_RELAXED)
+/* highWater has a single writer at a time, the event thread or the sender */
+#define CLIENT_METRIC_MAX(field, value) \
+  do { \
+    if((value) > CLIENT_METRIC_GET(field)) { \
+      CLIENT_METRIC_SET(field, value); \
+    } \
+  } while(0)
+
+class Histogram
+{
+  protected:
+
+    uint64_t buckets[HISTOGRAM_BUCKETS];
+
+    uint64_t count __attribute__((aligned(CACHE_LINE_SIZE)));
+    uint64_t sum;
+    uint64_t max;
+
+    static int bucketOf(uint64_t value);
+
+    /* highest value of a bucket */
+    static uint64_t bucketValue(int bucket);
+
+  public:
+
+    Histogram();
+
+    void record(uint64_t value);
+
+    void summarize(histogramSummary_t &summary) const;
+
+    /* the percentiles summarize() reports, in tenths of a percent */
+    static const int percentiles[HISTOGRAM_PERCENTILES];
+
+};
+
+class Metrics
+{
+  protected:
+
+    typedef struct counter {
+      uint64_t value;
+    } __attribute__((aligned(CACHE_LINE_SIZE))) counter_t;
+
+    counter_t counters[METRIC_COUNTERS];
+
+    Histogram histograms[METRIC_HISTOGRAMS];
+
+  public:
+
+    Metrics();
+
+    /* the metrics of the forwarder */
+    static Metrics &instance();
+
+    /* CLOCK_MONOTONIC in nanoseconds, packets are stamped with it */
+    static uint64_t now();
+
+    /* CLOCK_REALTIME minus CLOCK_MONOTONIC, in nanoseconds */
+    static int64_t realtimeOffset();
+
+    void add(int counter, uint64_t n = 1)
+    {
+      __atomic_add_fetch(&counters[counter].value, n, __ATOMIC_RELAXED);
+    }
+
+    uint64_t get(int counter) const
+    {
+      return __atomic_load_n(&counters[counter].value, __ATOMIC_RELAXED);
+    }
+
+    /* records the time since stamp, unless stamp is 0 */
+    void recordSince(int histogram, uint64_t stamp, uint64_t now);
+
+    const Histogram &getHistogram(int histogram) const;
+
+    static const char *counterName(int counter);
+
+    static const char *histogramName(int histogram);
+
+};
+
+#endif /* METRICS_H */
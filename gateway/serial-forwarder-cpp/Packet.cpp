@@ -38,6 +38,7 @@
  */
 
 #include "Packet.h"
+#include "PacketPool.h"
 #include <cstring>
 #include <cstdlib>
 #include <cstdio>
@@ -49,25 +50,96 @@ using namespace std;
 /*----------------------------------------------------------------------------*/
 Packet::Packet()
 {
+  data = NULL;
 }
 /*----------------------------------------------------------------------------*/
 Packet::Packet(const Packet &packet)
 {
-  this->bufLen = packet.bufLen;
-  setPayload(packet.getPayload(), packet.bufLen, packet.getPacketType());
+  data = packet.data;
+  if(data != NULL) {
+    __atomic_add_fetch(&data->refCount, 1, __ATOMIC_RELAXED);
+  }
+}
+/*----------------------------------------------------------------------------*/
+Packet &
+Packet::operator=(const Packet &packet)
+{
+  // take the new reference first, packet may be this one
+  if(packet.data != NULL) {
+    __atomic_add_fetch(&packet.data->refCount, 1, __ATOMIC_RELAXED);
+  }
+  release();
+  data = packet.data;
+  return *this;
+}
+/*----------------------------------------------------------------------------*/
+void
+Packet::swap(Packet &packet)
+{
+  struct packetData *tmp = data;
+  data = packet.data;
+  packet.data = tmp;
+}
+/*----------------------------------------------------------------------------*/
+void
+Packet::clear()
+{
+  release();
+}
+/*----------------------------------------------------------------------------*/
+void
+Packet::release()
+{
+  if(data != NULL &&
+     __atomic_sub_fetch(&data->refCount, 1, __ATOMIC_ACQ_REL) == 0) {
+    PacketPool::instance().release(data);
+  }
+  data = NULL;
+}
+/*----------------------------------------------------------------------------*/
+bool
+Packet::makeWritable()
+{
+  // the payload of other copies must not change under them
+  if(data != NULL && __atomic_load_n(&data->refCount, __ATOMIC_ACQUIRE) == 1) {
+    return true;
+  }
+  release();
+  data = PacketPool::instance().acquire();
+  return data != NULL;
 }
-
 /*----------------------------------------------------------------------------*/
 const char *
 Packet::getPayload() const
 {
-  return buffer;
+  return (data != NULL) ? data->buffer : "";
 }
 /*----------------------------------------------------------------------------*/
 const int
 Packet::getPacketType() const
 {
-  return type;
+  return (data != NULL) ? data->type : PKT_TYPE_DATA;
+}
+/*----------------------------------------------------------------------------*/
+const int
+Packet::getSource() const
+{
+  return (data != NULL) ? data->source : PKT_SOURCE_ANY;
+}
+/*----------------------------------------------------------------------------*/
+const int
+Packet::getLane() const
+{
+  if(data == NULL) {
+    return PKT_LANE_DATA;
+  }
+  if(data->type == PKT_TYPE_DEBUG) {
+    return PKT_LANE_DEBUG;
+  }
+  if(data->bufLen > 0 && data->buffer[0] == MSG_QREQUEST) {
+    return PKT_LANE_CONTROL;
+  }
+  return PKT_LANE_DATA;
 }
 /*----------------------------------------------------------------------------*/
 const int
@@ -77,24 +149,38 @@ Packet::getMaxPacketSize() const
 }
 /*----------------------------------------------------------------------------*/
 bool
-Packet::setPayload(const char *srcBuffer, int len, int type)
+Packet::setPayload(const char *srcBuffer, int len, int type, int source)
 {
-  int ret;
-
-  if(this->maxPacketLength < len) {
+  if(this->maxPacketLength < len || !makeWritable()) {
     return false;
   }
 
-  memcpy(this->buffer, srcBuffer, len);
-  this->bufLen = len;
-  this->type = type;
+  memcpy(data->buffer, srcBuffer, len);
+  data->bufLen = len;
+  data->type = type;
+  data->source = source;
+  data->stamp = 0;
   return true;
 }
 /*----------------------------------------------------------------------------*/
+uint64_t
+Packet::getTimestamp() const
+{
+  return (data != NULL) ? data->stamp : 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+Packet::setTimestamp(uint64_t stamp)
+{
+  if(data != NULL) {
+    data->stamp = stamp;
+  }
+}
+/*----------------------------------------------------------------------------*/
 const int
 Packet::getPacketLength() const
 {
-  return this->bufLen;
+  return (data != NULL) ? data->bufLen : 0;
 }
 /*----------------------------------------------------------------------------*/
 void
@@ -104,10 +190,15 @@ Packet::fillDummyData()
 
   srand(time(NULL));
 
-  bufLen = get_random(Packet::getMaxPacketSize());
+  if(!makeWritable()) {
+    return;
+  }
+  data->bufLen = get_random(Packet::getMaxPacketSize());
+  data->type = PKT_TYPE_DATA;
+  data->source = PKT_SOURCE_ANY;
 
-  for(i = 0; i<bufLen; i++) {
-    buffer[i] = get_random(254);
+  for(i = 0; i<data->bufLen; i++) {
+    data->buffer[i] = get_random(254);
   }
 
 }
@@ -118,6 +209,8 @@ Packet::printPacket()
 
   int i, k, printed, left, end;
   int nrows;
+  int bufLen = getPacketLength();
+  const char *buffer = getPayload();
 
   for(i=0; i< 2 * ROW_COUNT; i++) {
     printf("=");
@@ -141,5 +234,5 @@ Packet::printPacket()
 /*----------------------------------------------------------------------------*/
 Packet::~Packet()
 {
-  this->bufLen = 0;
+  release();
 }
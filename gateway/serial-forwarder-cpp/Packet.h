@@ -35,11 +35,16 @@
 
 /* \file
  *      Packet header file.
+ *      A packet refers to a block of the packet pool holding its payload.
+ *      Copies of a packet share the block, so passing a packet around or
+ *      handing it to many clients does not copy the payload.
  */
 
 #ifndef PACKET_H
 #define PACKET_H
 
+#include <stdint.h>
+
 #ifdef CONF_MAX_PKT_SIZE
 #define MAX_PKT_SIZE CONF_MAX_PKT_SIZE
 #else
@@ -49,6 +54,35 @@
 #define PKT_TYPE_DATA 1
 #define PKT_TYPE_DEBUG 2
 
+/* Offsets in the query messages data packets carry, the first byte is the
+ * message type. See node/qprocessor/messages.h */
+#define MSG_QREQUEST        1
+#define MSG_QREPLY          2
+#define QREQUEST_QID        1
+#define QREQUEST_QROOT      3
+#define QREQUEST_HEADER_LEN 5
+#define QREPLY_QID          1
+#define QREPLY_EPOCH        4
+#define QREPLY_NODEADDR     6
+#define QREPLY_HEADER_LEN   8
+
+/* Source of a packet that is not tied to one sink. Sinks are numbered from
+ * 1 in the order they are given. */
+#define PKT_SOURCE_ANY 0
+
+/* First byte of a sink group address used as the root of a query, the
+ * second is the group. See node/qprocessor/messages.h */
+#define SINK_GROUP_PREFIX 0xFE
+
+/* Traffic classes. A packet buffer keeps a lane for each and hands out
+ * packets of the lower numbered lanes first. */
+#define PKT_LANE_CONTROL    0   /* query requests on their way to the motes */
+#define PKT_LANE_DATA       1   /* query results and any other data */
+#define PKT_LANE_DEBUG      2   /* debug output of the motes */
+#define PKT_LANES           3
+
+struct packetData;
+
 class Packet
 {
   protected:
@@ -56,27 +90,52 @@ class Packet
     /* Maximum packet size in bytes */
     const static int maxPacketLength = MAX_PKT_SIZE;
 
-    char buffer[maxPacketLength + 1];
+    /* the shared payload, NULL for an empty packet */
+    struct packetData *data;
 
-    int bufLen;
+    /* drop the reference to the payload */
+    void release();
 
-    int type;
+    /* make data a block that no other packet refers to */
+    bool makeWritable();
 
   public:
 
     Packet();
 
-    /* copy constructor */
+    /* copy constructor, shares the payload */
     Packet(const Packet &packet);
 
+    /* shares the payload of packet */
+    Packet & operator=(const Packet &packet);
+
+    /* exchange payloads with packet */
+    void swap(Packet &packet);
+
+    /* make the packet empty */
+    void clear();
+
     /* returns buffer. */
     const char * getPayload() const;
 
     /* returns packet type */
     const int getPacketType() const;
 
+    /* returns the sink the packet is from or for */
+    const int getSource() const;
+
+    /* returns the traffic class of the packet, one of PKT_LANE_* */
+    const int getLane() const;
+
     /* set packet's payload */
-    bool setPayload(const char *srcBuffer, int len, int type=PKT_TYPE_DATA);
+    bool setPayload(const char *srcBuffer, int len, int type=PKT_TYPE_DATA,
+                    int source=PKT_SOURCE_ANY);
+
+    /* time the packet entered the forwarder, 0 if it is not stamped */
+    uint64_t getTimestamp() const;
+
+    /* stamps the packet, before it is handed to other threads */
+    void setTimestamp(uint64_t stamp);
 
     /* returns buffer length. */
     const int getPacketLength() const;
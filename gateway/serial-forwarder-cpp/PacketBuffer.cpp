@@ -35,13 +35,29 @@
 
 /* \file
  *      Packet buffer source file.
- *      This module is taken from TinyOS's C++ implementation of serial forwarder.
+ *      The ring follows Dmitry Vyukov's bounded MPMC queue. Every slot
+ *      carries a sequence number telling whether it is ready for the
+ *      enqueue or the dequeue of a given position, so producers and the
+ *      consumer only contend on the compare-and-swap of tail and head.
+ *      Every lane is such a ring.
+ *      Growing changes the modulus of the positions. grow() freezes head
+ *      and tail of every lane by setting their top bit, which makes the
+ *      compare-and-swap of the others fail, waits for the operations
+ *      that got their position before, and puts the packets into the
+ *      larger ring at positions past all earlier ones.
  */
 
 #include "PacketBuffer.h"
+#include "PacketPool.h"
 
-#include "pthread.h"
-#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <climits>
+#include <new>
+#include <vector>
 
 //#define DEBUG_EABLE 0
 //#define ERROR_EABLE 0
@@ -62,131 +78,489 @@
 #define ERROR(message)
 #endif
 
+#define LOAD(var)         __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#define STORE(var, val)   __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#define CAS(var, exp, val) __atomic_compare_exchange_n(&(var), &(exp), (val), \
+                                 true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define FENCE()           __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/* set in head and tail of a lane while grow() works on it */
+#define FROZEN (1ULL << 63)
+
+/* bytes slots are given, whole pages */
+static size_t
+slotBytes(size_t bytes)
+{
+  size_t page = sysconf(_SC_PAGESIZE);
+
+  return (bytes + page - 1) / page * page;
+}
+
 /*----------------------------------------------------------------------------*/
-PacketBuffer::PacketBuffer(int maxPackets)
+/* undoes wait() if the waiting thread is canceled */
+void
+PacketBuffer::waitCleanup(void *arg)
 {
-  pthread_mutex_init(&buffer.lock, NULL);
-  pthread_cond_init(&buffer.notempty, NULL);
-  pthread_cond_init(&buffer.notfull, NULL);
+  waitQueue_t *queue = (waitQueue_t *)arg;
+
+  __atomic_sub_fetch(&queue->waiters, 1, __ATOMIC_SEQ_CST);
+  pthread_mutex_unlock(&queue->lock);
+}
+/*----------------------------------------------------------------------------*/
+void
+PacketBuffer::init(int maxPackets, int maxCapacity)
+{
+  int l;
+  void *mem;
+
+  if(maxPackets < 1) {
+    maxPackets = 1;
+  }
+  this->size = maxPackets;
+  this->rejects = 0;
+  if(maxCapacity > maxPackets) {
+    maxPackets = maxCapacity;
+  }
   this->maxPackets = maxPackets;
+
+  for(l = 0; l < PKT_LANES; l++) {
+    // room for every slot the lane can grow to, commitSlots() backs the
+    // ones in use
+    mem = mmap(NULL, slotBytes(sizeof(slot_t) * maxPackets), PROT_NONE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(mem == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    lanes[l].slots = (slot_t *)mem;
+    if(!commitSlots(lanes[l], 0, size)) {
+      throw std::bad_alloc();
+    }
+    lanes[l].head = 0;
+    lanes[l].tail = 0;
+  }
+  served = 0;
+
+  pthread_mutex_init(&growLock, NULL);
+  pthread_mutex_init(&notempty.lock, NULL);
+  pthread_cond_init(&notempty.cond, NULL);
+  notempty.waiters = 0;
+  pthread_mutex_init(&notfull.lock, NULL);
+  pthread_cond_init(&notfull.cond, NULL);
+  notfull.waiters = 0;
+  notifyFD = -1;
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketBuffer::commitSlots(lane_t &lane, int from, int to)
+{
+  int i;
+
+  if(mprotect(lane.slots, slotBytes(sizeof(slot_t) * to),
+              PROT_READ | PROT_WRITE) < 0) {
+    return false;
+  }
+  for(i = from; i < to; i++) {
+    new (&lane.slots[i]) slot_t();
+    lane.slots[i].seq = i;
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+PacketBuffer::PacketBuffer(int maxPackets)
+{
   this->name = "";
+  init(maxPackets, maxPackets);
 }
 /*----------------------------------------------------------------------------*/
 PacketBuffer::PacketBuffer(std::string name, int maxPackets)
 {
-  pthread_mutex_init(&buffer.lock, NULL);
-  pthread_cond_init(&buffer.notempty, NULL);
-  pthread_cond_init(&buffer.notfull, NULL);
-  this->maxPackets = maxPackets;
   this->name = name;
+  init(maxPackets, maxPackets);
+}
+/*----------------------------------------------------------------------------*/
+PacketBuffer::PacketBuffer(std::string name, int maxPackets, int maxCapacity)
+{
+  this->name = name;
+  init(maxPackets, maxCapacity);
 }
 
 /*----------------------------------------------------------------------------*/
 PacketBuffer::~PacketBuffer()
 {
-  pthread_cond_destroy(&buffer.notempty);
-  pthread_cond_destroy(&buffer.notfull);
-  pthread_mutex_destroy(&buffer.lock);
+  int i, l;
+
+  for(l = 0; l < PKT_LANES; l++) {
+    for(i = 0; i < size; i++) {
+      lanes[l].slots[i].~slot_t();
+    }
+    munmap(lanes[l].slots, slotBytes(sizeof(slot_t) * maxPackets));
+  }
+
+  pthread_mutex_destroy(&growLock);
+  pthread_cond_destroy(&notempty.cond);
+  pthread_mutex_destroy(&notempty.lock);
+  pthread_cond_destroy(&notfull.cond);
+  pthread_mutex_destroy(&notfull.lock);
+}
+/*----------------------------------------------------------------------------*/
+/* sleeps on queue until ready() is true */
+void
+PacketBuffer::wait(waitQueue_t &queue, bool (PacketBuffer::*ready)(int),
+                   int lane)
+{
+  pthread_cleanup_push(waitCleanup, (void *)&queue);
+  pthread_mutex_lock(&queue.lock);
+  __atomic_add_fetch(&queue.waiters, 1, __ATOMIC_SEQ_CST);
+  // pairs with the fence in wakeup(). Either the other side sees us
+  // waiting, or we see what it has done.
+  FENCE();
+  while(!(this->*ready)(lane)) {
+    pthread_cond_wait(&queue.cond, &queue.lock);
+  }
+  pthread_cleanup_pop(1);
 }
+/*----------------------------------------------------------------------------*/
+void
+PacketBuffer::wakeup(waitQueue_t &queue)
+{
+  FENCE();
+  if(__atomic_load_n(&queue.waiters, __ATOMIC_RELAXED) > 0) {
+    pthread_mutex_lock(&queue.lock);
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.lock);
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketBuffer::canDequeue(int lane)
+{
+  uint64_t pos;
+  int l;
 
-// clears the buffer
+  for(l = 0; l < PKT_LANES; l++) {
+    if(lane != PACKETBUFFER_ANY_LANE && l != lane) {
+      continue;
+    }
+    pos = LOAD(lanes[l].head);
+    if(pos & FROZEN) {
+      continue;
+    }
+    if(LOAD(lanes[l].slots[pos % LOAD(size)].seq) == pos + 1) {
+      return true;
+    }
+  }
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketBuffer::canEnqueue(int lane)
+{
+  uint64_t pos = LOAD(lanes[lane].tail);
+
+  if(pos & FROZEN) {
+    return false;
+  }
+  return LOAD(lanes[lane].slots[pos % LOAD(size)].seq) == pos;
+}
+/*----------------------------------------------------------------------------*/
+// drops all packets in the buffer
 void
 PacketBuffer::clear() {
-  pthread_testcancel();
-  pthread_mutex_lock(&buffer.lock);
-  // clear
-  buffer.container.clear();
-  DEBUG("PacketBuffer::clear : cleared buffer and signal <notfull>")
-  pthread_cond_signal(&buffer.notfull);
-  pthread_mutex_unlock(&buffer.lock);
+  Packet packet;
+  while(tryDequeue(packet));
+  DEBUG("PacketBuffer::clear : cleared buffer")
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketBuffer::tryDequeueLane(lane_t &lane, Packet &pPacket)
+{
+  slot_t *slot;
+  uint64_t pos;
+  int64_t diff;
+  int n;
+
+  while(true) {
+    // size after head, grow() publishes it before it thaws head
+    pos = LOAD(lane.head);
+    if(pos & FROZEN) {
+      return false;
+    }
+    n = LOAD(size);
+    slot = &lane.slots[pos % n];
+    diff = (int64_t)(LOAD(slot->seq) - (pos + 1));
+    if(diff == 0) {
+      if(CAS(lane.head, pos, pos + 1)) {
+        break;
+      }
+    } else if(diff < 0) {
+      return false;
+    }
+  }
+
+  // hand the reference over, the slot is left empty
+  pPacket.clear();
+  pPacket.swap(slot->packet);
+  STORE(slot->seq, pos + n);
+  wakeup(notfull);
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketBuffer::tryDequeue(Packet &pPacket)
+{
+  bool lowFirst;
+  int l;
+
+  // with several consumers the count is only roughly kept, which does
+  // not matter for sharing out the turns
+  lowFirst = PACKETBUFFER_LANE_WEIGHT > 0 &&
+             __atomic_load_n(&served, __ATOMIC_RELAXED) >= PACKETBUFFER_LANE_WEIGHT;
+
+  for(l = 0; l < PKT_LANES; l++) {
+    if(tryDequeueLane(lanes[lowFirst ? PKT_LANES - 1 - l : l], pPacket)) {
+      if(lowFirst) {
+        __atomic_store_n(&served, 0, __ATOMIC_RELAXED);
+      } else {
+        __atomic_add_fetch(&served, 1, __ATOMIC_RELAXED);
+      }
+      return true;
+    }
+  }
+  return false;
 }
 /*----------------------------------------------------------------------------*/
-// gets a packet from the buffer (NULL = buffer empty)
+// gets a packet from the buffer, waits while the buffer is empty
 Packet
 PacketBuffer::dequeue()
 {
   Packet packet;
-  pthread_testcancel();
-  pthread_cleanup_push((void(*)(void*)) pthread_mutex_unlock, (void *) &buffer.lock);
-  pthread_mutex_lock(&buffer.lock);
-  // wait until buffer is _not_ empty
-  while(buffer.container.size() == 0)
-  {
-      DEBUG("PacketBuffer::dequeue : waiting until buffer is <notempty>")
-      pthread_cond_wait(&buffer.notempty, &buffer.lock);
-  }
-  // dequeue
-  packet = buffer.container.front();
-  buffer.container.pop_front();
-  DEBUG("PacketBuffer::dequeue : get from buffer and signal <notfull>")
-  pthread_cond_signal(&buffer.notfull);
-  pthread_cleanup_pop(1);
+  int spin = 0;
+
+  while(!tryDequeue(packet)) {
+    pthread_testcancel();
+    if(spin++ < PACKETBUFFER_SPIN) {
+      continue;
+    }
+    DEBUG("PacketBuffer::dequeue : waiting until buffer is <notempty>")
+    wait(notempty, &PacketBuffer::canDequeue, PACKETBUFFER_ANY_LANE);
+    spin = 0;
+  }
   return packet;
 }
 /*----------------------------------------------------------------------------*/
-// puts a packet into buffer... (SUCCESS = true)
-bool PacketBuffer::enqueueFront(Packet &pPacket)
+bool
+PacketBuffer::tryEnqueueBack(const Packet &pPacket)
 {
-    pthread_testcancel();
-    pthread_cleanup_push((void(*)(void*)) pthread_mutex_unlock, (void *) &buffer.lock);
-    pthread_mutex_lock(&buffer.lock);
-    // wait until buffer is _not_ full
-    while(buffer.container.size() >= maxPackets)
-    {
-        DEBUG("PacketBuffer::enqueueFront : waiting until buffer is <notfull>")
-        pthread_cond_wait(&buffer.notfull, &buffer.lock);
-    }
-    // enqueue
-    buffer.container.push_front(pPacket);
-    DEBUG("PacketBuffer::enqueueFront : put in buffer and signal <notempty>")
-    // signal that buffer is now not empty
-    pthread_cond_signal(&buffer.notempty);
-    pthread_cleanup_pop(1);
-    return true;
-}
-/*----------------------------------------------------------------------------*/
-// puts a packet into buffer... (SUCCESS = true)
-bool PacketBuffer::enqueueBack(Packet &pPacket)
+  lane_t &lane = lanes[pPacket.getLane()];
+  slot_t *slot;
+  uint64_t pos;
+  int64_t diff;
+
+  while(true) {
+    // size after tail, grow() publishes it before it thaws tail
+    pos = LOAD(lane.tail);
+    if(pos & FROZEN) {
+      // grow() only holds the lane while it moves the packets, the lane is
+      // not full, so wait for it instead of dropping the packet
+      sched_yield();
+      continue;
+    }
+    slot = &lane.slots[pos % LOAD(size)];
+    diff = (int64_t)(LOAD(slot->seq) - pos);
+    if(diff == 0) {
+      if(CAS(lane.tail, pos, pos + 1)) {
+        break;
+      }
+    } else if(diff < 0) {
+      __atomic_add_fetch(&rejects, 1, __ATOMIC_RELAXED);
+      return false;
+    }
+  }
+
+  slot->packet = pPacket;
+  STORE(slot->seq, pos + 1);
+  wakeup(notempty);
+  if(notifyFD >= 0) {
+    uint64_t one = 1;
+    if(write(notifyFD, &one, sizeof(one)) < 0) {
+      DEBUG("PacketBuffer::tryEnqueueBack : can not notify fd " << notifyFD)
+    }
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+// puts a packet into buffer, waits while the buffer is full
+bool
+PacketBuffer::enqueueBack(const Packet &pPacket)
 {
+  int spin = 0;
+
+  while(!tryEnqueueBack(pPacket)) {
     pthread_testcancel();
-    pthread_cleanup_push((void(*)(void*)) pthread_mutex_unlock, (void *) &buffer.lock);
-    pthread_mutex_lock(&buffer.lock);
-    // wait until buffer is _not_ full
-    while(buffer.container.size() >= maxPackets)
-    {
-        DEBUG("PacketBuffer::enqueueBack : waiting until buffer is <notfull>")
-        pthread_cond_wait(&buffer.notfull, &buffer.lock);
-    }
-    // enqueue
-    buffer.container.push_back(pPacket);
-    DEBUG("PacketBuffer::enqueueBack : put in buffer and signal <notempty>")
-    // signal that buffer is now not empty
-    pthread_cond_signal(&buffer.notempty);
-    pthread_cleanup_pop(1);
-    return true;
+    if(spin++ < PACKETBUFFER_SPIN) {
+      continue;
+    }
+    DEBUG("PacketBuffer::enqueueBack : waiting until buffer is <notfull>")
+    wait(notfull, &PacketBuffer::canEnqueue, pPacket.getLane());
+    spin = 0;
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+void
+PacketBuffer::setNotifyFD(int fd)
+{
+  notifyFD = fd;
 }
 /*----------------------------------------------------------------------------*/
 /* checks if packet buffer is full */
 bool PacketBuffer::isFull() {
-  bool isFull = true;
-  pthread_testcancel();
-  pthread_mutex_lock(&buffer.lock);
-  if (buffer.container.size() < maxPackets) {
-      isFull = false;
+  int l;
+
+  for(l = 0; l < PKT_LANES; l++) {
+    if(canEnqueue(l)) {
+      return false;
+    }
   }
-  pthread_mutex_unlock(&buffer.lock);
-  return isFull;
+  return true;
 }
 /*----------------------------------------------------------------------------*/
 /* checks if packet buffer is empty */
 bool PacketBuffer::isEmpty() {
-  bool isEmpty = true;
-  pthread_testcancel();
-  pthread_mutex_lock(&buffer.lock);
-  if (buffer.container.size() > 0) {
-      isEmpty = false;
+  return !canDequeue(PACKETBUFFER_ANY_LANE);
+}
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::getDepth() const
+{
+  int depth = 0;
+  int l;
+
+  for(l = 0; l < PKT_LANES; l++) {
+    depth += getDepth(l);
+  }
+  return depth;
+}
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::getDepth(int lane) const
+{
+  int64_t depth = (int64_t)((LOAD(lanes[lane].tail) & ~FROZEN) -
+                            (LOAD(lanes[lane].head) & ~FROZEN));
+  int n = LOAD(size);
+
+  if(depth < 0) {
+    return 0;
   }
-  pthread_mutex_unlock(&buffer.lock);
-  return isEmpty;
+  return (depth > n) ? n : depth;
+}
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::getCapacity() const
+{
+  return LOAD(size);
 }
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::getMaxCapacity() const
+{
+  return maxPackets;
+}
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::grow(int packets)
+{
+  std::vector<Packet> held[PKT_LANES];
+  uint64_t head[PKT_LANES], tail[PKT_LANES];
+  uint64_t pos, base;
+  int oldSize, i, l;
 
+  pthread_mutex_lock(&growLock);
+  oldSize = size;
+  if(packets > maxPackets) {
+    packets = maxPackets;
+  }
+  if(packets <= oldSize) {
+    pthread_mutex_unlock(&growLock);
+    return oldSize;
+  }
+  // the new slots are out of reach until size changes
+  for(l = 0; l < PKT_LANES; l++) {
+    if(!commitSlots(lanes[l], oldSize, packets)) {
+      ERROR("PacketBuffer::grow : can not back " << packets << " slots")
+      for(i = oldSize; i < packets; i++) {
+        lanes[l].slots[i].~slot_t();
+      }
+      pthread_mutex_unlock(&growLock);
+      return oldSize;
+    }
+    held[l].resize(oldSize);
+  }
+
+  for(l = 0; l < PKT_LANES; l++) {
+    tail[l] = __atomic_fetch_or(&lanes[l].tail, FROZEN, __ATOMIC_SEQ_CST);
+    head[l] = __atomic_fetch_or(&lanes[l].head, FROZEN, __ATOMIC_SEQ_CST);
+  }
+
+  for(l = 0; l < PKT_LANES; l++) {
+    slot_t *slots = lanes[l].slots;
+
+    // positions taken before the freeze are finished first: an enqueue
+    // below tail still has to fill its slot, a dequeue below head still
+    // has to free it for the position a ring later
+    for(pos = head[l]; pos < head[l] + oldSize; pos++) {
+      while(LOAD(slots[pos % oldSize].seq) != (pos < tail[l] ? pos + 1 : pos)) {
+        sched_yield();
+      }
+    }
+    for(pos = head[l]; pos < tail[l]; pos++) {
+      held[l][pos - head[l]].swap(slots[pos % oldSize].packet);
+    }
+
+    // past every position used so far, so a late compare-and-swap can not
+    // succeed, and at the start of a ring
+    base = (tail[l] / packets + 1) * packets;
+    for(i = 0; i < packets; i++) {
+      if(i < (int)(tail[l] - head[l])) {
+        slots[i].packet.swap(held[l][i]);
+        STORE(slots[i].seq, base + i + 1);
+      } else {
+        STORE(slots[i].seq, base + i);
+      }
+    }
+    tail[l] = base + (tail[l] - head[l]);
+    head[l] = base;
+  }
+
+  STORE(size, packets);
+  for(l = 0; l < PKT_LANES; l++) {
+    STORE(lanes[l].head, head[l]);
+    STORE(lanes[l].tail, tail[l]);
+  }
+  pthread_mutex_unlock(&growLock);
+
+  wakeup(notfull);
+  wakeup(notempty);
+  return packets;
+}
+/*----------------------------------------------------------------------------*/
+uint32_t
+PacketBuffer::takeRejects()
+{
+  return __atomic_exchange_n(&rejects, 0, __ATOMIC_RELAXED);
+}
+/*----------------------------------------------------------------------------*/
+int
+PacketBuffer::capacityFor(uint64_t bytes)
+{
+  uint64_t packets = bytes / (PKT_LANES * (sizeof(slot_t) +
+                                           sizeof(packetData_t)));
+
+  return (packets > INT_MAX) ? INT_MAX : (int)packets;
+}
+/*----------------------------------------------------------------------------*/
+std::string
+PacketBuffer::getName() const
+{
+  return name;
+}
@@ -35,60 +35,184 @@
 
 /* \file
  *      Packet buffer header file.
- *      This module is taken from TinyOS's C++ implementation of serial forwarder.
+ *      A fixed size ring of packets. Any number of threads may enqueue and
+ *      dequeue without taking a lock. The slots of the ring hold references
+ *      to packets, the payloads are not copied. A thread that has to wait
+ *      spins for a while and then sleeps until the other side wakes it up.
+ *      Each traffic class (see PKT_LANE_* in Packet.h) has a ring of its
+ *      own, so a flood of one class can not crowd out another. Dequeues
+ *      take from the highest priority lane holding a packet.
+ *      A buffer may reserve address space for more slots than it has, so
+ *      that it can grow at run time; see grow(). Only the slots in use are
+ *      backed by memory.
  */
 
 #ifndef PACKETBUFFER_H
 #define PACKETBUFFER_H
 
 #include <pthread.h>
-#include <list>
+#include <stdint.h>
 #include <string>
 #include "Packet.h"
 
+#ifdef CONF_CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE CONF_CACHE_LINE_SIZE
+#else
+#define CACHE_LINE_SIZE 64
+#endif
+
+/* Number of attempts a waiting thread makes before it goes to sleep.
+ * 0 makes it sleep right away. */
+#ifdef CONF_PACKETBUFFER_SPIN
+#define PACKETBUFFER_SPIN CONF_PACKETBUFFER_SPIN
+#else
+#define PACKETBUFFER_SPIN 100
+#endif
+
+/* After this many packets in a row, a dequeue looks at the lanes from the
+ * lowest priority up, so that busy higher lanes can not starve the lower
+ * ones. 0 gives strict priority. */
+#ifdef CONF_PACKETBUFFER_LANE_WEIGHT
+#define PACKETBUFFER_LANE_WEIGHT CONF_PACKETBUFFER_LANE_WEIGHT
+#else
+#define PACKETBUFFER_LANE_WEIGHT 8
+#endif
+
+/* lane of canDequeue() that stands for all of them */
+#define PACKETBUFFER_ANY_LANE -1
+
 class PacketBuffer
 {
   protected:
 
+    /* slots every lane can grow to */
     int maxPackets;
     std::string name;
 
-    typedef std::list<Packet> container_t;
+    /* slots of every lane now, up to maxPackets. Positions are taken
+     * modulo size, which grow() only changes with the lanes frozen. */
+    volatile int size;
+
+    /* serializes grow() */
+    pthread_mutex_t growLock;
+
+    /* enqueues that found their lane full since takeRejects() */
+    volatile uint32_t rejects;
+
+    // a slot is free for the enqueue of position pos when seq == pos and
+    // holds the packet of position pos when seq == pos + 1
+    typedef struct slot
+    {
+      volatile uint64_t seq;
+      Packet packet;
+    } __attribute__((aligned(CACHE_LINE_SIZE))) slot_t;
 
-    // thread safe buffer
-    typedef struct sharedBuffer
+    typedef struct lane
+    {
+      slot_t *slots;
+      // next position to dequeue / enqueue, on their own cache lines so
+      // that the producers and the consumer do not share one
+      volatile uint64_t head __attribute__((aligned(CACHE_LINE_SIZE)));
+      volatile uint64_t tail __attribute__((aligned(CACHE_LINE_SIZE)));
+    } __attribute__((aligned(CACHE_LINE_SIZE))) lane_t;
+
+    // size slots for each traffic class, in room for maxPackets
+    lane_t lanes[PKT_LANES];
+
+    // packets dequeued since the lower lanes were last looked at first
+    volatile int served;
+
+    // threads sleeping until the buffer is not empty / not full
+    typedef struct waitQueue
     {
-      // mutex lock for any of this vars
       pthread_mutex_t lock;
-      // notempty cond
-      pthread_cond_t notempty;
-      // not full cond
-      pthread_cond_t notfull;
-     // actual buffer
-      container_t container;
-    } sharedBuffer_t;
+      pthread_cond_t cond;
+      volatile int waiters;
+    } waitQueue_t;
+
+    waitQueue_t notempty __attribute__((aligned(CACHE_LINE_SIZE)));
+    waitQueue_t notfull;
+
+    // eventfd of a consumer that polls instead of calling dequeue()
+    int notifyFD;
+
+    void init(int maxPackets, int maxCapacity);
+
+    /* backs slots from up to to of a lane with memory and constructs them */
+    bool commitSlots(lane_t &lane, int from, int to);
+
+    static void waitCleanup(void *queue);
+
+    void wait(waitQueue_t &queue, bool (PacketBuffer::*ready)(int), int lane);
 
-    sharedBuffer_t buffer;
+    void wakeup(waitQueue_t &queue);
+
+    bool tryDequeueLane(lane_t &lane, Packet &pPacket);
+
+    /* true if lane holds a packet, any lane for PACKETBUFFER_ANY_LANE */
+    bool canDequeue(int lane);
+
+    bool canEnqueue(int lane);
 
   public:
     PacketBuffer(int maxPackets);
 
     PacketBuffer(std::string name, int maxPackets);
 
+    /* a buffer holding maxPackets a lane that can grow to maxCapacity */
+    PacketBuffer(std::string name, int maxPackets, int maxCapacity);
+
     ~PacketBuffer();
 
     void clear();
 
+    /* waits until a packet is available */
     Packet dequeue();
 
-    bool enqueueFront(Packet &pPacket);
+    /* returns false if the buffer is empty */
+    bool tryDequeue(Packet &pPacket);
 
-    bool enqueueBack(Packet &pPacket);
+    /* waits until the lane of the packet has space for it */
+    bool enqueueBack(const Packet &pPacket);
 
+    /* returns false, dropping the packet, if its lane is full */
+    bool tryEnqueueBack(const Packet &pPacket);
+
+    /* fd is written to after every enqueue, -1 turns it off */
+    void setNotifyFD(int fd);
+
+    /* true if no lane has space left */
     bool isFull();
 
     bool isEmpty();
 
+    /* packets in the buffer now, may be off by the operations under way */
+    int getDepth() const;
+
+    /* packets in one lane now */
+    int getDepth(int lane) const;
+
+    /* packets one lane may hold, every lane may hold as many */
+    int getCapacity() const;
+
+    /* what getCapacity() can grow to */
+    int getMaxCapacity() const;
+
+    /* lets every lane hold up to packets, no more than getMaxCapacity().
+     * The lanes are frozen while their packets move to the larger ring,
+     * enqueues fail and dequeues find nothing meanwhile. Returns the new
+     * capacity. */
+    int grow(int packets);
+
+    /* enqueues that failed for lack of space since the last call */
+    uint32_t takeRejects();
+
+    /* slots a lane of a buffer can have for bytes of memory, counting the
+     * payloads of the packets in every lane */
+    static int capacityFor(uint64_t bytes);
+
+    std::string getName() const;
+
 };
 
 #endif /* PACKETBUFFER_H */
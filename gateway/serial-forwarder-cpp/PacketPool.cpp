@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the packet pool.
+ */
+
+#include "PacketPool.h"
+
+#include <cstring>
+#include <new>
+
+/*----------------------------------------------------------------------------*/
+PacketPool::PacketPool(int maxPackets)
+{
+  this->maxPackets = maxPackets;
+  this->freeList = NULL;
+  memset(&stats, 0, sizeof(stats));
+  stats.size = maxPackets;
+  pthread_mutex_init(&lock, NULL);
+}
+/*----------------------------------------------------------------------------*/
+PacketPool::~PacketPool()
+{
+  unsigned int i;
+
+  for(i = 0; i < slabs.size(); i++) {
+    delete [] slabs[i];
+  }
+  pthread_mutex_destroy(&lock);
+}
+/*----------------------------------------------------------------------------*/
+PacketPool &
+PacketPool::instance()
+{
+  static PacketPool pool(PACKET_POOL_SIZE);
+  return pool;
+}
+/*----------------------------------------------------------------------------*/
+void
+PacketPool::setSize(int maxPackets)
+{
+  pthread_mutex_lock(&lock);
+  this->maxPackets = maxPackets;
+  stats.size = maxPackets;
+  pthread_mutex_unlock(&lock);
+}
+/*----------------------------------------------------------------------------*/
+bool
+PacketPool::grow()
+{
+  packetData_t *slab;
+  int i, n;
+
+  n = maxPackets - (int)stats.allocated;
+  if(n > PACKET_POOL_SLAB) {
+    n = PACKET_POOL_SLAB;
+  }
+  if(n <= 0) {
+    return false;
+  }
+
+  slab = new (std::nothrow) packetData_t[n];
+  if(slab == NULL) {
+    return false;
+  }
+  for(i = 0; i < n; i++) {
+    slab[i].pooled = true;
+    slab[i].next = freeList;
+    freeList = &slab[i];
+  }
+  slabs.push_back(slab);
+  stats.allocated += n;
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+packetData_t *
+PacketPool::acquire()
+{
+  packetData_t *data;
+
+  pthread_mutex_lock(&lock);
+  if(freeList == NULL && !grow()) {
+    stats.misses++;
+    pthread_mutex_unlock(&lock);
+    data = new packetData_t();
+    data->pooled = false;
+  } else {
+    data = freeList;
+    freeList = data->next;
+    if(++stats.inUse > stats.peak) {
+      stats.peak = stats.inUse;
+    }
+    pthread_mutex_unlock(&lock);
+  }
+
+  data->refCount = 1;
+  data->next = NULL;
+  data->bufLen = 0;
+  data->type = PKT_TYPE_DATA;
+  data->source = PKT_SOURCE_ANY;
+  data->stamp = 0;
+  return data;
+}
+/*----------------------------------------------------------------------------*/
+void
+PacketPool::release(packetData_t *data)
+{
+  if(!data->pooled) {
+    delete data;
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  data->next = freeList;
+  freeList = data;
+  stats.inUse--;
+  pthread_mutex_unlock(&lock);
+}
+/*----------------------------------------------------------------------------*/
+void
+PacketPool::getStats(packetPoolStats_t &stats)
+{
+  // read without the lock, so that asking does not hold up the packet
+  // path. Every counter is whole, they may be from slightly different
+  // moments.
+  stats.size = __atomic_load_n(&this->stats.size, __ATOMIC_RELAXED);
+  stats.allocated = __atomic_load_n(&this->stats.allocated, __ATOMIC_RELAXED);
+  stats.inUse = __atomic_load_n(&this->stats.inUse, __ATOMIC_RELAXED);
+  stats.peak = __atomic_load_n(&this->stats.peak, __ATOMIC_RELAXED);
+  stats.misses = __atomic_load_n(&this->stats.misses, __ATOMIC_RELAXED);
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Packet pool header file.
+ *      Payloads of packets live in blocks carved from large slabs. A block
+ *      is shared by every copy of a packet and counts its references, it
+ *      goes back to the pool when the last copy is gone.
+ */
+
+#ifndef PACKETPOOL_H
+#define PACKETPOOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Packet.h"
+
+/* Number of blocks the pool may hold. When all of them are in use blocks
+ * are taken from the heap, and counted as misses. */
+#ifdef CONF_PACKET_POOL_SIZE
+#define PACKET_POOL_SIZE CONF_PACKET_POOL_SIZE
+#else
+#define PACKET_POOL_SIZE 4096
+#endif
+
+/* Number of blocks allocated at once when the pool grows. */
+#ifdef CONF_PACKET_POOL_SLAB
+#define PACKET_POOL_SLAB CONF_PACKET_POOL_SLAB
+#else
+#define PACKET_POOL_SLAB 256
+#endif
+
+typedef struct packetData {
+  /* copies of the packet referring to this block */
+  volatile int refCount;
+  /* false for blocks taken from the heap */
+  bool pooled;
+  /* next free block */
+  struct packetData *next;
+  int bufLen;
+  int type;
+  int source;
+  /* Metrics::now() when the packet entered the forwarder, 0 if unknown */
+  uint64_t stamp;
+  char buffer[MAX_PKT_SIZE + 1];
+} packetData_t;
+
+typedef struct packetPoolStats {
+  /* blocks the pool may hold, blocks allocated so far */
+  uint32_t size;
+  uint32_t allocated;
+  /* blocks in use now and at most */
+  uint32_t inUse;
+  uint32_t peak;
+  /* blocks taken from the heap because the pool was exhausted */
+  uint32_t misses;
+} packetPoolStats_t;
+
+class PacketPool
+{
+  protected:
+
+    int maxPackets;
+
+    std::vector<packetData_t *> slabs;
+
+    packetData_t *freeList;
+
+    pthread_mutex_t lock;
+
+    packetPoolStats_t stats;
+
+    /* allocate another slab, called with lock held */
+    bool grow();
+
+  public:
+
+    PacketPool(int maxPackets);
+
+    ~PacketPool();
+
+    /* the pool all packets are allocated from */
+    static PacketPool &instance();
+
+    /* change the number of blocks the pool may hold. Slabs already
+     * allocated are kept. */
+    void setSize(int maxPackets);
+
+    /* returns a block with one reference */
+    packetData_t *acquire();
+
+    /* takes a block whose last reference is gone */
+    void release(packetData_t *data);
+
+    void getStats(packetPoolStats_t &stats);
+
+};
+
+#endif /* PACKETPOOL_H */
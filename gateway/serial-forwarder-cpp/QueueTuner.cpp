@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the queue tuner.
+ */
+
+#include "QueueTuner.h"
+#include "Metrics.h"
+#include "PacketPool.h"
+
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+#include <iostream>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+/*----------------------------------------------------------------------------*/
+QueueTuner::QueueTuner()
+{
+  this->tunerThreadRunning = false;
+}
+/*----------------------------------------------------------------------------*/
+QueueTuner::~QueueTuner()
+{
+  cancel();
+}
+/*----------------------------------------------------------------------------*/
+void
+QueueTuner::addBuffer(PacketBuffer *buffer)
+{
+  tunedBuffer_t tuned;
+
+  tuned.buffer = buffer;
+  tuned.rounds = 0;
+  tuned.rejects = 0;
+  buffers.push_back(tuned);
+}
+/*----------------------------------------------------------------------------*/
+void *
+queueTunerThreadFunc(void* ob)
+{
+  static_cast<QueueTuner*>(ob)->run();
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+int
+QueueTuner::start()
+{
+  int ret;
+
+  ret = pthread_create(&tunerThread, NULL, queueTunerThreadFunc, this);
+  if(ret != 0) {
+    errno = ret;
+    ERROR("QueueTuner::start : Could not start queue tuner thread");
+    return -1;
+  }
+  tunerThreadRunning = true;
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+QueueTuner::run()
+{
+  while(true) {
+    usleep(QUEUE_TUNER_INTERVAL * 1000);
+    tune();
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+QueueTuner::tune()
+{
+  PacketPool &pool = PacketPool::instance();
+  packetPoolStats_t poolStats;
+  unsigned int i;
+  int l, depth, capacity, grown;
+  uint32_t rejects;
+
+  for(i = 0; i < buffers.size(); i++) {
+    tunedBuffer_t &tuned = buffers[i];
+    PacketBuffer *buffer = tuned.buffer;
+
+    capacity = buffer->getCapacity();
+    rejects = buffer->takeRejects();
+    depth = 0;
+    for(l = 0; l < PKT_LANES; l++) {
+      if(buffer->getDepth(l) > depth) {
+        depth = buffer->getDepth(l);
+      }
+    }
+
+    if(rejects == 0 && depth * 4 < capacity * 3) {
+      tuned.rounds = 0;
+      tuned.rejects = 0;
+      continue;
+    }
+    tuned.rounds++;
+    tuned.rejects += rejects;
+    if(tuned.rounds < QUEUE_TUNER_ROUNDS ||
+       capacity >= buffer->getMaxCapacity()) {
+      continue;
+    }
+
+    grown = buffer->grow(capacity * 2);
+    // the pool keeps a block for every packet the buffers may hold, or
+    // the packets of a burst would come from the heap
+    pool.getStats(poolStats);
+    pool.setSize(poolStats.size + (grown - capacity) * PKT_LANES);
+    Metrics::instance().add(METRIC_QUEUE_GROWS);
+    std::cout << "QueueTuner : " << buffer->getName() << " grown from "
+              << capacity << " to " << grown << " packets a lane, "
+              << tuned.rejects << " dropped and depth " << depth
+              << " in the last " << tuned.rounds << " looks" << std::endl;
+    tuned.rounds = 0;
+    tuned.rejects = 0;
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+QueueTuner::cancel()
+{
+  if(tunerThreadRunning) {
+    pthread_cancel(tunerThread);
+    pthread_join(tunerThread, NULL);
+    tunerThreadRunning = false;
+  }
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+
+/* \file
+ *      Header file of the queue tuner.
+ *      Grows packet buffers that stay under pressure, so that a gateway
+ *      with memory to spare absorbs longer bursts. Once a second the tuner
+ *      looks at every buffer; a buffer that dropped packets or was three
+ *      quarters full for QUEUE_TUNER_ROUNDS seconds in a row gets twice
+ *      the capacity, up to the capacity it was made with room for. The
+ *      packet pool grows along with it. Buffers are never shrunk.
+ *      Every decision is printed and counted in METRIC_QUEUE_GROWS, the
+ *      capacities are in the stats report.
+ */
+
+#ifndef QUEUETUNER_H
+#define QUEUETUNER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "PacketBuffer.h"
+
+/* Milliseconds between two looks at the buffers. */
+#ifdef CONF_QUEUE_TUNER_INTERVAL
+#define QUEUE_TUNER_INTERVAL CONF_QUEUE_TUNER_INTERVAL
+#else
+#define QUEUE_TUNER_INTERVAL 1000
+#endif
+
+/* Looks in a row a buffer has to be under pressure to be grown. */
+#ifdef CONF_QUEUE_TUNER_ROUNDS
+#define QUEUE_TUNER_ROUNDS CONF_QUEUE_TUNER_ROUNDS
+#else
+#define QUEUE_TUNER_ROUNDS 2
+#endif
+
+class QueueTuner
+{
+  protected:
+
+    typedef struct tunedBuffer {
+      PacketBuffer *buffer;
+      /* looks in a row the buffer was under pressure */
+      int rounds;
+      /* packets dropped during those looks */
+      uint64_t rejects;
+    } tunedBuffer_t;
+
+    std::vector<tunedBuffer_t> buffers;
+
+    pthread_t tunerThread;
+
+    bool tunerThreadRunning;
+
+    void run();
+
+    /* one look at the buffers */
+    void tune();
+
+    friend void* queueTunerThreadFunc(void* ob);
+
+  public:
+
+    QueueTuner();
+
+    ~QueueTuner();
+
+    /* Buffers have to be added before start(), made with room to grow. */
+    void addBuffer(PacketBuffer *buffer);
+
+    int start();
+
+    void cancel();
+
+};
+
+#endif /* QUEUETUNER_H */
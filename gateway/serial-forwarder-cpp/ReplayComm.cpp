@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the replay module.
+ */
+
+#include "ReplayComm.h"
+#include "Metrics.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include <cstring>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+void* replayThreadFunc(void* ob);
+
+/*----------------------------------------------------------------------------*/
+ReplayComm::ReplayComm(const std::string path, double speed,
+                       PacketBuffer &readBuffer) : readBuffer(readBuffer)
+{
+  this->path = path;
+  this->speed = speed;
+  this->log = NULL;
+  this->logSize = 0;
+  this->replayThreadRunning = false;
+  this->replayed = 0;
+  this->finished = false;
+}
+/*----------------------------------------------------------------------------*/
+ReplayComm::~ReplayComm()
+{
+  cancel();
+  if(log != NULL) {
+    munmap((void *)log, logSize);
+  }
+}
+/*----------------------------------------------------------------------------*/
+int
+ReplayComm::start()
+{
+  const captureHeader_t *header;
+  struct stat st;
+  void *mem;
+  int fd, ret;
+
+  fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0) {
+    ERROR("Can not open capture log " << path);
+    return -1;
+  }
+  if(fstat(fd, &st) < 0 || (uint64_t)st.st_size < sizeof(captureHeader_t)) {
+    errno = EINVAL;
+    ERROR("Not a capture log " << path);
+    close(fd);
+    return -1;
+  }
+  mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(mem == MAP_FAILED) {
+    ERROR("Can not map capture log " << path);
+    return -1;
+  }
+  log = (const char *)mem;
+  logSize = st.st_size;
+  madvise(mem, logSize, MADV_SEQUENTIAL);
+
+  header = (const captureHeader_t *)log;
+  if(memcmp(header->magic, CAPTURE_MAGIC, sizeof(header->magic)) != 0 ||
+     header->version != CAPTURE_VERSION) {
+    errno = EINVAL;
+    ERROR("Not a capture log " << path);
+    return -1;
+  }
+
+  ret = pthread_create(&replayThread, NULL, replayThreadFunc, this);
+  if(ret != 0) {
+    ERROR("Can not start replay thread");
+    return -1;
+  }
+  replayThreadRunning = true;
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void *
+replayThreadFunc(void* ob)
+{
+  static_cast<ReplayComm*>(ob)->replay();
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+void
+ReplayComm::replay()
+{
+  const captureHeader_t *header = (const captureHeader_t *)log;
+  const captureRecord_t *record;
+  uint64_t pos = header->headerLen;
+  uint64_t firstStamp = 0, startTime = 0, due;
+  bool started = false;
+  struct timespec ts;
+  Packet packet;
+
+  while(pos + sizeof(captureRecord_t) <= logSize) {
+    record = (const captureRecord_t *)(log + pos);
+    if(pos + CAPTURE_RECORD_SIZE(record->length) > logSize) {
+      DEBUG("ReplayComm::replay : partial record at " << pos);
+      break;
+    }
+
+    if(speed > 0) {
+      // a log appended to after a restart starts its clock over
+      if(!started || record->timestamp < firstStamp) {
+        firstStamp = record->timestamp;
+        startTime = Metrics::now();
+        started = true;
+      }
+      due = startTime + (uint64_t)((record->timestamp - firstStamp) / speed);
+      ts.tv_sec = due / 1000000000ULL;
+      ts.tv_nsec = due % 1000000000ULL;
+      while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+    }
+
+    if(!packet.setPayload(log + pos + sizeof(captureRecord_t), record->length,
+                          record->type, record->source)) {
+      DEBUG("ReplayComm::replay : record too long at " << pos);
+    } else {
+      packet.setTimestamp(Metrics::now());
+      readBuffer.enqueueBack(packet);
+      replayed++;
+    }
+    pos += CAPTURE_RECORD_SIZE(record->length);
+  }
+
+  DEBUG("ReplayComm::replay : replayed " << replayed << " frames");
+  finished = true;
+}
+/*----------------------------------------------------------------------------*/
+void
+ReplayComm::cancel()
+{
+  if(replayThreadRunning) {
+    pthread_cancel(replayThread);
+    pthread_join(replayThread, NULL);
+    replayThreadRunning = false;
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+ReplayComm::isFinished() const
+{
+  return finished;
+}
+/*----------------------------------------------------------------------------*/
+uint64_t
+ReplayComm::getReplayed() const
+{
+  return replayed;
+}
+/*----------------------------------------------------------------------------*/
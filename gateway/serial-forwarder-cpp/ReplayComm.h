@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the replay module.
+ *      Feeds the read buffer from a capture log instead of a serial
+ *      device, keeping the gaps between the frames as they were recorded,
+ *      scaled by a speed factor, or sending them as fast as the read
+ *      buffer takes them.
+ */
+
+#ifndef REPLAYCOMM_H
+#define REPLAYCOMM_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "BaseComm.h"
+#include "CaptureLog.h"
+#include "PacketBuffer.h"
+
+class ReplayComm : public BaseComm
+{
+  protected:
+
+    std::string path;
+
+    /* 1 replays at the recorded rate, 2 twice as fast, 0 without gaps */
+    double speed;
+
+    /* the log, mapped while replaying */
+    const char *log;
+
+    uint64_t logSize;
+
+    /* packet buffer the frames are replayed into */
+    PacketBuffer &readBuffer;
+
+    pthread_t replayThread;
+
+    bool replayThreadRunning;
+
+    /* frames replayed so far */
+    volatile uint64_t replayed;
+
+    volatile bool finished;
+
+    void replay();
+
+    friend void* replayThreadFunc(void* ob);
+
+  private:
+    // Do not allow standard constructor
+    ReplayComm();
+
+  public:
+
+    ReplayComm(const std::string path, double speed, PacketBuffer &readBuffer);
+
+    ~ReplayComm();
+
+    /* maps the log and starts replaying it */
+    int start();
+
+    void cancel();
+
+    /* true once every frame of the log has been replayed */
+    bool isFinished() const;
+
+    uint64_t getReplayed() const;
+
+};
+
+#endif /* REPLAYCOMM_H */
@@ -40,6 +40,9 @@
 
 
 #include "SerialComm.h"
+#include "SinkGroup.h"
+#include "CaptureLog.h"
+#include "Metrics.h"
 
 #include <ctime>
 #include <cstdlib>
@@ -47,8 +50,11 @@
 #include <fcntl.h>
 #include <termios.h>
 #include <pthread.h>
+#include <sched.h>
+#include <linux/serial.h>
 #include <sstream>
 #include <sys/time.h>
+#include <sys/eventfd.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
@@ -347,8 +353,16 @@ SerialComm::setOptions(int baudrate, int databits, Parity parity,
    newtio.c_lflag=0;
    newtio.c_oflag=0;
 
-   newtio.c_cc[VTIME]=1;
-   newtio.c_cc[VMIN]=60;
+   // a read returns once 60 bytes are in or the line is idle for 100 ms,
+   // with low latency ingest as soon as there is a byte
+   if (ingest.lowLatency) {
+     newtio.c_cc[VTIME]=0;
+     newtio.c_cc[VMIN]=1;
+   }
+   else {
+     newtio.c_cc[VTIME]=1;
+     newtio.c_cc[VMIN]=60;
+   }
 
 //   tcflush(m_fd, TCIFLUSH);
    if (tcsetattr(serialFD, TCSANOW, &newtio)!=0) {
@@ -400,6 +414,19 @@ SerialComm::SerialComm(std::string device,
   this->isStarted = false;
   this->baudrate = baudrate;
   this->device = device;
+  this->sinkGroup = NULL;
+  this->sourceId = PKT_SOURCE_ANY;
+  this->capture = NULL;
+  this->useIoUring = false;
+  this->fixedFifo = false;
+  this->wakeFD = -1;
+  this->uringReadPending = false;
+  this->uringTimeoutPending = false;
+  this->uringWakePending = false;
+  this->ingest.lowLatency = false;
+  this->ingest.cpu = -1;
+  this->ingest.fifoPriority = 0;
+  this->readStamp = 0;
 
   FD_ZERO(&rfds);
   FD_ZERO(&wfds);
@@ -411,6 +438,10 @@ SerialComm::~SerialComm()
   if (serialFD > 2) {
     close(serialFD);
   }
+  uring.close();
+  if(wakeFD >= 0) {
+    close(wakeFD);
+  }
 
 }
 /*---------------------------------------------------------------------------*/
@@ -428,6 +459,7 @@ SerialComm::start()
   // FIFO initialization
   rawfifo.head = 0;
   rawfifo.tail = 0;
+  slipDecoder.reset();
 
   serialFD = open(device.c_str(), O_RDWR | O_NOCTTY | O_NDELAY);
 
@@ -462,6 +494,18 @@ SerialComm::start()
   FD_ZERO(&rfds);
   FD_ZERO(&wfds);
 
+  if(useIoUring && !uring.isReady()) {
+    if(uring.init(SERIAL_URING_ENTRIES) < 0) {
+      DEBUG("SerialComm::start : no io_uring, reading with read()");
+    } else if((wakeFD = eventfd(0, EFD_CLOEXEC)) < 0) {
+      DEBUG("SerialComm::start : no eventfd, reading with read()");
+      uring.close();
+    } else {
+      fixedFifo = (uring.registerBuffer(rawfifo.queue,
+                                        sizeof(rawfifo.queue)) == 0);
+    }
+  }
+
   retValue = pthread_create(&readerThread, NULL, serialReadThread, this);
   if (retValue < 0) {
     ERROR("Can not start reader thread. Device : "<< device);
@@ -469,6 +513,7 @@ SerialComm::start()
     return -1;
   }
   this->readerThreadRunning = true;
+  applyIngest();
   retValue = pthread_create(&writerThread, NULL, serialWriteThread, this);
   if (retValue < 0) {
     ERROR("Can not start writer thread. Device : "<< device);
@@ -487,6 +532,86 @@ SerialComm::getDevice() const
   return device;
 }
 /*---------------------------------------------------------------------------*/
+void
+SerialComm::setSinkGroup(SinkGroup *group)
+{
+  sinkGroup = group;
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::setSourceId(int sourceId)
+{
+  this->sourceId = sourceId;
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::setCapture(CaptureLog *capture)
+{
+  this->capture = capture;
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::setIoUring(bool enable)
+{
+  this->useIoUring = enable;
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::setIngest(const ingestOptions_t &options)
+{
+  this->ingest = options;
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::applyIngest()
+{
+  struct serial_struct serial;
+  struct sched_param param;
+  cpu_set_t cpus;
+  int ret;
+
+  // none of these is needed to run, a device or host without them only
+  // gets a warning
+  if(ingest.lowLatency) {
+    if(ioctl(serialFD, TIOCGSERIAL, &serial) == 0) {
+      serial.flags |= ASYNC_LOW_LATENCY;
+      if(ioctl(serialFD, TIOCSSERIAL, &serial) < 0) {
+        ERROR("Can not set ASYNC_LOW_LATENCY for device " << device);
+      }
+    } else {
+      DEBUG("SerialComm::applyIngest : no ASYNC_LOW_LATENCY for " << device);
+    }
+  }
+
+  if(ingest.cpu >= 0) {
+    CPU_ZERO(&cpus);
+    CPU_SET(ingest.cpu, &cpus);
+    ret = pthread_setaffinity_np(readerThread, sizeof(cpus), &cpus);
+    if(ret != 0) {
+      errno = ret;
+      ERROR("Can not pin the reader of " << device << " to CPU "
+            << ingest.cpu);
+    }
+  }
+
+  if(ingest.fifoPriority > 0) {
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = ingest.fifoPriority;
+    ret = pthread_setschedparam(readerThread, SCHED_FIFO, &param);
+    if(ret != 0) {
+      errno = ret;
+      ERROR("Can not run the reader of " << device << " with SCHED_FIFO "
+            << ingest.fifoPriority);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+SerialComm::getSourceId() const
+{
+  return sourceId;
+}
+/*---------------------------------------------------------------------------*/
 int
 SerialComm::getBaudRate() const
 {
@@ -505,6 +630,18 @@ SerialComm::readBytes(char * buffer, int count)
   int retValue;
   int tmpCnt = 0;
 
+  if(uring.isReady()) {
+    return readBytesUring(buffer, count);
+  }
+
+  // with VMIN 1 read() returns as soon as there is a byte, and being a
+  // cancellation point it needs no select() in front of it
+  if(ingest.lowLatency) {
+    tmpCnt = read(serialFD, buffer, count);
+    readStamp = Metrics::now();
+    return tmpCnt;
+  }
+
   while (tmpCnt == 0) {
     retValue = fdWait(serialFD, 1, 1000);
     if (retValue < 0) {
@@ -512,11 +649,87 @@ SerialComm::readBytes(char * buffer, int count)
     }
     tmpCnt = read(serialFD, buffer, count);
   }
+  readStamp = Metrics::now();
 
   return tmpCnt;
 }
 /*---------------------------------------------------------------------------*/
 int
+SerialComm::readBytesUring(char * buffer, int count)
+{
+  uint64_t userData;
+  int res, received;
+  bool readDone;
+  int bufIndex = (fixedFifo && buffer == rawfifo.queue) ? 0 : -1;
+
+  // one io_uring_enter() reads, or gives up after a second like fdWait()
+  // does, where select() and read() took two
+  while(true) {
+    if(!uringWakePending) {
+      if(!uring.prepPollIn(wakeFD, URING_SERIAL_WAKE)) {
+        return -1;
+      }
+      uringWakePending = true;
+    }
+    // a new read only once the timeout of the last one is gone, the ring
+    // has room for one of them
+    if(!uringReadPending && !uringTimeoutPending) {
+      if(!uring.prepRead(serialFD, buffer, count, bufIndex, URING_SERIAL_READ) ||
+         !uring.prepLinkTimeout(1000, URING_SERIAL_TIMEOUT)) {
+        return -1;
+      }
+      uringReadPending = true;
+      uringTimeoutPending = true;
+    }
+    pthread_testcancel();
+    res = uring.submitAndWait(1);
+    if(res < 0) {
+      ERROR("SerialComm::readBytesUring : io_uring_enter failed");
+      return -1;
+    }
+    pthread_testcancel();
+
+    readDone = false;
+    received = 0;
+    while(uring.popCompletion(userData, res)) {
+      if(userData == URING_SERIAL_READ) {
+        uringReadPending = false;
+        readDone = true;
+        received = res;
+      } else if(userData == URING_SERIAL_TIMEOUT) {
+        uringTimeoutPending = false;
+      } else if(userData == URING_SERIAL_WAKE) {
+        uringWakePending = false;
+      }
+    }
+    if(!readDone) {
+      continue;
+    }
+    if(received > 0) {
+      readStamp = Metrics::now();
+      return received;
+    }
+    // timed out
+    if(received == 0 || received == -ECANCELED || received == -EINTR ||
+       received == -EAGAIN) {
+      continue;
+    }
+    errno = -received;
+    return -1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+SerialComm::wakeReader()
+{
+  uint64_t one = 1;
+
+  if(wakeFD >= 0 && write(wakeFD, &one, sizeof(one)) < 0) {
+    DEBUG("SerialComm::wakeReader : can not signal the reader thread");
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
 SerialComm::writeBytes(char * buffer, int count)
 {
   int sent;
@@ -543,70 +756,33 @@ serialReadThread(void* ob)
 }
 /*---------------------------------------------------------------------------*/
 int
-SerialComm::nextRawByte(unsigned char &nextByte)
-{
-  if (rawfifo.head < rawfifo.tail) {
-    // still we have data to be processed in FIFO
-    nextByte = rawfifo.queue[rawfifo.head++];
-  } else {
-    // no data in FIFO. need to get some bytes from serial device
-    rawfifo.head = 0;
-    rawfifo.tail = readBytes(rawfifo.queue, MAX_MTU);
-    if (rawfifo.tail < 0) {
-      return -1;
-    }
-    nextByte = rawfifo.queue[rawfifo.head++];
-  }
-
-  return 0;
-}
-/*---------------------------------------------------------------------------*/
-int
 SerialComm::readSLIPData(char *buffer, int bufLen)
 {
-  int retValue;
-  int received = 0;
-  unsigned char nextByte;
-  bool isDebugData = false;
+  int frameLen;
+  int errors;
 
   while(true) {
-    retValue = nextRawByte(nextByte);
-    if (retValue < 0) {
-      return -1;
-    }
-
-    switch(nextByte) {
-      case SLIP_END:
-        if(received > 0) {
-          return received;
+    // frames left over from the last read come first
+    while(rawfifo.head < rawfifo.tail) {
+      rawfifo.head += slipDecoder.decode(rawfifo.queue + rawfifo.head,
+                                         rawfifo.tail - rawfifo.head,
+                                         buffer, bufLen, frameLen);
+      if(frameLen > 0) {
+        errors = slipDecoder.takeErrors();
+        if(errors > 0) {
+          Metrics::instance().add(METRIC_SLIP_ERRORS, errors);
         }
-        break;
-       case SLIP_ESC:
-         retValue = nextRawByte(nextByte);
-         if (retValue < 0) {
-           return -1;
-         }
-
-         switch(nextByte) {
-           case SLIP_ESC_END:
-             nextByte = SLIP_END;
-             break;
-           case SLIP_ESC_ESC:
-             nextByte = SLIP_ESC;
-             break;
-           case DEBUG_MAKER:
-             nextByte = DEBUG_MAKER;
-             break;
-           default:
-             DEBUG("SerialComm::readSLIPData : protocol error.");
-         }
-
-       default:
-         if(received < bufLen) {
-           buffer[received++] = nextByte;
-         }
+        return frameLen;
+      }
     }
 
+    // no data in FIFO. need to get some bytes from serial device
+    rawfifo.head = 0;
+    rawfifo.tail = readBytes(rawfifo.queue, SERIAL_READ_SIZE);
+    if(rawfifo.tail < 0) {
+      rawfifo.tail = 0;
+      return -1;
+    }
   }
   return 0;
 }
@@ -619,27 +795,14 @@ SerialComm::readSLIPData(char *buffer, int bufLen)
 int
 SerialComm::writeSLIPData(const unsigned char *buffer, int bufLen)
 {
-  int i;
   int k;
-  int finalLen = 0;
-
-  tmpSLIPBuf[finalLen++] = SLIP_END;
-  for(i=0; i < bufLen; i++) {
-    switch(buffer[i]) {
-      case SLIP_END:
-        tmpSLIPBuf[finalLen++] = SLIP_ESC;
-        tmpSLIPBuf[finalLen++] = SLIP_ESC_END;
-        break;
-      case SLIP_ESC:
-        tmpSLIPBuf[finalLen++] = SLIP_ESC;
-        tmpSLIPBuf[finalLen++] = SLIP_ESC_ESC;
-        break;
-      default:
-        tmpSLIPBuf[finalLen++] = buffer[i];
-        break;
-    }
+  int finalLen;
+
+  if(bufLen > MAX_PKT_SIZE) {
+    DEBUG("SerialComm::writeSLIPData : packet too long :"<<bufLen);
+    return -1;
   }
-  tmpSLIPBuf[finalLen++] = SLIP_END;
+  finalLen = SlipCodec::encode((const char *)buffer, bufLen, tmpSLIPBuf);
   DEBUG("SerialComm::writeSLIPData : final length :"<<finalLen);
   k = writeAll(serialFD, tmpSLIPBuf, finalLen);
   if(k != finalLen) {
@@ -656,6 +819,7 @@ SerialComm::readSerial()
   int received;
   char buffer[MAX_MTU];
   int type;
+  Metrics &metrics = Metrics::instance();
 
   while(true) {
     received = readSLIPData(buffer, MAX_MTU);
@@ -671,11 +835,26 @@ SerialComm::readSerial()
       } else {
         type = PKT_TYPE_DATA;
       }
-      packet.setPayload(buffer, received, type);
-      if(!readBuffer.isFull()) {
-        readBuffer.enqueueBack(packet);
-      } else {
+      packet.setPayload(buffer, received, type, sourceId);
+      // the frame was in by the time the read it came with returned
+      packet.setTimestamp(readStamp);
+      metrics.add(METRIC_SERIAL_FRAMES_IN);
+      metrics.add(METRIC_SERIAL_BYTES_IN, received);
+      if(sinkGroup != NULL && sinkGroup->isDuplicate(packet)) {
+        DEBUG("SerialComm::readSerial : result already received by another sink. Dropping the packet");
+        metrics.add(METRIC_SERIAL_DUPLICATES);
+        continue;
+      }
+      // captured even if the read buffer is full, to see what was lost
+      if(capture != NULL) {
+        capture->append(packet);
+      }
+      if(!readBuffer.tryEnqueueBack(packet)) {
         DEBUG("SerialComm::readSerial : warning! read buffer full. Dropping the packet");
+        metrics.add(type == PKT_TYPE_DEBUG ? METRIC_DEBUG_DROPS
+                                           : METRIC_READ_BUFFER_DROPS);
+      } else {
+        metrics.recordSince(METRIC_SERIAL_INGEST, readStamp, Metrics::now());
       }
 
     }
@@ -697,12 +876,27 @@ SerialComm::writeSerial()
 {
   Packet packet;
   int k;
+  Metrics &metrics = Metrics::instance();
+
   while(true) {
     packet = writeBuffer.dequeue();
+    // A single sink reads the shared write buffer directly, so packets
+    // tagged for a sink that does not exist end up here.
+    if(sourceId != PKT_SOURCE_ANY && packet.getSource() != PKT_SOURCE_ANY &&
+       packet.getSource() != sourceId) {
+      DEBUG("SerialComm::writeSerial : no sink " << packet.getSource()
+            << ". Dropping the packet");
+      continue;
+    }
     k = writeSLIPData((const unsigned char *)packet.getPayload(), packet.getPacketLength());
     if(k < 0) {
       DEBUG("SerialComm::writeSerial : warning error on writing SLIP data");
+      continue;
     }
+    metrics.add(METRIC_SERIAL_FRAMES_OUT);
+    metrics.add(METRIC_SERIAL_BYTES_OUT, packet.getPacketLength());
+    metrics.recordSince(METRIC_CLIENT_TO_SERIAL, packet.getTimestamp(),
+                        Metrics::now());
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -730,6 +924,7 @@ SerialComm::cancel()
     pthread_detach(writerThread);
     if (readerThreadRunning) {
       pthread_cancel(readerThread);
+      wakeReader();
       DEBUG("SerialComm::cancel : readerThread canceled, joining")
       pthread_join(readerThread, NULL);
       readerThreadRunning = false;
@@ -742,6 +937,7 @@ SerialComm::cancel()
     DEBUG("SerialComm::cancel : by other thread")
     if (readerThreadRunning) {
       pthread_cancel(readerThread);
+      wakeReader();
       DEBUG("SerialComm::cancel : readerThread canceled, joining")
       pthread_join(readerThread, NULL);
       readerThreadRunning = false;
@@ -52,15 +52,10 @@
 #include <cstdio>
 
 #include "BaseComm.h"
+#include "IoUring.h"
 #include "Packet.h"
 #include "PacketBuffer.h"
-
-
-#define SLIP_END             0300    /* indicates end of packet */
-#define SLIP_ESC             0333    /* indicates byte stuffing */
-#define SLIP_ESC_END         0334    /* SLIP_ESC SLIP_ESC_END means SLIP_END data byte */
-#define SLIP_ESC_ESC         0335    /* SLIP_ESC SLIP_ESC_ESC means ESC data byte */
-#define DEBUG_MAKER          0015    /* \r used to distinguish debug messages */
+#include "SlipCodec.h"
 
 
 
@@ -74,6 +69,37 @@
 #endif /* MAX_PKT_SIZE */
 #endif /* CONF_MAX_MTU*/
 
+/* Bytes asked for by one read() of the serial device, a read may hold
+ * several frames. */
+#ifdef CONF_SERIAL_READ_SIZE
+#define SERIAL_READ_SIZE CONF_SERIAL_READ_SIZE
+#else
+#define SERIAL_READ_SIZE 4096
+#endif
+
+/* Entries of the io_uring of a reader thread, a read, its timeout and the
+ * poll of the wake eventfd are in flight at a time. */
+#define SERIAL_URING_ENTRIES 4
+
+/* user data of the entries */
+#define URING_SERIAL_READ    1
+#define URING_SERIAL_TIMEOUT 2
+#define URING_SERIAL_WAKE    3
+
+/* How the reader thread of a sink runs, see SerialComm::setIngest(). */
+typedef struct ingestOptions {
+  /* VMIN 1 and VTIME 0 instead of waiting for 60 bytes or a gap of
+   * 100 ms, ASYNC_LOW_LATENCY where the driver has it, and a read() that
+   * blocks on its own instead of select() and read() */
+  bool lowLatency;
+  /* CPU the reader thread is pinned to, -1 for any */
+  int cpu;
+  /* SCHED_FIFO priority of the reader thread, 0 keeps SCHED_OTHER */
+  int fifoPriority;
+} ingestOptions_t;
+
+class SinkGroup;
+class CaptureLog;
 
 class SerialComm : public BaseComm
 {
@@ -98,17 +124,20 @@ class SerialComm : public BaseComm
     };
   protected:
 
-    /* raw read buffer */
+    /* raw read buffer, bytes from head to tail are not decoded yet */
     typedef struct rawFifo {
-      char queue[MAX_MTU];
+      char queue[SERIAL_READ_SIZE];
       int head;
       int tail;
     } rawFifo_t;
 
     rawFifo_t rawfifo;
 
+    /* decoder of the frames read */
+    SlipCodec slipDecoder;
+
     /* temporary buffer to encode a packet to SLIP format */
-    char tmpSLIPBuf[MAX_MTU];
+    char tmpSLIPBuf[SLIP_ENCODED_SIZE(MAX_PKT_SIZE)];
 
     /* Pthread for serial reading. */
     pthread_t readerThread;
@@ -146,6 +175,40 @@ class SerialComm : public BaseComm
     /* packet buffer for packets to be written to the serial device */
     PacketBuffer &writeBuffer;
 
+    /* group this device is a sink of, NULL if it is the only one */
+    SinkGroup *sinkGroup;
+
+    /* number packets read from this device are tagged with */
+    int sourceId;
+
+    /* log every frame read is appended to, NULL if none */
+    CaptureLog *capture;
+
+    /* whether to read through uring, which is set up on start() */
+    bool useIoUring;
+
+    /* ring of the reader thread, rawfifo is its fixed buffer if it could
+     * be registered */
+    IoUring uring;
+    bool fixedFifo;
+
+    /* io_uring_enter() is no cancellation point, so the reader thread
+     * also polls this eventfd through uring, and cancel() signals it to
+     * bring the thread to pthread_testcancel() */
+    int wakeFD;
+
+    /* entries of uring that have not completed yet */
+    bool uringReadPending;
+    bool uringTimeoutPending;
+    bool uringWakePending;
+
+    /* how the reader thread runs */
+    ingestOptions_t ingest;
+
+    /* time the last read of the device returned, the frames decoded from
+     * it are stamped with it */
+    uint64_t readStamp;
+
   private:
     // Do not allow standard constructor
     SerialComm();
@@ -166,13 +229,19 @@ class SerialComm : public BaseComm
 
     int readBytes(char * buffer, int count);
 
+    /* readBytes() through uring */
+    int readBytesUring(char * buffer, int count);
+
+    /* makes the reader thread leave io_uring_enter() */
+    void wakeReader();
+
     int writeBytes(char * buffer, int count);
 
     int setOptions(int baudrate, int databits, Parity parity,
                    StopBits stop, bool softwareHandshake, bool hardwareHandshake);
 
-    /* Read a byte from FIFO. */
-    int nextRawByte(unsigned char &nextByte);
+    /* ASYNC_LOW_LATENCY, affinity and priority of the reader thread */
+    void applyIngest();
 
     int readSLIPData(char *buffer, int bufLen);
 
@@ -199,6 +268,21 @@ public:
 
     std::string getDevice() const;
 
+    void setSinkGroup(SinkGroup *group);
+
+    void setSourceId(int sourceId);
+
+    void setCapture(CaptureLog *capture);
+
+    /* read the device through io_uring if the kernel has it. Has to be set
+     * before start(). */
+    void setIoUring(bool enable);
+
+    /* how the reader thread runs. Has to be set before start(). */
+    void setIngest(const ingestOptions_t &options);
+
+    int getSourceId() const;
+
     int getBaudRate() const;
 
     bool isRunning() const;
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the shared memory ring.
+ */
+
+#include "ShmRing.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+
+#include <cstring>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+/*----------------------------------------------------------------------------*/
+ShmRing::ShmRing(const std::string name)
+{
+  // shm_open wants a name of the form /name
+  if(!name.empty() && name[0] != '/') {
+    this->name = "/" + name;
+  } else {
+    this->name = name;
+  }
+  this->header = NULL;
+  this->slots = NULL;
+  this->mapLength = 0;
+  this->unnotified = false;
+}
+/*----------------------------------------------------------------------------*/
+ShmRing::~ShmRing()
+{
+  close();
+}
+/*----------------------------------------------------------------------------*/
+int
+ShmRing::open()
+{
+  int fd;
+  void *map;
+
+  if((SHMRING_SLOTS & (SHMRING_SLOTS - 1)) != 0) {
+    errno = EINVAL;
+    ERROR("ShmRing::open : SHMRING_SLOTS is not a power of two");
+    return -1;
+  }
+
+  // a ring left behind by an earlier run; readers still mapping it keep
+  // the old one
+  shm_unlink(name.c_str());
+  fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if(fd < 0) {
+    ERROR("Can not create shared memory " << name);
+    return -1;
+  }
+
+  mapLength = sizeof(shmRingHeader_t) +
+              (size_t)SHMRING_SLOTS * sizeof(shmRingSlot_t);
+  if(ftruncate(fd, mapLength) < 0) {
+    ERROR("Can not size shared memory " << name);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return -1;
+  }
+  map = mmap(NULL, mapLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if(map == MAP_FAILED) {
+    ERROR("Can not map shared memory " << name);
+    shm_unlink(name.c_str());
+    return -1;
+  }
+
+  // the object is zero filled, so every slot starts out empty
+  header = (shmRingHeader_t *)map;
+  slots = (char *)map + sizeof(shmRingHeader_t);
+  header->version = SHMRING_VERSION;
+  header->headerLen = sizeof(shmRingHeader_t);
+  header->slotCount = SHMRING_SLOTS;
+  header->slotSize = sizeof(shmRingSlot_t);
+  // a reader checks the magic first, it is written once the rest is there
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(header->magic, SHMRING_MAGIC, sizeof(header->magic));
+
+  DEBUG("ShmRing::open : " << name << ", " << mapLength << " bytes");
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+ShmRing::publish(const Packet &packet)
+{
+  uint64_t seq;
+  shmRingSlot_t *slot;
+  int len = packet.getPacketLength();
+
+  if(header == NULL) {
+    return;
+  }
+  seq = header->published;
+  slot = (shmRingSlot_t *)(slots + (seq & (SHMRING_SLOTS - 1)) *
+                                   sizeof(shmRingSlot_t));
+
+  // readers copying the old record see it change and skip it
+  __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  slot->timestamp = packet.getTimestamp();
+  slot->length = len;
+  slot->type = packet.getPacketType();
+  slot->source = packet.getSource();
+  memcpy(slot->payload, packet.getPayload(), len);
+
+  __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&header->published, seq + 1, __ATOMIC_RELEASE);
+  unnotified = true;
+}
+/*----------------------------------------------------------------------------*/
+void
+ShmRing::notify()
+{
+  if(header == NULL || !unnotified) {
+    return;
+  }
+  unnotified = false;
+  // readers map the ring read only, so they can not tell us whether they
+  // wait; one wake a batch is cheap next to the writes it follows
+  __atomic_add_fetch(&header->wake, 1, __ATOMIC_RELEASE);
+  syscall(SYS_futex, &header->wake, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+/*----------------------------------------------------------------------------*/
+void
+ShmRing::close()
+{
+  if(header != NULL) {
+    munmap(header, mapLength);
+    header = NULL;
+    slots = NULL;
+    shm_unlink(name.c_str());
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+ShmRing::isOpen() const
+{
+  return header != NULL;
+}
+/*----------------------------------------------------------------------------*/
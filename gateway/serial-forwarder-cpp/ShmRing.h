@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+
+/* \file
+ *      Header file of the shared memory ring.
+ *      A POSIX shared memory object holding a ring of the packets read from
+ *      the serial side, for consumers on the same host that do not want to
+ *      go through a socket. The forwarder is the only writer, readers map
+ *      the object read only and keep their own cursor, so nothing they do
+ *      slows the forwarder down. A reader that falls a whole ring behind
+ *      loses packets and has to notice it, see below.
+ *      Everything is in host byte order.
+ *
+ *      header : magic (8) | version (2) | header length (2) |
+ *               slot count (4) | slot size (4) | 0 (4),
+ *               then on cache lines of their own the sequence of the next
+ *               record (8) and the wake word (4)
+ *      slots  : slot count slots of slot size bytes from header length on,
+ *               record n in slot n % slot count
+ *      slot   : seq (8) | time in ns (8) | length (2) | type (1) | sink (1)
+ *               | 0 (4) | payload
+ *
+ *      The seq of a slot is n + 1 when it holds record n and 0 while the
+ *      forwarder writes it. To read record n, a reader loads seq, copies
+ *      the record and loads seq again; if seq was n + 1 both times the copy
+ *      is good. A higher seq means the record was overwritten, the reader
+ *      lost packets and goes on from the oldest record still in the ring,
+ *      published - slot count. A lower one means record n is not there
+ *      yet.
+ *      With nothing to read, a reader waits on the wake word with
+ *      FUTEX_WAIT, passing the value it had before it last looked at
+ *      published. The forwarder adds one to the word and wakes every
+ *      waiter after each batch of records.
+ */
+
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include "PacketBuffer.h"
+
+#define SHMRING_MAGIC "TIKIRISM"
+#define SHMRING_VERSION 1
+
+/* Records the ring holds, a power of two. */
+#ifdef CONF_SHMRING_SLOTS
+#define SHMRING_SLOTS CONF_SHMRING_SLOTS
+#else
+#define SHMRING_SLOTS 4096
+#endif
+
+typedef struct shmRingHeader {
+  char magic[8];
+  uint16_t version;
+  uint16_t headerLen;
+  uint32_t slotCount;
+  uint32_t slotSize;
+  uint32_t reserved;
+  /* sequence of the next record */
+  volatile uint64_t published __attribute__((aligned(CACHE_LINE_SIZE)));
+  /* futex word readers wait on */
+  volatile uint32_t wake __attribute__((aligned(CACHE_LINE_SIZE)));
+} __attribute__((aligned(CACHE_LINE_SIZE))) shmRingHeader_t;
+
+typedef struct shmRingSlot {
+  volatile uint64_t seq;
+  uint64_t timestamp;
+  uint16_t length;
+  uint8_t type;
+  uint8_t source;
+  uint32_t reserved;
+  char payload[MAX_PKT_SIZE];
+} __attribute__((aligned(CACHE_LINE_SIZE))) shmRingSlot_t;
+
+class ShmRing
+{
+  protected:
+
+    /* name of the shared memory object, starting with a slash */
+    std::string name;
+
+    shmRingHeader_t *header;
+
+    char *slots;
+
+    size_t mapLength;
+
+    /* records published since readers were last woken */
+    bool unnotified;
+
+  public:
+
+    ShmRing(const std::string name);
+
+    ~ShmRing();
+
+    /* creates the object, replacing one left behind by an earlier run */
+    int open();
+
+    /* puts packet into the ring, only to be called by one thread */
+    void publish(const Packet &packet);
+
+    /* wakes the readers if anything was published since the last call */
+    void notify();
+
+    /* unmaps and removes the object, readers that have it mapped keep
+     * it */
+    void close();
+
+    bool isOpen() const;
+
+};
+
+#endif /* SHMRING_H */
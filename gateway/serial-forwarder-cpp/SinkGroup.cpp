@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the sink group module.
+ */
+
+#include "SinkGroup.h"
+
+#include <errno.h>
+#include <string.h>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+using namespace std;
+
+/* forward declaration of pthread helper function */
+void* sinkFanoutThread(void*);
+
+/*---------------------------------------------------------------------------*/
+SinkGroup::SinkGroup(PacketBuffer &readBuffer,
+                     PacketBuffer &writeBuffer) : readBuffer(readBuffer),
+                                                  writeBuffer(writeBuffer)
+{
+  this->fanoutThreadRunning = false;
+  this->capture = NULL;
+  this->useIoUring = false;
+  this->ingest.lowLatency = false;
+  this->ingest.cpu = -1;
+  this->ingest.fifoPriority = 0;
+  this->writeBufferSize = SINK_WRITE_BUFFER_SIZE;
+  pthread_mutex_init(&replyLock, NULL);
+}
+/*---------------------------------------------------------------------------*/
+SinkGroup::~SinkGroup()
+{
+  unsigned int i;
+
+  for(i = 0; i < sinks.size(); i++) {
+    delete sinks[i];
+  }
+  for(i = 0; i < sinkWriteBuffers.size(); i++) {
+    delete sinkWriteBuffers[i];
+  }
+  pthread_mutex_destroy(&replyLock);
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::addSink(const std::string device, int baudrate)
+{
+  devices.push_back(device);
+  baudrates.push_back(baudrate);
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::setCapture(CaptureLog *capture)
+{
+  this->capture = capture;
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::setIoUring(bool enable)
+{
+  this->useIoUring = enable;
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::setIngest(const ingestOptions_t &options)
+{
+  this->ingest = options;
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::setWriteBufferSize(int packets)
+{
+  this->writeBufferSize = packets;
+}
+/*---------------------------------------------------------------------------*/
+int
+SinkGroup::start()
+{
+  unsigned int i;
+  int retValue;
+
+  if(devices.size() == 1) {
+    sinks.push_back(new SerialComm(devices[0], baudrates[0],
+                                   readBuffer, writeBuffer));
+    sinks[0]->setSourceId(1);
+  } else {
+    // Every sink gets its own copy of the packets to be written, so a
+    // slow or dead sink does not hold back the others.
+    for(i = 0; i < devices.size(); i++) {
+      PacketBuffer *buffer = new PacketBuffer("WriteBuffer-" + devices[i],
+                                              writeBufferSize);
+      sinkWriteBuffers.push_back(buffer);
+      SerialComm *sink = new SerialComm(devices[i], baudrates[i],
+                                        readBuffer, *buffer);
+      sink->setSinkGroup(this);
+      sink->setSourceId(i + 1);
+      sinks.push_back(sink);
+    }
+
+    retValue = pthread_create(&fanoutThread, NULL, sinkFanoutThread, this);
+    if (retValue != 0) {
+      ERROR("Can not start sink fanout thread");
+      return -1;
+    }
+    this->fanoutThreadRunning = true;
+  }
+
+  for(i = 0; i < sinks.size(); i++) {
+    sinks[i]->setCapture(capture);
+    sinks[i]->setIoUring(useIoUring);
+    sinks[i]->setIngest(ingest);
+    if(sinks[i]->start() < 0) {
+      return -1;
+    }
+  }
+
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/* helper function to start fanout pthread */
+void*
+sinkFanoutThread(void* ob)
+{
+  static_cast<SinkGroup*>(ob)->fanout();
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+SinkGroup::fanout()
+{
+  Packet packet;
+  unsigned int i, first, last;
+
+  while(true) {
+    packet = writeBuffer.dequeue();
+    if(packet.getSource() == PKT_SOURCE_ANY) {
+      first = 0;
+      last = sinkWriteBuffers.size();
+    } else if(packet.getSource() <= (int)sinkWriteBuffers.size()) {
+      first = packet.getSource() - 1;
+      last = first + 1;
+    } else {
+      DEBUG("SinkGroup::fanout : no sink " << packet.getSource()
+            << ". Dropping the packet");
+      continue;
+    }
+    for(i = first; i < last; i++) {
+      if(!sinkWriteBuffers[i]->tryEnqueueBack(packet)) {
+        DEBUG("SinkGroup::fanout : warning! write buffer of "
+              << sinks[i]->getDevice() << " full. Dropping the packet");
+      }
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+bool
+SinkGroup::isDuplicate(const Packet &packet)
+{
+  const unsigned char *p = (const unsigned char *)packet.getPayload();
+  uint64_t key;
+  bool duplicate;
+
+  if(sinks.size() <= 1 ||
+     packet.getPacketType() != PKT_TYPE_DATA ||
+     packet.getPacketLength() < QREPLY_HEADER_LEN ||
+     p[0] != MSG_QREPLY) {
+    return false;
+  }
+
+  // A result is identified by the query, the epoch and the node it is from.
+  key = ((uint64_t)p[QREPLY_QID] << 32) |
+        ((uint64_t)p[QREPLY_EPOCH] << 24) |
+        ((uint64_t)p[QREPLY_EPOCH + 1] << 16) |
+        ((uint64_t)p[QREPLY_NODEADDR] << 8) |
+        (uint64_t)p[QREPLY_NODEADDR + 1];
+
+  pthread_mutex_lock(&replyLock);
+  duplicate = !replies.insert(key).second;
+  if(!duplicate) {
+    replyOrder.push_back(key);
+    if(replyOrder.size() > SINK_REPLY_WINDOW) {
+      replies.erase(replyOrder.front());
+      replyOrder.pop_front();
+    }
+  }
+  pthread_mutex_unlock(&replyLock);
+
+  return duplicate;
+}
+/*---------------------------------------------------------------------------*/
+int
+SinkGroup::size() const
+{
+  return devices.size();
+}
+/*---------------------------------------------------------------------------*/
+/* cancels all running threads */
+void
+SinkGroup::cancel()
+{
+  unsigned int i;
+
+  if(fanoutThreadRunning) {
+    pthread_cancel(fanoutThread);
+    DEBUG("SinkGroup::cancel : fanoutThread canceled, joining")
+    pthread_join(fanoutThread, NULL);
+    fanoutThreadRunning = false;
+  }
+  for(i = 0; i < sinks.size(); i++) {
+    sinks[i]->cancel();
+  }
+}
+/*---------------------------------------------------------------------------*/
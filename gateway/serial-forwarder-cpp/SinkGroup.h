@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the sink group module. A sink group is a set of sink
+ *      motes attached to this serial forwarder. Packets read from any of
+ *      them are merged into one read buffer, tagged with the number of the
+ *      sink. A packet to be written goes to the sink it is tagged with, or
+ *      to all of them if it is tagged with PKT_SOURCE_ANY.
+ */
+
+#ifndef SINKGROUP_H
+#define SINKGROUP_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <set>
+
+#include "Packet.h"
+#include "PacketBuffer.h"
+#include "SerialComm.h"
+#include "CaptureLog.h"
+
+/* Write buffer size of each sink when there is more than one. */
+#ifdef CONF_SINK_WRITE_BUFFER_SIZE
+#define SINK_WRITE_BUFFER_SIZE CONF_SINK_WRITE_BUFFER_SIZE
+#else
+#define SINK_WRITE_BUFFER_SIZE 25
+#endif
+
+/* Number of recent query results remembered to drop the copies that more
+ * than one sink received. */
+#ifdef CONF_SINK_REPLY_WINDOW
+#define SINK_REPLY_WINDOW CONF_SINK_REPLY_WINDOW
+#else
+#define SINK_REPLY_WINDOW 256
+#endif
+
+class SinkGroup
+{
+  protected:
+
+    /* packet buffer for read packets from all sinks */
+    PacketBuffer &readBuffer;
+
+    /* packet buffer for packets to be written to all sinks */
+    PacketBuffer &writeBuffer;
+
+    std::vector<std::string> devices;
+    std::vector<int> baudrates;
+
+    /* created by start() */
+    std::vector<SerialComm *> sinks;
+
+    /* write buffer of each sink, only used with more than one sink */
+    std::vector<PacketBuffer *> sinkWriteBuffers;
+
+    /* Pthread copying writeBuffer to the sink write buffers. */
+    pthread_t fanoutThread;
+
+    bool fanoutThreadRunning;
+
+    /* log the frames of all sinks go to, NULL if none */
+    CaptureLog *capture;
+
+    /* whether the sinks read through io_uring */
+    bool useIoUring;
+
+    /* how the reader threads of the sinks run */
+    ingestOptions_t ingest;
+
+    /* packets the write buffer of each sink holds */
+    int writeBufferSize;
+
+    /* Results seen recently, oldest first in replyOrder. */
+    pthread_mutex_t replyLock;
+    std::set<uint64_t> replies;
+    std::deque<uint64_t> replyOrder;
+
+  private:
+    // Do not allow standard constructor
+    SinkGroup();
+
+  protected:
+
+    /* copies packets to their sinks - consumer thread */
+    void fanout();
+
+    /* Needed to start pthreads. */
+    friend void* sinkFanoutThread(void* ob);
+
+  public:
+    SinkGroup(PacketBuffer &readBuffer, PacketBuffer &writeBuffer);
+
+    ~SinkGroup();
+
+    /* Adds a sink. Sinks have to be added before start(). */
+    void addSink(const std::string device, int baudrate);
+
+    /* Appends every frame read to capture. Has to be set before start(). */
+    void setCapture(CaptureLog *capture);
+
+    /* Reads the sinks through io_uring if the kernel has it. Has to be set
+     * before start(). */
+    void setIoUring(bool enable);
+
+    /* How the reader threads of the sinks run, all of them on the same
+     * CPU if one is given. Has to be set before start(). */
+    void setIngest(const ingestOptions_t &options);
+
+    /* Packets the write buffer of each of several sinks holds. Has to be
+     * set before start(). */
+    void setWriteBufferSize(int packets);
+
+    /* Starts all sinks. */
+    int start();
+
+    /* Cancels all running threads */
+    void cancel();
+
+    /* true if packet is a query result already read from another sink */
+    bool isDuplicate(const Packet &packet);
+
+    int size() const;
+};
+
+#endif /* SINKGROUP_H */
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the SLIP codec.
+ */
+
+#include "SlipCodec.h"
+
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//#define DEBUG_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+/*----------------------------------------------------------------------------*/
+SlipCodec::SlipCodec()
+{
+  reset();
+}
+/*----------------------------------------------------------------------------*/
+void
+SlipCodec::reset()
+{
+  escaped = false;
+  received = 0;
+  truncated = false;
+  errors = 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+SlipCodec::takeErrors()
+{
+  int n = errors;
+
+  errors = 0;
+  return n;
+}
+/*----------------------------------------------------------------------------*/
+int
+SlipCodec::findSpecial(const char *data, int len)
+{
+  int i = 0;
+
+#ifdef __SSE2__
+  const __m128i end = _mm_set1_epi8((char)SLIP_END);
+  const __m128i esc = _mm_set1_epi8((char)SLIP_ESC);
+  __m128i v;
+  int mask;
+
+  // 16 bytes at a time, one bit of mask per special byte
+  for(; i + 16 <= len; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(data + i));
+    mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, end),
+                                          _mm_cmpeq_epi8(v, esc)));
+    if(mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif /* __SSE2__ */
+
+  for(; i < len; i++) {
+    if((unsigned char)data[i] == SLIP_END ||
+       (unsigned char)data[i] == SLIP_ESC) {
+      return i;
+    }
+  }
+  return len;
+}
+/*----------------------------------------------------------------------------*/
+int
+SlipCodec::decode(const char *in, int inLen, char *frame, int frameSize,
+                  int &frameLen)
+{
+  int pos = 0;
+  int run, n;
+  unsigned char c;
+
+  frameLen = 0;
+  while(pos < inLen) {
+    if(escaped) {
+      escaped = false;
+      c = in[pos++];
+      switch(c) {
+        case SLIP_ESC_END:
+          c = SLIP_END;
+          break;
+        case SLIP_ESC_ESC:
+          c = SLIP_ESC;
+          break;
+        case DEBUG_MAKER:
+          break;
+        default:
+          DEBUG("SlipCodec::decode : protocol error.");
+          errors++;
+      }
+      if(received < frameSize) {
+        frame[received++] = c;
+      } else {
+        truncated = true;
+      }
+      continue;
+    }
+
+    // copy the run of plain bytes in front of the next special one
+    run = findSpecial(in + pos, inLen - pos);
+    n = frameSize - received;
+    if(n > run) {
+      n = run;
+    }
+    if(n > 0) {
+      memcpy(frame + received, in + pos, n);
+      received += n;
+    }
+    if(n < run) {
+      truncated = true;
+    }
+    pos += run;
+    if(pos == inLen) {
+      break;
+    }
+
+    if((unsigned char)in[pos++] == SLIP_ESC) {
+      escaped = true;
+    } else if(received > 0) {
+      // SLIP_END of a frame, the ones in front of a frame are skipped
+      frameLen = received;
+      received = 0;
+      if(truncated) {
+        errors++;
+        truncated = false;
+      }
+      return pos;
+    }
+  }
+  return pos;
+}
+/*----------------------------------------------------------------------------*/
+int
+SlipCodec::encode(const char *in, int len, char *out)
+{
+  int i = 0;
+  int k = 0;
+  int run;
+
+  // a leading SLIP_END flushes any line noise in front of the frame
+  out[k++] = SLIP_END;
+  while(i < len) {
+    run = findSpecial(in + i, len - i);
+    memcpy(out + k, in + i, run);
+    k += run;
+    i += run;
+    if(i == len) {
+      break;
+    }
+    out[k++] = SLIP_ESC;
+    out[k++] = ((unsigned char)in[i] == SLIP_END) ? SLIP_ESC_END : SLIP_ESC_ESC;
+    i++;
+  }
+  out[k++] = SLIP_END;
+  return k;
+}
+/*----------------------------------------------------------------------------*/
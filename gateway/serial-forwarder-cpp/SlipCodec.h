@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      SLIP codec header file.
+ *      Frames are scanned for the SLIP_END and SLIP_ESC bytes a block at a
+ *      time and the runs between them are copied in bulk.
+ */
+
+#ifndef SLIPCODEC_H
+#define SLIPCODEC_H
+
+#define SLIP_END             0300    /* indicates end of packet */
+#define SLIP_ESC             0333    /* indicates byte stuffing */
+#define SLIP_ESC_END         0334    /* SLIP_ESC SLIP_ESC_END means SLIP_END data byte */
+#define SLIP_ESC_ESC         0335    /* SLIP_ESC SLIP_ESC_ESC means ESC data byte */
+#define DEBUG_MAKER          0015    /* \r used to distinguish debug messages */
+
+/* largest encoding of len bytes, every byte escaped and framed by SLIP_END */
+#define SLIP_ENCODED_SIZE(len) (2 * (len) + 2)
+
+class SlipCodec
+{
+  protected:
+
+    /* the last byte decoded was SLIP_ESC */
+    bool escaped;
+
+    /* bytes of the current frame decoded so far */
+    int received;
+
+    /* bytes of the current frame were dropped for lack of room */
+    bool truncated;
+
+    /* bad escapes and truncated frames since the last takeErrors() */
+    int errors;
+
+  public:
+
+    SlipCodec();
+
+    /* forget a partly decoded frame */
+    void reset();
+
+    /* returns the number of errors found since the last call */
+    int takeErrors();
+
+    /*
+     * Decodes in until a frame ends or in is used up and returns the
+     * number of bytes consumed. The frame is decoded into frame, which
+     * must be the same buffer until it is complete; bytes beyond
+     * frameSize are dropped. frameLen is set to the length of the frame
+     * once it is complete and to 0 otherwise.
+     */
+    int decode(const char *in, int inLen, char *frame, int frameSize,
+               int &frameLen);
+
+    /* encodes len bytes into out, which must hold SLIP_ENCODED_SIZE(len)
+     * bytes, and returns the encoded length */
+    static int encode(const char *in, int len, char *out);
+
+    /* returns the offset of the first SLIP_END or SLIP_ESC, or len */
+    static int findSpecial(const char *data, int len);
+
+};
+
+#endif /* SLIPCODEC_H */
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the stats server.
+ */
+
+#include "StatsServer.h"
+#include "Metrics.h"
+#include "PacketPool.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+//#define DEBUG_EABLE 1
+#define ERROR_EABLE 1
+
+#if DEBUG_EABLE
+#include <iostream>
+#define DEBUG(message) std::cout << message << std::endl;
+#else
+#define DEBUG(message)
+#endif
+
+#if ERROR_EABLE
+#include <iostream>
+#define ERROR(message) std::cerr << message << " : " << strerror(errno) << std::endl;
+#else
+#define ERROR(message)
+#endif
+
+#define MAX_REQUEST_SIZE 512
+
+using namespace std;
+
+void* statsServerThreadFunc(void* ob);
+
+/*----------------------------------------------------------------------------*/
+/* how long the oldest frame queued to a client has been in the forwarder */
+static uint64_t
+clientLag(const clientMetrics_t &client, uint64_t now)
+{
+  if(client.oldestStamp == 0 || now < client.oldestStamp) {
+    return 0;
+  }
+  return now - client.oldestStamp;
+}
+
+/*----------------------------------------------------------------------------*/
+StatsServer::StatsServer(const std::string address, TCPComm &tcpComm,
+                         PacketBuffer &readBuffer, PacketBuffer &writeBuffer)
+                         : tcpComm(tcpComm), readBuffer(readBuffer),
+                           writeBuffer(writeBuffer)
+{
+  this->address = address;
+  this->serverFD = -1;
+  this->startTime = Metrics::now();
+  this->serverThreadRunning = false;
+}
+/*----------------------------------------------------------------------------*/
+StatsServer::~StatsServer()
+{
+  cancel();
+}
+/*----------------------------------------------------------------------------*/
+int
+StatsServer::start()
+{
+  struct sockaddr_in in;
+  struct sockaddr_un un;
+  int yes = 1;
+  int ret;
+
+  if(!address.empty() &&
+     address.find_first_not_of("0123456789") == std::string::npos) {
+    // a port, only reachable from this host
+    serverFD = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(serverFD < 0) {
+      ERROR("StatsServer::start : Can not create a socket");
+      return -1;
+    }
+    setsockopt(serverFD, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(atoi(address.c_str()));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ret = bind(serverFD, (struct sockaddr *)&in, sizeof(in));
+  } else {
+    if(address.size() >= sizeof(un.sun_path)) {
+      errno = ENAMETOOLONG;
+      ERROR("StatsServer::start : Can not use socket " << address);
+      return -1;
+    }
+    serverFD = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(serverFD < 0) {
+      ERROR("StatsServer::start : Can not create a socket");
+      return -1;
+    }
+    // a socket left behind by an earlier run
+    unlink(address.c_str());
+    memset(&un, 0, sizeof(un));
+    un.sun_family = AF_UNIX;
+    strcpy(un.sun_path, address.c_str());
+    ret = bind(serverFD, (struct sockaddr *)&un, sizeof(un));
+    if(ret == 0) {
+      socketPath = address;
+    }
+  }
+
+  if(ret < 0 || listen(serverFD, 8) < 0) {
+    ERROR("StatsServer::start : Can not listen on " << address);
+    close(serverFD);
+    serverFD = -1;
+    return -1;
+  }
+
+  ret = pthread_create(&serverThread, NULL, statsServerThreadFunc, this);
+  if(ret != 0) {
+    ERROR("StatsServer::start : Could not start stats server thread");
+    return -1;
+  }
+  serverThreadRunning = true;
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+void *
+statsServerThreadFunc(void* ob)
+{
+  static_cast<StatsServer*>(ob)->serve();
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+void
+StatsServer::serve()
+{
+  int fd;
+
+  while(true) {
+    fd = accept(serverFD, NULL, NULL);
+    if(fd < 0) {
+      if(errno != EINTR && errno != ECONNABORTED) {
+        ERROR("StatsServer::serve : Could not accept");
+      }
+      continue;
+    }
+    report(fd);
+    close(fd);
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+StatsServer::report(int fd)
+{
+  char request[MAX_REQUEST_SIZE + 1];
+  struct pollfd pfd;
+  std::string line, body, reply;
+  std::ostringstream head;
+  bool http, json;
+  int k = 0;
+
+  // a client that sends nothing gets the text report
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  if(poll(&pfd, 1, STATS_REQUEST_TIMEOUT) > 0) {
+    k = recv(fd, request, MAX_REQUEST_SIZE, 0);
+    if(k < 0) {
+      k = 0;
+    }
+  }
+  request[k] = '\0';
+  line = request;
+  line = line.substr(0, line.find_first_of("\r\n"));
+
+  http = line.compare(0, 4, "GET ") == 0;
+  if(http) {
+    line = line.substr(4, line.find(' ', 4) - 4);
+    json = line.find(".json") != std::string::npos ||
+           line.find("format=json") != std::string::npos;
+  } else {
+    json = line == "json";
+  }
+
+  body = json ? renderJSON() : renderText();
+  if(http) {
+    head << "HTTP/1.0 200 OK\r\n"
+         << "Content-Type: " << (json ? "application/json" : "text/plain")
+         << "\r\n"
+         << "Content-Length: " << body.size() << "\r\n"
+         << "Connection: close\r\n\r\n";
+    reply = head.str() + body;
+  } else {
+    reply = body;
+  }
+
+  if(writeAll(fd, reply.data(), reply.size()) != reply.size()) {
+    DEBUG("StatsServer::report : Can not send the report");
+  }
+  shutdown(fd, SHUT_WR);
+}
+/*----------------------------------------------------------------------------*/
+std::string
+StatsServer::renderText()
+{
+  Metrics &metrics = Metrics::instance();
+  std::ostringstream out;
+  std::vector<clientMetrics_t> clients;
+  histogramSummary_t summary;
+  packetPoolStats_t pool;
+  PacketBuffer *buffers[2] = {&readBuffer, &writeBuffer};
+  uint64_t now = Metrics::now();
+  int i, l, p;
+
+  out << "uptime_ms " << (now - startTime) / 1000000 << "\n";
+  for(i = 0; i < METRIC_COUNTERS; i++) {
+    out << Metrics::counterName(i) << " " << metrics.get(i) << "\n";
+  }
+
+  for(i = 0; i < 2; i++) {
+    out << "buffer " << buffers[i]->getName()
+        << " depth=" << buffers[i]->getDepth()
+        << " capacity=" << buffers[i]->getCapacity() << " lanes=";
+    for(l = 0; l < PKT_LANES; l++) {
+      out << (l > 0 ? "," : "") << buffers[i]->getDepth(l);
+    }
+    out << "\n";
+  }
+
+  PacketPool::instance().getStats(pool);
+  out << "pool inuse=" << pool.inUse << " size=" << pool.size
+      << " peak=" << pool.peak << " misses=" << pool.misses << "\n";
+
+  for(i = 0; i < METRIC_HISTOGRAMS; i++) {
+    metrics.getHistogram(i).summarize(summary);
+    out << Metrics::histogramName(i) << " count=" << summary.count
+        << " mean=" << (summary.count > 0 ? summary.sum / summary.count : 0);
+    for(p = 0; p < HISTOGRAM_PERCENTILES; p++) {
+      out << " p" << Histogram::percentiles[p] / 10;
+      if(Histogram::percentiles[p] % 10 != 0) {
+        out << "." << Histogram::percentiles[p] % 10;
+      }
+      out << "=" << summary.percentile[p];
+    }
+    out << " max=" << summary.max << "\n";
+  }
+
+  tcpComm.getClientMetrics(clients);
+  for(i = 0; i < (int)clients.size(); i++) {
+    out << "client fd=" << clients[i].fd << " port=" << clients[i].port
+        << " mode=" << clients[i].mode << " policy=" << clients[i].policy
+        << " version=" << clients[i].version
+        << " queued=" << clients[i].queued
+        << " dropped=" << clients[i].dropped
+        << " highwater=" << clients[i].highWater
+        << " length=" << clients[i].length
+        << " bytes_out=" << clients[i].bytesOut
+        << " lag_ns=" << clientLag(clients[i], now)
+        << "\n";
+  }
+  return out.str();
+}
+/*----------------------------------------------------------------------------*/
+std::string
+StatsServer::renderJSON()
+{
+  Metrics &metrics = Metrics::instance();
+  std::ostringstream out;
+  std::vector<clientMetrics_t> clients;
+  histogramSummary_t summary;
+  packetPoolStats_t pool;
+  PacketBuffer *buffers[2] = {&readBuffer, &writeBuffer};
+  uint64_t now = Metrics::now();
+  int i, l, p;
+
+  out << "{\"uptime_ms\":" << (now - startTime) / 1000000;
+
+  out << ",\"counters\":{";
+  for(i = 0; i < METRIC_COUNTERS; i++) {
+    out << (i > 0 ? "," : "") << "\"" << Metrics::counterName(i) << "\":"
+        << metrics.get(i);
+  }
+
+  out << "},\"buffers\":{";
+  for(i = 0; i < 2; i++) {
+    out << (i > 0 ? "," : "") << "\"" << buffers[i]->getName() << "\":"
+        << "{\"depth\":" << buffers[i]->getDepth()
+        << ",\"capacity\":" << buffers[i]->getCapacity() << ",\"lanes\":[";
+    for(l = 0; l < PKT_LANES; l++) {
+      out << (l > 0 ? "," : "") << buffers[i]->getDepth(l);
+    }
+    out << "]}";
+  }
+
+  PacketPool::instance().getStats(pool);
+  out << "},\"pool\":{\"inuse\":" << pool.inUse << ",\"size\":" << pool.size
+      << ",\"peak\":" << pool.peak << ",\"misses\":" << pool.misses << "}";
+
+  out << ",\"histograms\":{";
+  for(i = 0; i < METRIC_HISTOGRAMS; i++) {
+    metrics.getHistogram(i).summarize(summary);
+    out << (i > 0 ? "," : "") << "\"" << Metrics::histogramName(i) << "\":"
+        << "{\"count\":" << summary.count << ",\"sum\":" << summary.sum
+        << ",\"max\":" << summary.max;
+    for(p = 0; p < HISTOGRAM_PERCENTILES; p++) {
+      out << ",\"p" << Histogram::percentiles[p] << "\":"
+          << summary.percentile[p];
+    }
+    out << "}";
+  }
+
+  out << "},\"clients\":[";
+  tcpComm.getClientMetrics(clients);
+  for(i = 0; i < (int)clients.size(); i++) {
+    out << (i > 0 ? "," : "")
+        << "{\"fd\":" << clients[i].fd << ",\"port\":" << clients[i].port
+        << ",\"mode\":" << clients[i].mode
+        << ",\"policy\":" << clients[i].policy
+        << ",\"version\":" << clients[i].version
+        << ",\"queued\":" << clients[i].queued
+        << ",\"dropped\":" << clients[i].dropped
+        << ",\"highwater\":" << clients[i].highWater
+        << ",\"length\":" << clients[i].length
+        << ",\"bytes_out\":" << clients[i].bytesOut
+        << ",\"lag_ns\":" << clientLag(clients[i], now)
+        << "}";
+  }
+  out << "]}\n";
+  return out.str();
+}
+/*----------------------------------------------------------------------------*/
+void
+StatsServer::cancel()
+{
+  if(serverThreadRunning) {
+    pthread_cancel(serverThread);
+    pthread_join(serverThread, NULL);
+    serverThreadRunning = false;
+  }
+  if(serverFD >= 0) {
+    close(serverFD);
+    serverFD = -1;
+  }
+  if(!socketPath.empty()) {
+    unlink(socketPath.c_str());
+    socketPath.clear();
+  }
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the stats server.
+ *      Serves the metrics of the forwarder on a local TCP port or a Unix
+ *      socket, away from the client port. A connection gets one report and
+ *      is closed. The report is text unless the first line asks for json;
+ *      "GET /metrics" and "GET /metrics.json" are answered over HTTP, so a
+ *      browser or curl can read it too.
+ *
+ *      Everything is read from the counters the packet path updates, no
+ *      lock of the packet path is taken.
+ */
+
+#ifndef STATSSERVER_H
+#define STATSSERVER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "BaseComm.h"
+#include "PacketBuffer.h"
+#include "TCPComm.h"
+
+/* How long a new connection may take to send its request, in ms. */
+#ifdef CONF_STATS_REQUEST_TIMEOUT
+#define STATS_REQUEST_TIMEOUT CONF_STATS_REQUEST_TIMEOUT
+#else
+#define STATS_REQUEST_TIMEOUT 200
+#endif
+
+class StatsServer : public BaseComm
+{
+  protected:
+
+    /* port number, or the path of a Unix socket */
+    std::string address;
+
+    /* path of the Unix socket to remove, empty for a TCP port */
+    std::string socketPath;
+
+    int serverFD;
+
+    TCPComm &tcpComm;
+
+    PacketBuffer &readBuffer;
+
+    PacketBuffer &writeBuffer;
+
+    uint64_t startTime;
+
+    pthread_t serverThread;
+
+    bool serverThreadRunning;
+
+    void serve();
+
+    /* answer one connection */
+    void report(int fd);
+
+    std::string renderText();
+
+    std::string renderJSON();
+
+    friend void* statsServerThreadFunc(void* ob);
+
+  private:
+    // Do not allow standard constructor
+    StatsServer();
+
+  public:
+
+    StatsServer(const std::string address, TCPComm &tcpComm,
+                PacketBuffer &readBuffer, PacketBuffer &writeBuffer);
+
+    ~StatsServer();
+
+    /* listen on the address and start serving reports */
+    int start();
+
+    void cancel();
+
+};
+
+#endif /* STATSSERVER_H */
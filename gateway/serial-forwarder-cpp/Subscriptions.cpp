@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Implementation of the subscription index.
+ */
+
+#include "Subscriptions.h"
+
+#include <algorithm>
+
+using namespace std;
+
+/*----------------------------------------------------------------------------*/
+Subscriptions::Subscriptions()
+{
+  round = 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::clear()
+{
+  int i;
+
+  subscribers.clear();
+  unfiltered.clear();
+  anyQid.clear();
+  for(i = 0; i < 256; i++) {
+    byQid[i].clear();
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::addReader(int fd)
+{
+  subscriber_t &s = subscribers[fd];
+
+  s.fd = fd;
+  s.filters.clear();
+  s.mark = round;
+  index(&s);
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::removeReader(int fd)
+{
+  map<int, subscriber_t>::iterator it = subscribers.find(fd);
+
+  if(it == subscribers.end()) {
+    return;
+  }
+  unindex(&it->second);
+  subscribers.erase(it);
+}
+/*----------------------------------------------------------------------------*/
+int
+Subscriptions::subscribe(int fd, const char *data, int len)
+{
+  map<int, subscriber_t>::iterator it = subscribers.find(fd);
+  filter_t f;
+  int i;
+
+  if(it == subscribers.end() || len % FILTER_LEN != 0 ||
+     len / FILTER_LEN > MAX_CLIENT_FILTERS) {
+    return -1;
+  }
+
+  unindex(&it->second);
+  it->second.filters.clear();
+  for(i = 0; i < len; i += FILTER_LEN) {
+    f.fields = data[i];
+    f.pktType = data[i + 1];
+    f.msgType = data[i + 2];
+    f.qid = data[i + 3];
+    f.node[0] = data[i + 4];
+    f.node[1] = data[i + 5];
+    it->second.filters.push_back(f);
+  }
+  index(&it->second);
+  return it->second.filters.size();
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::index(subscriber_t *s)
+{
+  vector<filter_t>::iterator f;
+
+  if(s->filters.empty()) {
+    unfiltered.push_back(s->fd);
+    return;
+  }
+  for(f = s->filters.begin(); f != s->filters.end(); f++) {
+    if(f->fields & FILTER_QID) {
+      byQid[f->qid].push_back(make_pair(s, *f));
+    } else {
+      anyQid.push_back(make_pair(s, *f));
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::unindex(subscriber_t *s)
+{
+  vector<filter_t>::iterator f;
+  filterList_t *list;
+  unsigned int i;
+
+  if(s->filters.empty()) {
+    unfiltered.erase(remove(unfiltered.begin(), unfiltered.end(), s->fd),
+                     unfiltered.end());
+    return;
+  }
+  for(f = s->filters.begin(); f != s->filters.end(); f++) {
+    list = (f->fields & FILTER_QID) ? &byQid[f->qid] : &anyQid;
+    for(i = 0; i < list->size(); ) {
+      if((*list)[i].first == s) {
+        (*list)[i] = list->back();
+        list->pop_back();
+      } else {
+        i++;
+      }
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+Subscriptions::matches(const filter_t &f, const uint8_t *p, int len,
+                       int pktType)
+{
+  if((f.fields & FILTER_PKT_TYPE) && f.pktType != pktType) {
+    return false;
+  }
+  // the other fields are in the query messages of data packets
+  if((f.fields & ~FILTER_PKT_TYPE) && pktType != PKT_TYPE_DATA) {
+    return false;
+  }
+  if((f.fields & FILTER_MSG_TYPE) && (len < 1 || p[0] != f.msgType)) {
+    return false;
+  }
+  if((f.fields & FILTER_QID) &&
+     (len <= QREPLY_QID || (p[0] != MSG_QREQUEST && p[0] != MSG_QREPLY) ||
+      p[QREPLY_QID] != f.qid)) {
+    return false;
+  }
+  if((f.fields & FILTER_NODE) &&
+     (len < QREPLY_HEADER_LEN || p[0] != MSG_QREPLY ||
+      p[QREPLY_NODEADDR] != f.node[0] ||
+      p[QREPLY_NODEADDR + 1] != f.node[1])) {
+    return false;
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+void
+Subscriptions::match(const Packet &packet, vector<int> &fds)
+{
+  const uint8_t *p = (const uint8_t *)packet.getPayload();
+  int len = packet.getPacketLength();
+  int pktType = packet.getPacketType();
+  filterList_t *lists[2];
+  int i, n = 0;
+  unsigned int k;
+
+  fds.assign(unfiltered.begin(), unfiltered.end());
+  if(unfiltered.size() == subscribers.size()) {
+    return;
+  }
+
+  // only the filters of the packet's query and the ones naming none
+  if(pktType == PKT_TYPE_DATA && len > QREPLY_QID &&
+     (p[0] == MSG_QREQUEST || p[0] == MSG_QREPLY)) {
+    lists[n++] = &byQid[p[QREPLY_QID]];
+  }
+  lists[n++] = &anyQid;
+
+  // a client matching several filters gets the packet once
+  round++;
+  for(i = 0; i < n; i++) {
+    for(k = 0; k < lists[i]->size(); k++) {
+      subscriber_t *s = (*lists[i])[k].first;
+      if(s->mark != round && matches((*lists[i])[k].second, p, len, pktType)) {
+        s->mark = round;
+        fds.push_back(s->fd);
+      }
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+Subscriptions::wants(int fd, const Packet &packet) const
+{
+  map<int, subscriber_t>::const_iterator it = subscribers.find(fd);
+  const uint8_t *p = (const uint8_t *)packet.getPayload();
+  int len = packet.getPacketLength();
+  int pktType = packet.getPacketType();
+  unsigned int k;
+
+  if(it == subscribers.end()) {
+    return false;
+  }
+  if(it->second.filters.empty()) {
+    return true;
+  }
+  for(k = 0; k < it->second.filters.size(); k++) {
+    if(matches(it->second.filters[k], p, len, pktType)) {
+      return true;
+    }
+  }
+  return false;
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Header file of the subscription index.
+ *      Read clients that have not subscribed get every packet. A client
+ *      that has lists filters and gets the packets matching any of them.
+ *      Filters naming a query id are indexed by it, so a packet is only
+ *      checked against the filters of its own query and the ones that do
+ *      not name any.
+ */
+
+#ifndef SUBSCRIPTIONS_H
+#define SUBSCRIPTIONS_H
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "Packet.h"
+
+/* fields a filter checks */
+#define FILTER_PKT_TYPE 0x01
+#define FILTER_MSG_TYPE 0x02
+#define FILTER_QID      0x04
+#define FILTER_NODE     0x08
+
+/* length of a filter in a subscription packet:
+ *   fields | packet type | message type | qid | node address (2) */
+#define FILTER_LEN 6
+
+/* Number of filters one client may have. */
+#ifdef CONF_MAX_CLIENT_FILTERS
+#define MAX_CLIENT_FILTERS CONF_MAX_CLIENT_FILTERS
+#else
+#define MAX_CLIENT_FILTERS 16
+#endif
+
+class Subscriptions
+{
+  protected:
+
+    typedef struct filter {
+      uint8_t fields;
+      uint8_t pktType;
+      uint8_t msgType;
+      uint8_t qid;
+      uint8_t node[2];
+    } filter_t;
+
+    typedef struct subscriber {
+      int fd;
+      std::vector<filter_t> filters;
+      /* match() round the subscriber was last added in */
+      uint32_t mark;
+    } subscriber_t;
+
+    typedef std::vector<std::pair<subscriber_t *, filter_t> > filterList_t;
+
+    /* read clients by fd */
+    std::map<int, subscriber_t> subscribers;
+
+    /* fds of the read clients without filters */
+    std::vector<int> unfiltered;
+
+    /* filters naming a query id, by query id */
+    filterList_t byQid[256];
+
+    /* filters not naming a query id */
+    filterList_t anyQid;
+
+    uint32_t round;
+
+    /* put the filters of s into / take them out of the index */
+    void index(subscriber_t *s);
+
+    void unindex(subscriber_t *s);
+
+    static bool matches(const filter_t &f, const uint8_t *p, int len,
+                        int pktType);
+
+  public:
+
+    Subscriptions();
+
+    /* forget all read clients */
+    void clear();
+
+    /* a read client connected, it gets every packet */
+    void addReader(int fd);
+
+    void removeReader(int fd);
+
+    /* replace the filters of a read client with the ones in data, none
+     * means every packet. Returns the number of filters, -1 if data is
+     * not a list of filters. */
+    int subscribe(int fd, const char *data, int len);
+
+    /* sets fds to the read clients that want packet */
+    void match(const Packet &packet, std::vector<int> &fds);
+
+    /* whether the read client fd wants packet. Only reads the index, so
+     * threads may call it at once while nobody changes the index. */
+    bool wants(int fd, const Packet &packet) const;
+
+};
+
+#endif /* SUBSCRIPTIONS_H */
@@ -40,17 +40,24 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 
 #include <cstdio>
 #include <cstring>
+#include <algorithm>
 
 
 #include "TCPComm.h"
+#include "PacketPool.h"
 #include "Version.h"
 
 //#define DEBUG_EABLE 1
@@ -73,28 +80,146 @@
 
 #define MAX_PORT_STR_SIZE 5
 
-#ifdef CONF_LISTEN_QUEUE_LENGTH
-#define LISTEN_QUEUE_LENGTH CONF_LISTEN_QUEUE_LENGTH
-#else
-#define LISTEN_QUEUE_LENGTH 10
-#endif
-
 using namespace std;
 
-void * writeToClientsThreadFunc(void* ob);
-void * readFromClientsThreadFunc(void* ob);
+void * eventLoopThreadFunc(void* ob);
+
+void * senderThreadFunc(void* ob);
+
+/*----------------------------------------------------------------------------*/
+/* writes value as a varint, returns its length */
+static int
+putVarint(char *buf, uint64_t value)
+{
+  int n = 0;
+
+  while(value >= 0x80) {
+    buf[n++] = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  buf[n++] = value;
+  return n;
+}
+/*----------------------------------------------------------------------------*/
+/* reads a varint from the len bytes of buf. Returns its length, 0 if it
+ * is not complete yet, or -1 if it does not fit in 32 bits. */
+static int
+getVarint(const char *buf, int len, uint32_t *value)
+{
+  uint64_t v = 0;
+  int n;
+
+  for(n = 0; n < len && n < VARINT_MAX_LEN; n++) {
+    v |= (uint64_t)(buf[n] & 0x7F) << (7 * n);
+    if((buf[n] & 0x80) == 0) {
+      if(v > 0xFFFFFFFFULL) {
+        return -1;
+      }
+      *value = v;
+      return n + 1;
+    }
+  }
+  return (n == VARINT_MAX_LEN) ? -1 : 0;
+}
 
 /*----------------------------------------------------------------------------*/
 TCPComm::TCPComm(int port, PacketBuffer &readBuffer, PacketBuffer &writeBuffer)
                              : readBuffer(readBuffer), writeBuffer(writeBuffer)
 {
   this->serverPort = port;
-  this->readBuffer = readBuffer;
-  this->writeBuffer = writeBuffer;
-
-  serverThreadRunning = false;
-  readerThreadRunning = false;
-  writerThreadRunning = false;
+  this->serverFD = -1;
+  this->unixFD = -1;
+  this->shmRing = NULL;
+  this->sinkGroup = -1;
+  this->useIoUring = false;
+  this->epollFD = -1;
+  this->readBufferFD = -1;
+  this->readClientCount = 0;
+  this->writeClientCount = 0;
+  this->blockedClientCount = 0;
+  this->readBufferPending = false;
+  this->realtimeOffset = 0;
+  this->senderCount = 0;
+  this->senders = NULL;
+  this->ring = NULL;
+  this->gateSeq = 0;
+  this->senderFailFD = -1;
+  this->maxReadClients = MAX_READ_CLIENTS;
+  this->maxWriteClients = MAX_WRITE_CLIENTS;
+  this->clientQueueLength = CLIENT_QUEUE_LENGTH;
+  this->listenBacklog = LISTEN_QUEUE_LENGTH;
+  this->senderRingSize = SENDER_RING_SIZE;
+  this->clientMetrics = NULL;
+  this->clientMetricsCount = 0;
+  pthread_mutex_init(&readClientLock, NULL);
+  pthread_cond_init(&readClientCond, NULL);
+  pthread_rwlock_init(&subscriptionLock, NULL);
+
+  eventThreadRunning = false;
+}
+/*----------------------------------------------------------------------------*/
+TCPComm::~TCPComm()
+{
+  cancel();
+  pthread_rwlock_destroy(&subscriptionLock);
+  pthread_cond_destroy(&readClientCond);
+  pthread_mutex_destroy(&readClientLock);
+  delete[] clientMetrics;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setSenders(int senders)
+{
+  senderCount = (senders > 0) ? senders : 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setUnixPath(const std::string &path)
+{
+  unixPath = path;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setShmRing(ShmRing *ring)
+{
+  shmRing = ring;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setSinkGroup(int group)
+{
+  sinkGroup = group;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setIoUring(bool enable)
+{
+  useIoUring = enable;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setClientLimits(int maxReadClients, int maxWriteClients)
+{
+  this->maxReadClients = (maxReadClients > 0) ? maxReadClients : 0;
+  this->maxWriteClients = (maxWriteClients > 0) ? maxWriteClients : 0;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setClientQueueLength(int length)
+{
+  clientQueueLength = (length > 0) ? length : 1;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setListenBacklog(int backlog)
+{
+  listenBacklog = (backlog > 0) ? backlog : 1;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::setSenderRingSize(int size)
+{
+  senderRingSize = size;
 }
 
 /*----------------------------------------------------------------------------*/
@@ -139,7 +264,7 @@ TCPComm::createServer(int port)
       continue;
     }
 
-    if(listen(sockfd, LISTEN_QUEUE_LENGTH) < 0) {
+    if(listen(sockfd, listenBacklog) < 0) {
       ERROR("Can not listen to the socket");
       return -1;
     }
@@ -155,11 +280,47 @@ TCPComm::createServer(int port)
   return sockfd;
 }
 /*----------------------------------------------------------------------------*/
+int
+TCPComm::createUnixServer(const std::string &path)
+{
+  struct sockaddr_un un;
+  int sockfd;
+
+  if(path.size() >= sizeof(un.sun_path)) {
+    errno = ENAMETOOLONG;
+    ERROR("Can not use socket " << path);
+    return -1;
+  }
+  sockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if(sockfd < 0) {
+    ERROR("Can not create a socket");
+    return -1;
+  }
+
+  // a socket left behind by an earlier run
+  unlink(path.c_str());
+  memset(&un, 0, sizeof(un));
+  un.sun_family = AF_UNIX;
+  strcpy(un.sun_path, path.c_str());
+  if(bind(sockfd, (struct sockaddr *)&un, sizeof(un)) < 0) {
+    ERROR("Can not bind the socket " << path);
+    close(sockfd);
+    return -1;
+  }
+  if(listen(sockfd, listenBacklog) < 0) {
+    ERROR("Can not listen to the socket " << path);
+    close(sockfd);
+    unlink(path.c_str());
+    return -1;
+  }
+  return sockfd;
+}
+/*----------------------------------------------------------------------------*/
 std::string
 TCPComm::getIpAddressString(struct sockaddr_storage *ss)
 {
   char s[INET6_ADDRSTRLEN];
-  const char *retval;
+  const char *retval = NULL;
 
   std::string addressString;
 
@@ -191,185 +352,428 @@ TCPComm::getPort(struct sockaddr_storage *ss)
     case AF_INET6:
       return ((struct sockaddr_in6*)ss)->sin6_port;
   }
+  // clients of the Unix socket have no port
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+TCPComm::setNonBlocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL, 0);
+  if(flags < 0) {
+    return -1;
+  }
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+/*----------------------------------------------------------------------------*/
+void *
+eventLoopThreadFunc(void* ob)
+{
+  static_cast<TCPComm*>(ob)->runEventLoop();
+  return NULL;
 }
 /*----------------------------------------------------------------------------*/
 void *
-serverThreadFunc(void* ob)
+senderThreadFunc(void* ob)
 {
-  static_cast<TCPComm*>(ob)->waitForClients();
+  TCPComm::sender_t *sender = static_cast<TCPComm::sender_t *>(ob);
+  sender->comm->runSender(sender);
   return NULL;
 }
 /*----------------------------------------------------------------------------*/
 int
 TCPComm::start()
 {
-  int ret;
-
-  pthread_mutex_init(&sharedClientInfo.sharedInfoLock, NULL);
-  pthread_mutex_init(&sharedClientInfo.readWakeupLock, NULL);
-  pthread_mutex_init(&sharedClientInfo.writeWakeupLock, NULL);
-
-  pthread_cond_init(&sharedClientInfo.readWakeup, NULL);
-  pthread_cond_init(&sharedClientInfo.writeWakeup, NULL);
-
-  sharedClientInfo.readClientCount = 0;
-  sharedClientInfo.writeClientCount = 0;
-  sharedClientInfo.clients.clear();
+  int i, ret;
+  struct epoll_event ev;
+
+  readClientCount = 0;
+  writeClientCount = 0;
+  blockedClientCount = 0;
+  readBufferPending = false;
+  clients.clear();
+  subscriptions.clear();
+
+  if(clientMetrics == NULL) {
+    clientMetricsCount = maxReadClients + maxWriteClients;
+    clientMetrics = new clientMetrics_t[clientMetricsCount];
+    for(i = 0; i < clientMetricsCount; i++) {
+      clientMetrics[i].fd = -1;
+    }
+  }
 
   this->serverFD = createServer(this->serverPort);
   if(this->serverFD < 1) {
     this->serverFD = -1;
     return -1;
   }
+  setNonBlocking(this->serverFD);
 
-  ret = pthread_create(&serverThread, NULL, serverThreadFunc, this);
-  if(ret != 0) {
-    ERROR("TCPComm::start : Could not start server thread");
+  if(!unixPath.empty()) {
+    unixFD = createUnixServer(unixPath);
+    if(unixFD < 0) {
+      return -1;
+    }
+    setNonBlocking(unixFD);
+  }
+
+  epollFD = epoll_create1(EPOLL_CLOEXEC);
+  if(epollFD < 0) {
+    ERROR("TCPComm::start : Could not create epoll instance");
     return -1;
   }
-  serverThreadRunning = true;
 
-  ret = pthread_create(&writerThread, NULL, writeToClientsThreadFunc, this);
-  if(ret != 0) {
-    ERROR("TCPComm::start : Could not start write to clients thread");
+  readBufferFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if(readBufferFD < 0) {
+    ERROR("TCPComm::start : Could not create eventfd");
+    return -1;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN;
+  ev.data.fd = serverFD;
+  if(epoll_ctl(epollFD, EPOLL_CTL_ADD, serverFD, &ev) < 0) {
+    ERROR("TCPComm::start : Could not watch the server socket");
+    return -1;
+  }
+  if(unixFD >= 0) {
+    ev.data.fd = unixFD;
+    if(epoll_ctl(epollFD, EPOLL_CTL_ADD, unixFD, &ev) < 0) {
+      ERROR("TCPComm::start : Could not watch the Unix socket");
+      return -1;
+    }
+  }
+  ev.data.fd = readBufferFD;
+  if(epoll_ctl(epollFD, EPOLL_CTL_ADD, readBufferFD, &ev) < 0) {
+    ERROR("TCPComm::start : Could not watch the read buffer");
     return -1;
   }
-  writerThreadRunning = true;
+  readBuffer.setNotifyFD(readBufferFD);
+
+  if(useIoUring && senderCount == 0 &&
+     uring.init(CLIENT_URING_ENTRIES) < 0) {
+    DEBUG("TCPComm::start : no io_uring, writing with sendmsg()");
+  }
+
+  if(senderCount > 0) {
+    ring = new BroadcastRing(senderRingSize);
+    gateSeq = 0;
+    senders = new sender_t[senderCount];
+    for(i = 0; i < senderCount; i++) {
+      senders[i].comm = this;
+      senders[i].running = false;
+      senders[i].epollFD = -1;
+      senders[i].wakeFD = -1;
+      pthread_mutex_init(&senders[i].lock, NULL);
+    }
+
+    senderFailFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(senderFailFD < 0) {
+      ERROR("TCPComm::start : Could not create eventfd");
+      return -1;
+    }
+    ev.data.fd = senderFailFD;
+    if(epoll_ctl(epollFD, EPOLL_CTL_ADD, senderFailFD, &ev) < 0) {
+      ERROR("TCPComm::start : Could not watch the senders");
+      return -1;
+    }
+
+    for(i = 0; i < senderCount; i++) {
+      senders[i].epollFD = epoll_create1(EPOLL_CLOEXEC);
+      senders[i].wakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if(senders[i].epollFD < 0 || senders[i].wakeFD < 0) {
+        ERROR("TCPComm::start : Could not create sender " << i);
+        return -1;
+      }
+      ev.data.fd = senders[i].wakeFD;
+      if(epoll_ctl(senders[i].epollFD, EPOLL_CTL_ADD, senders[i].wakeFD,
+                   &ev) < 0) {
+        ERROR("TCPComm::start : Could not watch sender " << i);
+        return -1;
+      }
+      if(pthread_create(&senders[i].thread, NULL, senderThreadFunc,
+                        &senders[i]) != 0) {
+        ERROR("TCPComm::start : Could not start sender thread " << i);
+        return -1;
+      }
+      senders[i].running = true;
+    }
+  }
 
-  ret = pthread_create(&readerThread, NULL, readFromClientsThreadFunc, this);
+  ret = pthread_create(&eventThread, NULL, eventLoopThreadFunc, this);
   if(ret != 0) {
-    ERROR("TCPComm::start : Could not start read from clients thread");
+    ERROR("TCPComm::start : Could not start event loop thread");
     return -1;
   }
-  readerThreadRunning = true;
+  eventThreadRunning = true;
 
   DEBUG("TCPComm::start : TCPComm started.");
   return 0;
 }
 /*----------------------------------------------------------------------------*/
-int
-TCPComm::addClient(clientInfo_t &clientInfo)
+void
+TCPComm::runEventLoop()
 {
-  bool addingFailed = false;
-  int errorCode = ERR_OK;
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  int i, n;
 
-  pthread_testcancel();
-  pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
+  // packets queued before we were notified
+  writeToClients();
 
-  if((clientInfo.mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
-    if(sharedClientInfo.readClientCount == 0) {
-      pthread_cond_broadcast(&sharedClientInfo.readWakeup);
+  while(true) {
+    n = epoll_wait(epollFD, events, EPOLL_MAX_EVENTS, -1);
+    if(n < 0) {
+      if(errno != EINTR) {
+        ERROR("TCPComm::runEventLoop : epoll_wait");
+      }
+      continue;
     }
-    sharedClientInfo.readClientCount++;
-  }
 
-  if((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
-    if(sharedClientInfo.writeClientCount == 0) {
-      pthread_cond_broadcast(&sharedClientInfo.writeWakeup);
-    }
-    sharedClientInfo.writeClientCount++;
-  }
-  DEBUG("TCPComm::addClient : Client added.");
-  sharedClientInfo.clients.insert(clientInfo);
+    for(i = 0; i < n; i++) {
+      int fd = events[i].data.fd;
+
+      if(fd == serverFD || fd == unixFD) {
+        acceptNewClients(fd);
+        continue;
+      }
+
+      if(fd == readBufferFD) {
+        uint64_t count;
+        while(read(readBufferFD, &count, sizeof(count)) > 0);
+        writeToClients();
+        continue;
+      }
+
+      if(fd == senderFailFD) {
+        uint64_t count;
+        while(read(senderFailFD, &count, sizeof(count)) > 0);
+        removeFailedClients();
+        continue;
+      }
+
+      // a client may have been removed by an earlier event of this round
+      std::map<int, clientInfo_t *>::iterator it = clients.find(fd);
+      if(it == clients.end()) {
+        continue;
+      }
+      clientInfo_t *clientInfo = it->second;
 
-  pthread_mutex_unlock(&sharedClientInfo.sharedInfoLock);
+      // read first, a client may send its last packets and hang up
+      if((events[i].events & EPOLLIN) && readFromClient(clientInfo) < 0) {
+        removeClient(clientInfo);
+        continue;
+      }
+      if(events[i].events & (EPOLLERR | EPOLLHUP)) {
+        DEBUG("TCPComm::runEventLoop : client hung up fd:" << fd);
+        removeClient(clientInfo);
+        continue;
+      }
+      if((events[i].events & EPOLLOUT) && flushClient(clientInfo) < 0) {
+        removeClient(clientInfo);
+        continue;
+      }
+    }
 
-  return errorCode;
+    // the last BLOCK client that held up readBuffer has caught up
+    if(readBufferPending && blockedClientCount == 0) {
+      writeToClients();
+    }
+  }
 }
 /*----------------------------------------------------------------------------*/
 int
-TCPComm::removeClient(clientInfo_t &clientInfo)
+TCPComm::addClient(clientInfo_t *clientInfo)
 {
-  bool clientRemoved = false;
-  int rCount = 0;
+  unsigned int i;
+  clientMetrics_t *metrics = NULL;
 
-  pthread_testcancel();
-  pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
-
-  DEBUG("TCPComm::removeClient : removing client fd " << clientInfo.clientFD);
+  for(i = 0; i < (unsigned int)clientMetricsCount; i++) {
+    if(clientMetrics[i].fd < 0) {
+      metrics = &clientMetrics[i];
+      break;
+    }
+  }
+  // handshakeClient() keeps to the limits, so there is always a slot
+  // unless they and the slots disagree
+  if(metrics == NULL) {
+    DEBUG("TCPComm::addClient : no metrics slot left for fd "
+          << clientInfo->clientFD);
+    return ERR_UNKNOWN;
+  }
+  metrics->port = ntohs(clientInfo->clientPort);
+  metrics->mode = clientInfo->mode;
+  metrics->policy = clientInfo->policy;
+  metrics->version = clientInfo->version;
+  CLIENT_METRIC_SET(metrics->queued, 0);
+  CLIENT_METRIC_SET(metrics->dropped, 0);
+  CLIENT_METRIC_SET(metrics->highWater, (uint32_t)clientInfo->outQueue.size());
+  CLIENT_METRIC_SET(metrics->length, (uint32_t)clientInfo->outQueue.size());
+  CLIENT_METRIC_SET(metrics->bytesOut, 0);
+  CLIENT_METRIC_SET(metrics->oldestStamp, 0);
+  // the slot is read once fd is set
+  __atomic_store_n(&metrics->fd, clientInfo->clientFD, __ATOMIC_RELEASE);
+  clientInfo->metrics = metrics;
+
+  if((clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
+    pthread_mutex_lock(&readClientLock);
+    readClientCount++;
+    pthread_cond_broadcast(&readClientCond);
+    pthread_mutex_unlock(&readClientLock);
+    pthread_rwlock_wrlock(&subscriptionLock);
+    subscriptions.addReader(clientInfo->clientFD);
+    pthread_rwlock_unlock(&subscriptionLock);
+  }
 
-  if((clientInfo.mode & CLIENT_MODE_R) == CLIENT_MODE_R &&
-     sharedClientInfo.readClientCount > 0) {
+  // the sender with the fewest clients takes a read client over
+  if(senderCount > 0 && (clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
+    sender_t *sender = &senders[0];
+    std::deque<outFrame_t>::iterator it;
 
-    rCount = sharedClientInfo.clients.erase(clientInfo);
-    if(close(clientInfo.clientFD) < 0) {
-      DEBUG("TCPComm::removeClient : error closing fd " << clientInfo.clientFD);
+    for(i = 1; i < (unsigned int)senderCount; i++) {
+      if(senders[i].clients.size() < sender->clients.size()) {
+        sender = &senders[i];
+      }
     }
-    if(rCount > 0) {
-      sharedClientInfo.readClientCount--;
+    pthread_mutex_lock(&sender->lock);
+    clientInfo->cursor = ring->getPublished();
+    clientInfo->senderWaiting = false;
+    clientInfo->failed = false;
+    // the answer to the handshake goes first
+    for(it = clientInfo->outQueue.begin(); it != clientInfo->outQueue.end();
+        it++) {
+      clientInfo->pending.append(it->head, it->headLen);
+      clientInfo->pending.append(it->packet.getPayload(),
+                                 it->packet.getPacketLength());
     }
-    clientRemoved = true;
+    clientInfo->outQueue.clear();
+    clientInfo->sender = sender;
+    sender->clients.push_back(clientInfo);
+    pthread_mutex_unlock(&sender->lock);
+    wakeSender(sender);
   }
+  if((clientInfo->mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
+    writeClientCount++;
+  }
+  clientInfo->state = CLIENT_CONNECTED;
+  DEBUG("TCPComm::addClient : Client added.");
 
-  if((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W &&
-     sharedClientInfo.writeClientCount > 0) {
+  return ERR_OK;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::removeClient(clientInfo_t *clientInfo)
+{
+  DEBUG("TCPComm::removeClient : removing client fd " << clientInfo->clientFD);
+
+  // once out of the list of its sender, the sender does not touch it
+  if(clientInfo->sender != NULL) {
+    sender_t *sender = clientInfo->sender;
+    pthread_mutex_lock(&sender->lock);
+    sender->clients.erase(std::find(sender->clients.begin(),
+                                    sender->clients.end(), clientInfo));
+    pthread_mutex_unlock(&sender->lock);
+    clientInfo->sender = NULL;
+  }
 
-    if(!clientRemoved) {
-      rCount = sharedClientInfo.clients.erase(clientInfo);
-      if(close(clientInfo.clientFD) < 0) {
-        DEBUG("TCPComm::removeClient : error closing fd " << clientInfo.clientFD);
-      }
+  if(clientInfo->blocked) {
+    blockedClientCount--;
+  }
+  if(clientInfo->metrics != NULL) {
+    __atomic_store_n(&clientInfo->metrics->fd, -1, __ATOMIC_RELEASE);
+  }
+  if(clientInfo->state == CLIENT_CONNECTED) {
+    if((clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
+      pthread_mutex_lock(&readClientLock);
+      readClientCount--;
+      pthread_mutex_unlock(&readClientLock);
+      pthread_rwlock_wrlock(&subscriptionLock);
+      subscriptions.removeReader(clientInfo->clientFD);
+      pthread_rwlock_unlock(&subscriptionLock);
     }
-    if(rCount > 0) {
-      sharedClientInfo.writeClientCount--;
+    if((clientInfo->mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
+      writeClientCount--;
     }
   }
 
-  DEBUG("TCPComm::removeClient : removed count " << rCount);
-  pthread_mutex_unlock(&sharedClientInfo.sharedInfoLock);
+  // closing the fd also removes it from the epoll set
+  if(close(clientInfo->clientFD) < 0) {
+    DEBUG("TCPComm::removeClient : error closing fd " << clientInfo->clientFD);
+  }
+  clients.erase(clientInfo->clientFD);
+  delete clientInfo;
 }
 /*----------------------------------------------------------------------------*/
 int
-TCPComm::handshakeClient(clientInfo_t &clientInfo)
+TCPComm::handshakeClient(clientInfo_t *clientInfo)
 {
-  char buf[4];
-  int k;
+  char *buf = clientInfo->inBuf;
   bool invalidMode = false;
-  int nRClients, nWClients;
-
-  k = recv(clientInfo.clientFD, buf, 4, 0);
-  if(k != 4) {
-    DEBUG("TCPComm::handshakeClient : Could not read init byes from the client. fd:"
-                                                              <<clientInfo.clientFD);
-    return ERR_UNKNOWN;
-  }
 
   /* check version */
-  if(buf[0] != VERSION_MAJOR && buf[1] != VERSION_MINOR) {
+  if((buf[0] != PROTOCOL_V1 && buf[0] != PROTOCOL_V2) || buf[1] != 0) {
     return ERR_UNSUPPORTED_VERSION;
   }
+  clientInfo->version = buf[0];
   /* check connected mode */
   switch(buf[2]) {
     case CLIENT_MODE_R:
-      clientInfo.mode = CLIENT_MODE_R;
+      clientInfo->mode = CLIENT_MODE_R;
       break;
     case CLIENT_MODE_W:
-      clientInfo.mode = CLIENT_MODE_W;
+      clientInfo->mode = CLIENT_MODE_W;
       break;
     case  CLIENT_MODE_RW:
-      clientInfo.mode = CLIENT_MODE_RW;
+      clientInfo->mode = CLIENT_MODE_RW;
       break;
     default:
       invalidMode = true;
   }
 
   if(invalidMode) {
-    DEBUG("TCPComm::handshakeClient : Invalid mode. fd:"<<clientInfo.clientFD);
+    DEBUG("TCPComm::handshakeClient : Invalid mode. fd:"<<clientInfo->clientFD);
     return ERR_INVALID_MODE;
   }
 
-  pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
-  nRClients = sharedClientInfo.readClientCount;
-  nWClients = sharedClientInfo.writeClientCount;
-  pthread_mutex_unlock(&sharedClientInfo.sharedInfoLock);
+  /* requested queue policy, unknown ones get the default */
+  switch(buf[3] & CLIENT_POLICY_MASK) {
+    case CLIENT_POLICY_BLOCK:
+    case CLIENT_POLICY_DROP_OLDEST:
+    case CLIENT_POLICY_DROP_NEWEST:
+    case CLIENT_POLICY_DISCONNECT:
+      clientInfo->policy = buf[3] & CLIENT_POLICY_MASK;
+      break;
+    default:
+      clientInfo->policy = DEFAULT_CLIENT_POLICY;
+  }
+  // the ring of the senders only waits a whole ring for a read client
+  if(senderCount > 0 && (clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
+    clientInfo->policy = CLIENT_POLICY_DISCONNECT;
+  }
+
+  /* requested timestamps */
+  if(clientInfo->version == PROTOCOL_V1) {
+    if(buf[3] & CLIENT_STAMP_MONOTONIC) {
+      clientInfo->stampClock = CLIENT_STAMP_MONOTONIC;
+    } else if(buf[3] & CLIENT_STAMP_REALTIME) {
+      clientInfo->stampClock = CLIENT_STAMP_REALTIME;
+    }
+  } else {
+    clientInfo->features = buf[4] & FEATURES_SUPPORTED;
+    if(clientInfo->features & FEATURE_STAMP_MONOTONIC) {
+      clientInfo->features &= ~FEATURE_STAMP_REALTIME;
+      clientInfo->stampClock = CLIENT_STAMP_MONOTONIC;
+    } else if(clientInfo->features & FEATURE_STAMP_REALTIME) {
+      clientInfo->stampClock = CLIENT_STAMP_REALTIME;
+    }
+  }
 
-  if(((clientInfo.mode & CLIENT_MODE_R) == CLIENT_MODE_R) &&
-      (nRClients >= TCPComm::maxReadClients)) {
+  if(((clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) &&
+      (readClientCount >= maxReadClients)) {
     return ERR_READ_CLIENTS_FULL;
   }
 
-  if(((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W) &&
-      (nWClients >= TCPComm::maxWriteClients)) {
+  if(((clientInfo->mode & CLIENT_MODE_W) == CLIENT_MODE_W) &&
+      (writeClientCount >= maxWriteClients)) {
     return ERR_WRITE_CLIENTS_FULL;
   }
 
@@ -377,363 +781,1231 @@ TCPComm::handshakeClient(clientInfo_t &clientInfo)
 }
 /*----------------------------------------------------------------------------*/
 int
-TCPComm::sendHandshakeError(clientInfo_t &clientInfo, int errorCode)
+TCPComm::handshakeLength(const clientInfo_t *clientInfo)
 {
-  char buf[4];
-  buf[0] = VERSION_MAJOR;
-  buf[1] = VERSION_MINOR;
-  buf[2] = errorCode;
-  return send(clientInfo.clientFD, buf, 4, 0);
+  return (clientInfo->inBuf[0] == PROTOCOL_V2) ? HANDSHAKE_V2_LEN
+                                                : HANDSHAKE_LEN;
 }
 /*----------------------------------------------------------------------------*/
-int
-TCPComm::acceptNewClient()
+void
+TCPComm::sendHandshakeError(clientInfo_t *clientInfo, int errorCode)
 {
-  clientInfo_t clientInfo;
-  int errorCode = ERR_OK;
-
-  clientInfo.clientAddress.len = sizeof(clientInfo.clientAddress.sa);
-  clientInfo.clientFD = accept(this->serverFD,
-                               (struct sockaddr *)&clientInfo.clientAddress.sa,
-                               &clientInfo.clientAddress.len);
-  if(clientInfo.clientFD < 0) {
-    ERROR("Could not accept new client");
-    return -1;
-  }
-  DEBUG("TCPComm::acceptNewClient : Client connected IP "
-        <<TCPComm::getIpAddressString(&clientInfo.clientAddress.sa)
-        << ", PORT "<<TCPComm::getPort(&clientInfo.clientAddress.sa)
-        << " fd:"<<clientInfo.clientFD);
-
-  errorCode = handshakeClient(clientInfo);
-  sendHandshakeError(clientInfo, errorCode);
+  char buf[HANDSHAKE_V2_LEN];
 
-  if(errorCode != ERR_OK) {
-    DEBUG("TCPComm::acceptNewClient : Handshake failed. fd:"<<clientInfo.clientFD);
-    close(clientInfo.clientFD);
-    return 0;
-  } else {
-    addClient(clientInfo);
+  buf[2] = errorCode;
+  if(clientInfo->version == PROTOCOL_V2) {
+    buf[0] = PROTOCOL_V2;
+    buf[1] = 0;
+    buf[3] = clientInfo->policy;
+    buf[4] = clientInfo->features;
+    queueRaw(clientInfo, buf, HANDSHAKE_V2_LEN);
+    return;
   }
-
-  return 0;
+  // an unknown version is told the newest one
+  buf[0] = (clientInfo->version == PROTOCOL_V1) ? PROTOCOL_V1 : VERSION_MAJOR;
+  buf[1] = (clientInfo->version == PROTOCOL_V1) ? 0 : VERSION_MINOR;
+  buf[3] = clientInfo->policy | clientInfo->stampClock;
+  queueRaw(clientInfo, buf, HANDSHAKE_LEN);
 }
 /*----------------------------------------------------------------------------*/
 void
-TCPComm::waitForClients()
+TCPComm::acceptNewClients(int listenFD)
 {
-  int k;
+  struct epoll_event ev;
+  int fd;
+
   while(true) {
-    k = acceptNewClient();
-    if(k < 0) {
-      cancel();
+    clientInfo_t *clientInfo = new clientInfo_t();
+
+    clientInfo->clientAddress.len = sizeof(clientInfo->clientAddress.sa);
+    fd = accept(listenFD,
+                (struct sockaddr *)&clientInfo->clientAddress.sa,
+                &clientInfo->clientAddress.len);
+    if(fd < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        ERROR("Could not accept new client");
+      }
+      delete clientInfo;
+      return;
+    }
+    DEBUG("TCPComm::acceptNewClients : Client connected IP "
+          <<TCPComm::getIpAddressString(&clientInfo->clientAddress.sa)
+          << ", PORT "<<TCPComm::getPort(&clientInfo->clientAddress.sa)
+          << " fd:"<<fd);
+
+    clientInfo->clientFD = fd;
+    clientInfo->clientPort = TCPComm::getPort(&clientInfo->clientAddress.sa);
+    clientInfo->mode = 0;
+    clientInfo->state = CLIENT_HANDSHAKE;
+    clientInfo->version = 0;
+    clientInfo->features = 0;
+    clientInfo->inLen = 0;
+    clientInfo->inFrameLeft = 0;
+    clientInfo->outPos = 0;
+    clientInfo->frameLeft = 0;
+    clientInfo->nextSeq = 0;
+    clientInfo->waitingWrite = false;
+    clientInfo->policy = DEFAULT_CLIENT_POLICY;
+    clientInfo->stampClock = 0;
+    clientInfo->metrics = NULL;
+    clientInfo->blocked = false;
+    clientInfo->sender = NULL;
+    clientInfo->cursor = 0;
+    clientInfo->senderWaiting = false;
+    clientInfo->failed = false;
+
+    setNonBlocking(fd);
+    if(CLIENT_SNDBUF > 0) {
+      int size = CLIENT_SNDBUF;
+      setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
     }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if(epoll_ctl(epollFD, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      ERROR("TCPComm::acceptNewClients : Could not watch client fd:" << fd);
+      close(fd);
+      delete clientInfo;
+      continue;
+    }
+    clients[fd] = clientInfo;
+    Metrics::instance().add(METRIC_CLIENTS_ACCEPTED);
   }
 }
 /*----------------------------------------------------------------------------*/
-void
-TCPComm::writeToClients()
+int
+TCPComm::readFromClient(clientInfo_t *clientInfo)
 {
+  int k;
+  int reads = 0;
 
-  Packet packet;
-  while(true) {
-    std::set<clientInfo_t> clientInfoSet;
-
-    // We do not wait until clients to connect to send packets.
-    // Instead, we discard the packets if there is no client connected in
-    // write mode.
-/*
-    pthread_cleanup_push((void(*)(void*))pthread_mutex_unlock,
-                         (void *)&sharedClientInfo.sharedInfoLock);
-
-    pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
-    while(sharedClientInfo.readClientCount == 0)  {
-
-      DEBUG("TCPComm::writeToClients : sleeping writer thread");
-      pthread_cond_wait(&sharedClientInfo.readWakeup,
-                        &sharedClientInfo.sharedInfoLock);
-    }
-
-    DEBUG("TCPComm::writeToClients : writer thread woked ");
-
-
-    pthread_cleanup_pop(1);
-*/
-    packet = readBuffer.dequeue();
-
-    pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
-    clientInfoSet = sharedClientInfo.clients;
-    pthread_mutex_unlock(&sharedClientInfo.sharedInfoLock);
+  while(reads < CLIENT_READS_PER_EVENT) {
+    k = recv(clientInfo->clientFD, clientInfo->inBuf + clientInfo->inLen,
+             sizeof(clientInfo->inBuf) - clientInfo->inLen, 0);
 
-    DEBUG("TCPComm::writeToClients : number of clients : " << clientInfoSet.size()
-          << " packet size : " << packet.getPacketLength());
-    if(clientInfoSet.size() == 0) {
-      DEBUG("TCPComm::writeToClients : no clients. discarding the packet");
-      continue;
+    if(k == 0) {
+      DEBUG("TCPComm::readFromClient : client closed fd:" << clientInfo->clientFD);
+      return -1;
     }
-
-    std::set<clientInfo_t>::iterator it;
-
-    for(it = clientInfoSet.begin(); it != clientInfoSet.end(); it++) {
-
-      clientInfo_t clientInfo = *it;
-
-      if((clientInfo.mode & CLIENT_MODE_R) != CLIENT_MODE_R) {
-        continue;
+    if(k < 0) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;
       }
-      if(writePacket(clientInfo, packet) < 0) {
-        DEBUG("TCPComm::writeClients : removeClient");
-        removeClient(clientInfo);
-      } else {
-        // currently do nothing
+      if(errno == EINTR) {
+        continue;
       }
-
-
+      DEBUG("TCPComm::readFromClient : error on reading from client");
+      return -1;
     }
 
+    clientInfo->inLen += k;
+    if(handleClientInput(clientInfo) < 0) {
+      return -1;
+    }
+    reads++;
   }
-
-
+  return 0;
 }
 /*----------------------------------------------------------------------------*/
-void
-TCPComm::readFromClients()
+int
+TCPComm::handleClientInput(clientInfo_t *clientInfo)
 {
-  std::set<clientInfo_t> clientInfoSet;
-
-  while(true) {
-
-    // Here, we do wait until at lease a client is connected in write mode.
-    pthread_cleanup_push((void(*)(void*))pthread_mutex_unlock,
-                         (void *)&sharedClientInfo.sharedInfoLock);
+  char *buf = clientInfo->inBuf;
+  int pos = 0;
+  int pktLen, pktType, pktSource;
+  int errorCode;
+
+  if(clientInfo->state == CLIENT_HANDSHAKE) {
+    if(clientInfo->inLen < 1 ||
+       clientInfo->inLen < handshakeLength(clientInfo)) {
+      return 0;
+    }
+    errorCode = handshakeClient(clientInfo);
+    sendHandshakeError(clientInfo, errorCode);
+    if(errorCode != ERR_OK) {
+      DEBUG("TCPComm::handleClientInput : Handshake failed. fd:"<<clientInfo->clientFD);
+      clientInfo->state = CLIENT_CLOSING;
+      clientInfo->inLen = 0;
+      return flushClient(clientInfo);
+    }
+    if(addClient(clientInfo) != ERR_OK) {
+      DEBUG("TCPComm::handleClientInput : can not add client fd:"<<clientInfo->clientFD);
+      return -1;
+    }
+    if(flushClient(clientInfo) < 0) {
+      return -1;
+    }
+    pos = handshakeLength(clientInfo);
+  }
 
-    pthread_mutex_lock(&sharedClientInfo.sharedInfoLock);
-    while(sharedClientInfo.writeClientCount == 0)  {
+  if(clientInfo->state == CLIENT_CLOSING) {
+    clientInfo->inLen = 0;
+    return 0;
+  }
 
-      DEBUG("TCPComm::readFromClients : sleeping reader thread");
-      pthread_cond_wait(&sharedClientInfo.writeWakeup,
-                        &sharedClientInfo.sharedInfoLock);
+  if(clientInfo->version == PROTOCOL_V2) {
+    pos = handleClientFrames(clientInfo, pos);
+    if(pos < 0) {
+      return -1;
     }
+  }
 
-    clientInfoSet = sharedClientInfo.clients;
+  while(clientInfo->version == PROTOCOL_V1 &&
+        clientInfo->inLen - pos >= PKT_META_LEN) {
+    pktLen = (unsigned char)buf[pos] + ((unsigned char)buf[pos + 1] << 8);
+    pktType = buf[pos + 2];
+    pktSource = (unsigned char)buf[pos + 3];
 
-    pthread_cleanup_pop(1);
+    if(pktLen > MAX_PKT_SIZE) {
+      DEBUG("TCPComm::handleClientInput : Can not accept more than the maximum packet size");
+      return -1;
+    }
+    if(clientInfo->inLen - pos < PKT_META_LEN + pktLen) {
+      break;
+    }
 
-    fd_set rfds;
-    std::set<clientInfo_t>::iterator it;
-    int maxFD;
+    handleClientPacket(clientInfo, pktType, pktSource,
+                       buf + pos + PKT_META_LEN, pktLen);
+    pos += PKT_META_LEN + pktLen;
+  }
 
-    FD_ZERO(&rfds);
+  if(pos > 0) {
+    memmove(buf, buf + pos, clientInfo->inLen - pos);
+    clientInfo->inLen -= pos;
+  }
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+int
+TCPComm::handleClientFrames(clientInfo_t *clientInfo, int pos)
+{
+  const char *buf = clientInfo->inBuf;
+  uint32_t frameLen, pktLen;
+  int n, headLen, pktType, pktSource;
+
+  while(pos < clientInfo->inLen) {
+    if(clientInfo->inFrameLeft == 0) {
+      n = getVarint(buf + pos, clientInfo->inLen - pos, &frameLen);
+      if(n < 0) {
+        DEBUG("TCPComm::handleClientFrames : Invalid frame length. fd:"<<clientInfo->clientFD);
+        return -1;
+      }
+      if(n == 0) {
+        break;
+      }
+      pos += n;
+      clientInfo->inFrameLeft = frameLen;
+      continue;
+    }
 
-    if(clientInfoSet.size() != 0) {
-      maxFD = ((clientInfo_t)*(clientInfoSet.begin())).clientFD;
+    n = getVarint(buf + pos, clientInfo->inLen - pos, &pktLen);
+    if(n < 0 || pktLen > MAX_PKT_SIZE) {
+      DEBUG("TCPComm::handleClientFrames : Can not accept more than the maximum packet size");
+      return -1;
     }
-    // scan all of the connected clients who have connected for writting
-    for(it = clientInfoSet.begin(); it != clientInfoSet.end(); it++) {
-      clientInfo_t clientInfo = *it;
+    if(n == 0) {
+      break;
+    }
+    headLen = n + 1 + ((clientInfo->features & FEATURE_SOURCE) ? 1 : 0);
+    if(headLen + pktLen > clientInfo->inFrameLeft) {
+      DEBUG("TCPComm::handleClientFrames : Packet runs past the end of the frame. fd:"<<clientInfo->clientFD);
+      return -1;
+    }
+    if(clientInfo->inLen - pos < headLen + (int)pktLen) {
+      break;
+    }
+
+    pktType = buf[pos + n];
+    pktSource = (clientInfo->features & FEATURE_SOURCE) ?
+                (unsigned char)buf[pos + n + 1] : PKT_SOURCE_ANY;
+    handleClientPacket(clientInfo, pktType, pktSource, buf + pos + headLen,
+                       pktLen);
+    pos += headLen + pktLen;
+    clientInfo->inFrameLeft -= headLen + pktLen;
+  }
+  return pos;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::handleClientPacket(clientInfo_t *clientInfo, int type, int source,
+                            const char *data, int len)
+{
+  Metrics &metrics = Metrics::instance();
+
+  if(type == PKT_TYPE_STATS) {
+    sendStats(clientInfo);
+  } else if(type == PKT_TYPE_SUBSCRIBE) {
+    subscribeClient(clientInfo, data, len);
+  } else if((clientInfo->mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
+    Packet packet;
+    char query[MAX_PKT_SIZE];
+    if(sinkGroup >= 0 && type == PKT_TYPE_DATA &&
+       len >= QREQUEST_HEADER_LEN && len <= MAX_PKT_SIZE &&
+       data[0] == MSG_QREQUEST) {
+      // the sink joins the group when it gets the query
+      memcpy(query, data, len);
+      query[QREQUEST_QROOT] = (char)SINK_GROUP_PREFIX;
+      query[QREQUEST_QROOT + 1] = (char)sinkGroup;
+      data = query;
+    }
+    packet.setPayload(data, len, type, source);
+    packet.setTimestamp(Metrics::now());
+    metrics.add(METRIC_CLIENT_FRAMES_IN);
+    metrics.add(METRIC_CLIENT_BYTES_IN, len);
+    if(writeBuffer.tryEnqueueBack(packet)) {
+      DEBUG("TCPComm::handleClientPacket : packet qued");
+    } else {
+      DEBUG("TCPComm::handleClientPacket : write buffer is full. packet is dropped");
+      metrics.add(METRIC_WRITE_BUFFER_DROPS);
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::writeToClients()
+{
+  Packet packet;
+  std::map<int, clientInfo_t *>::iterator it, next;
+  unsigned int i;
+  int n;
+
+  readBufferPending = false;
+  __atomic_store_n(&realtimeOffset, Metrics::realtimeOffset(),
+                   __ATOMIC_RELAXED);
+  if(senderCount > 0) {
+    publishToRing();
+    return;
+  }
+
+  while(true) {
+    // queue a batch of packets, then write it with one call per client
+    for(n = 0; n < CLIENT_WRITE_BATCH; n++) {
+      if(blockedClientCount > 0) {
+        // the packets wait in readBuffer, and the serial side drops when
+        // it is full
+        readBufferPending = true;
+        break;
+      }
+      if(!readBuffer.tryDequeue(packet)) {
+        break;
+      }
+      Metrics::instance().recordSince(METRIC_SERIAL_HANDOFF,
+                                      packet.getTimestamp(), Metrics::now());
+      if(shmRing != NULL) {
+        shmRing->publish(packet);
+      }
+
+      if(readClientCount == 0) {
+        DEBUG("TCPComm::writeToClients : no clients. discarding the packet");
+        continue;
+      }
+
+      // every client that wants the packet gets a reference to it
+      subscriptions.match(packet, receivers);
+      for(i = 0; i < receivers.size(); i++) {
+        it = clients.find(receivers[i]);
+        if(it == clients.end()) {
+          continue;
+        }
+        clientInfo_t *clientInfo = it->second;
 
-      if((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
-        if(clientInfo.clientFD > maxFD) {
-          maxFD = clientInfo.clientFD;
+        if(!queueToClient(clientInfo, packet)) {
+          DEBUG("TCPComm::writeToClients : client is too slow, disconnecting fd:"
+                << clientInfo->clientFD);
+          removeClient(clientInfo);
         }
-        FD_SET(clientInfo.clientFD, &rfds);
       }
     }
 
+    // clients that were idle are written right away, the others get the
+    // packets when the socket is writable again
+    flushBatch.clear();
+    for(it = clients.begin(); it != clients.end(); it = next) {
+      clientInfo_t *clientInfo = it->second;
+      next = it;
+      next++;
 
-    if(select(maxFD + 1, &rfds, NULL, NULL, NULL) < 0 ) {
-      ERROR("TCPComm::readFromClients : select(maxFD+1, &rfds, NULL, NULL, NULL)");
+      if(clientInfo->state != CLIENT_CONNECTED || clientInfo->waitingWrite ||
+         clientInfo->outQueue.empty()) {
+        continue;
+      }
+      if(uring.isReady()) {
+        flushBatch.push_back(clientInfo);
+      } else if(flushClient(clientInfo) < 0) {
+        DEBUG("TCPComm::writeToClients : removeClient");
+        removeClient(clientInfo);
+      }
+    }
+    if(!flushBatch.empty()) {
+      flushClients(flushBatch);
+    }
 
-    } else {
+    if(shmRing != NULL) {
+      shmRing->notify();
+    }
+    if(n < CLIENT_WRITE_BATCH) {
+      return;
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+TCPComm::isQueueFull(const clientInfo_t *clientInfo) const
+{
+  return clientInfo->outQueue.size() >= (size_t)clientQueueLength;
+}
+/*----------------------------------------------------------------------------*/
+bool
+TCPComm::queueToClient(clientInfo_t *clientInfo, const Packet &packet)
+{
+  std::deque<outFrame_t> &queue = clientInfo->outQueue;
+  size_t oldest;
+
+  if(isQueueFull(clientInfo)) {
+    switch(clientInfo->policy) {
+      case CLIENT_POLICY_BLOCK:
+        // writeToClients() does not get here while a BLOCK client is full
+        break;
+      case CLIENT_POLICY_DROP_OLDEST:
+        // a partly sent frame has to be finished, and so does a version 2
+        // frame whose length is fixed
+        oldest = clientInfo->frameLeft;
+        if(oldest == 0 && clientInfo->outPos > 0) {
+          oldest = 1;
+        }
+        while(oldest < queue.size() && queue[oldest].raw) {
+          oldest++;
+        }
+        CLIENT_METRIC_ADD(clientInfo->metrics->dropped, 1);
+        Metrics::instance().add(METRIC_CLIENT_DROPS);
+        if(oldest == queue.size()) {
+          clientInfo->nextSeq++;
+          return true;
+        }
+        queue.erase(queue.begin() + oldest);
+        break;
+      case CLIENT_POLICY_DISCONNECT:
+        clientInfo->nextSeq++;
+        CLIENT_METRIC_ADD(clientInfo->metrics->dropped, 1);
+        Metrics::instance().add(METRIC_CLIENT_DROPS);
+        Metrics::instance().add(METRIC_CLIENT_DISCONNECTS);
+        return false;
+      case CLIENT_POLICY_DROP_NEWEST:
+      default:
+        clientInfo->nextSeq++;
+        CLIENT_METRIC_ADD(clientInfo->metrics->dropped, 1);
+        Metrics::instance().add(METRIC_CLIENT_DROPS);
+        return true;
+    }
+  }
+
+  queueControl(clientInfo, packet);
+  CLIENT_METRIC_ADD(clientInfo->metrics->queued, 1);
 
-      for(it = clientInfoSet.begin(); it != clientInfoSet.end(); it++) {
-        clientInfo_t clientInfo = *it;
-        if((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W) {
-          if(FD_ISSET(clientInfo.clientFD, &rfds)) {
-            Packet packet;
-            if(readPacket(clientInfo, packet) < 0) {
-              // error on reading from client, we remove him
-              DEBUG("TCPComm::readFromClients : error on reading from client");
-              removeClient(clientInfo);
+  if(clientInfo->policy == CLIENT_POLICY_BLOCK && !clientInfo->blocked &&
+     isQueueFull(clientInfo)) {
+    clientInfo->blocked = true;
+    blockedClientCount++;
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+int
+TCPComm::buildHead(clientInfo_t *clientInfo, const Packet &packet, char *head)
+{
+  int pktLen = packet.getPacketLength();
+  uint64_t stamp;
+  int i, n;
+
+  if(clientInfo->version == PROTOCOL_V2) {
+    n = putVarint(head, pktLen);
+    head[n++] = packet.getPacketType();
+    if(clientInfo->features & FEATURE_SOURCE) {
+      head[n++] = packet.getSource();
+    }
+  } else {
+    head[0] = pktLen & 0xFF;
+    head[1] = (pktLen >> 8) & 0xFF;
+    head[2] = packet.getPacketType();
+    head[3] = packet.getSource();
+    n = PKT_META_LEN;
+  }
 
-            } else {
-              if(!writeBuffer.isFull()) {
-                writeBuffer.enqueueBack(packet);
-                DEBUG("TCPComm::readFromClients : packet qued");
-              } else {
-                DEBUG("TCPComm::readFromClients : read buffer is full. packet is dropped");
-              }
-            }
+  if(clientInfo->stampClock != 0) {
+    stamp = packet.getTimestamp();
+    if(stamp != 0 && clientInfo->stampClock == CLIENT_STAMP_REALTIME) {
+      stamp += __atomic_load_n(&realtimeOffset, __ATOMIC_RELAXED);
+    }
+    for(i = 0; i < PKT_STAMP_LEN; i++) {
+      head[n++] = (stamp >> (8 * i)) & 0xFF;
+    }
+  }
 
-          } // end of if(FD_ISSET(clientInfo.clientFD, &rfds))
-        } // end of if((clientInfo.mode & CLIENT_MODE_W) == CLIENT_MODE_W)
-      }
+  if(clientInfo->features & FEATURE_SEQ) {
+    n += putVarint(head + n, clientInfo->nextSeq);
+  }
+  clientInfo->nextSeq++;
+  return n;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::queueControl(clientInfo_t *clientInfo, const Packet &packet)
+{
+  char head[PKT_HEAD_MAX_LEN];
+  int n;
+
+  // a client of a sender gets it after the write under way
+  if(clientInfo->sender != NULL) {
+    pthread_mutex_lock(&clientInfo->sender->lock);
+    n = buildHead(clientInfo, packet, head);
+    if(clientInfo->version == PROTOCOL_V2) {
+      char frameHead[VARINT_MAX_LEN];
+      clientInfo->pending.append(frameHead, putVarint(frameHead,
+                                 n + packet.getPacketLength()));
     }
+    clientInfo->pending.append(head, n);
+    clientInfo->pending.append(packet.getPayload(), packet.getPacketLength());
+    pthread_mutex_unlock(&clientInfo->sender->lock);
+    wakeSender(clientInfo->sender);
+    return;
+  }
 
+  clientInfo->outQueue.push_back(outFrame_t());
+  outFrame_t &frame = clientInfo->outQueue.back();
+  frame.raw = false;
+  frame.packet = packet;
+  frame.headLen = buildHead(clientInfo, packet, frame.head);
+  updateClientMetrics(clientInfo);
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::queueRaw(clientInfo_t *clientInfo, const char *data, int len)
+{
+  clientInfo->outQueue.push_back(outFrame_t());
+  outFrame_t &frame = clientInfo->outQueue.back();
+  memcpy(frame.head, data, len);
+  frame.headLen = len;
+  frame.raw = true;
+  updateClientMetrics(clientInfo);
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::sealFrame(clientInfo_t *clientInfo)
+{
+  std::deque<outFrame_t> &queue = clientInfo->outQueue;
+  std::deque<outFrame_t>::iterator it;
+  outFrame_t frame;
+  uint64_t len = 0;
+  size_t n = 0;
+
+  for(it = queue.begin(); it != queue.end() && !it->raw &&
+      n < (size_t)CLIENT_FRAME_PACKETS; it++) {
+    len += it->headLen + it->packet.getPacketLength();
+    n++;
+  }
+  frame.headLen = putVarint(frame.head, len);
+  frame.raw = true;
+  queue.push_front(frame);
+  clientInfo->frameLeft = n + 1;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::updateClientMetrics(clientInfo_t *clientInfo)
+{
+  clientMetrics_t *metrics = clientInfo->metrics;
+  uint32_t length = clientInfo->outQueue.size();
+  std::deque<outFrame_t>::const_iterator it;
 
+  if(metrics == NULL) {
+    return;
+  }
+  CLIENT_METRIC_SET(metrics->length, length);
+  CLIENT_METRIC_MAX(metrics->highWater, length);
+  // skip the length of a frame and the like
+  for(it = clientInfo->outQueue.begin();
+      it != clientInfo->outQueue.end() && it->raw; it++);
+  CLIENT_METRIC_SET(metrics->oldestStamp,
+                    (it != clientInfo->outQueue.end()) ?
+                    it->packet.getTimestamp() : 0);
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::sendStats(clientInfo_t *clientInfo)
+{
+  char text[MAX_PKT_SIZE];
+  int len;
+  packetPoolStats_t pool;
+  Packet packet;
 
+  PacketPool::instance().getStats(pool);
+  len = snprintf(text, MAX_PKT_SIZE,
+                 "queued=%u dropped=%u highwater=%u length=%u policy=%d "
+                 "pool=%u/%u poolpeak=%u poolmisses=%u",
+                 CLIENT_METRIC_GET(clientInfo->metrics->queued),
+                 CLIENT_METRIC_GET(clientInfo->metrics->dropped),
+                 CLIENT_METRIC_GET(clientInfo->metrics->highWater),
+                 (unsigned int)clientInfo->outQueue.size(),
+                 clientInfo->policy,
+                 pool.inUse, pool.size, pool.peak, pool.misses);
+  if(len >= MAX_PKT_SIZE) {
+    len = MAX_PKT_SIZE - 1;
+  }
+  packet.setPayload(text, len, PKT_TYPE_STATS);
+  queueControl(clientInfo, packet);
+  if(!clientInfo->waitingWrite && flushClient(clientInfo) < 0) {
+    // removed by the caller on the next failed read or write
+    DEBUG("TCPComm::sendStats : Can not send to fd:"<<clientInfo->clientFD);
   }
 }
 /*----------------------------------------------------------------------------*/
+void
+TCPComm::subscribeClient(clientInfo_t *clientInfo, const char *data, int len)
+{
+  char reply;
+  int n = -1;
+  Packet packet;
 
-void *
-writeToClientsThreadFunc(void* ob)
+  if((clientInfo->mode & CLIENT_MODE_R) == CLIENT_MODE_R) {
+    pthread_rwlock_wrlock(&subscriptionLock);
+    n = subscriptions.subscribe(clientInfo->clientFD, data, len);
+    pthread_rwlock_unlock(&subscriptionLock);
+  }
+  if(n < 0) {
+    DEBUG("TCPComm::subscribeClient : Invalid subscription. fd:"
+          << clientInfo->clientFD);
+    reply = (char)SUBSCRIBE_REJECTED;
+  } else {
+    reply = n;
+  }
+
+  packet.setPayload(&reply, 1, PKT_TYPE_SUBSCRIBE);
+  queueControl(clientInfo, packet);
+  if(!clientInfo->waitingWrite && flushClient(clientInfo) < 0) {
+    // removed by the caller on the next failed read or write
+    DEBUG("TCPComm::subscribeClient : Can not send to fd:"<<clientInfo->clientFD);
+  }
+}
+/*----------------------------------------------------------------------------*/
+int
+TCPComm::gatherFrames(clientInfo_t *clientInfo, struct iovec *iov,
+                      size_t &total, bool &more)
 {
-  static_cast<TCPComm*>(ob)->writeToClients();
-  return NULL;
+  std::deque<outFrame_t> &queue = clientInfo->outQueue;
+  std::deque<outFrame_t>::iterator it;
+  size_t pos, frameLen, frames, limit;
+  int n;
+
+  // a version 2 client gets what is queued in a frame, which is written
+  // on its own
+  limit = queue.size();
+  if(clientInfo->version == PROTOCOL_V2) {
+    if(clientInfo->frameLeft == 0 && !queue.front().raw) {
+      sealFrame(clientInfo);
+    }
+    limit = (clientInfo->frameLeft > 0) ? clientInfo->frameLeft : 1;
+  }
+
+  // gather as many queued frames as fit into one write
+  n = 0;
+  total = 0;
+  frames = 0;
+  pos = clientInfo->outPos;
+  it = queue.begin();
+  while(it != queue.end() && frames < limit && n + 2 <= CLIENT_IOV_MAX) {
+    frameLen = it->headLen + it->packet.getPacketLength();
+    if(pos < (size_t)it->headLen) {
+      iov[n].iov_base = (void *)(it->head + pos);
+      iov[n].iov_len = it->headLen - pos;
+      total += iov[n++].iov_len;
+      pos = it->headLen;
+    }
+    if(pos < frameLen) {
+      iov[n].iov_base = (void *)(it->packet.getPayload() +
+                                 pos - it->headLen);
+      iov[n].iov_len = frameLen - pos;
+      total += iov[n++].iov_len;
+    }
+    pos = 0;
+    frames++;
+    it++;
+  }
+  more = (it != queue.end());
+  return n;
 }
 /*----------------------------------------------------------------------------*/
-void *
-readFromClientsThreadFunc(void* ob)
+void
+TCPComm::dropSent(clientInfo_t *clientInfo, size_t k)
 {
-  static_cast<TCPComm*>(ob)->readFromClients();
-  return NULL;
+  std::deque<outFrame_t> &queue = clientInfo->outQueue;
+  size_t frameLen, left;
+  int sent;
+  uint64_t now;
+  Metrics &metrics = Metrics::instance();
+
+  // drop the frames that went out, the last one may be partly sent
+  now = Metrics::now();
+  sent = 0;
+  left = k;
+  while(left > 0) {
+    frameLen = queue.front().headLen + queue.front().packet.getPacketLength();
+    if(left < frameLen - clientInfo->outPos) {
+      clientInfo->outPos += left;
+      break;
+    }
+    left -= frameLen - clientInfo->outPos;
+    if(!queue.front().raw) {
+      metrics.recordSince(METRIC_SERIAL_TO_CLIENT,
+                          queue.front().packet.getTimestamp(), now);
+      sent++;
+    }
+    if(clientInfo->frameLeft > 0) {
+      clientInfo->frameLeft--;
+    }
+    queue.pop_front();
+    clientInfo->outPos = 0;
+  }
+  metrics.add(METRIC_CLIENT_FRAMES_OUT, sent);
+  metrics.add(METRIC_CLIENT_BYTES_OUT, k);
+  if(clientInfo->metrics != NULL) {
+    CLIENT_METRIC_ADD(clientInfo->metrics->bytesOut, k);
+  }
 }
 /*----------------------------------------------------------------------------*/
 int
-TCPComm::writePacket(const clientInfo_t &clientInfo, Packet &packet)
+TCPComm::flushClient(clientInfo_t *clientInfo)
 {
-  char buf[4]; // for initial meta data of the packet
-  int k;
-  int pktLen = packet.getPacketLength();
+  struct msghdr msg;
+  struct iovec iov[CLIENT_IOV_MAX];
+  size_t total;
+  bool more;
+  int flags;
+  ssize_t k;
+
+  while(!clientInfo->outQueue.empty()) {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = gatherFrames(clientInfo, iov, total, more);
+    flags = MSG_NOSIGNAL;
+    if(CLIENT_MSG_MORE && more) {
+      flags |= MSG_MORE;
+    }
+    k = sendmsg(clientInfo->clientFD, &msg, flags);
+    if(k < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      if(errno != EAGAIN && errno != EWOULDBLOCK) {
+        DEBUG("TCPComm::flushClient : Can not send to fd:"<<clientInfo->clientFD);
+        return -1;
+      }
+      break;
+    }
+    dropSent(clientInfo, k);
 
-  buf[0] = pktLen & 0xFF;
-  buf[1] = (pktLen >> 8) & 0xFF;
-  buf[2] = packet.getPacketType();
-  buf[3] = 0; // this field is not used
+    // the socket is full
+    if((size_t)k < total) {
+      break;
+    }
+  }
+  return finishFlush(clientInfo);
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::flushClients(std::vector<clientInfo_t *> &batch)
+{
+  std::vector<clientInfo_t *> active, next, failed;
+  size_t i, m;
+  uint64_t userData;
+  int res, flags;
+
+  // each round sends once to every client that still has something to
+  // send and took all of its last write, with one io_uring_enter() for
+  // all of them
+  active = batch;
+  while(!active.empty()) {
+    m = std::min(active.size(), (size_t)CLIENT_URING_ENTRIES);
+    if(uringSends.size() < m) {
+      uringSends.resize(m);
+    }
+    for(i = 0; i < m; i++) {
+      uringSend_t &send = uringSends[i];
+      bool more;
+
+      send.clientInfo = active[i];
+      memset(&send.msg, 0, sizeof(send.msg));
+      send.msg.msg_iov = send.iov;
+      send.msg.msg_iovlen = gatherFrames(send.clientInfo, send.iov,
+                                         send.total, more);
+      // a full socket fails the send instead of leaving it in the ring
+      flags = MSG_NOSIGNAL | MSG_DONTWAIT;
+      if(CLIENT_MSG_MORE && more) {
+        flags |= MSG_MORE;
+      }
+      send.result = -EAGAIN;
+      uring.prepSendmsg(send.clientInfo->clientFD, &send.msg, flags, i);
+    }
+    if(uring.submitAndWait(m) < 0) {
+      ERROR("TCPComm::flushClients : io_uring_enter failed, using sendmsg");
+      uring.close();
+      for(i = 0; i < active.size(); i++) {
+        if(flushClient(active[i]) < 0) {
+          failed.push_back(active[i]);
+        }
+      }
+      break;
+    }
+    for(i = 0; i < m && uring.popCompletion(userData, res); i++) {
+      uringSends[userData].result = res;
+    }
 
-  // initial meta data of the packet
-  k = send(clientInfo.clientFD, buf, 4, NULL);
-  if(k != 4) {
-    DEBUG("TCPComm::writePacket : Can not send initial meta data fd:"<<clientInfo.clientFD);
-    return -1;
+    next.assign(active.begin() + m, active.end());
+    for(i = 0; i < m; i++) {
+      uringSend_t &send = uringSends[i];
+
+      if(send.result < 0) {
+        if(send.result == -EINTR) {
+          next.push_back(send.clientInfo);
+        } else if(send.result != -EAGAIN && send.result != -EWOULDBLOCK) {
+          DEBUG("TCPComm::flushClients : Can not send to fd:"
+                << send.clientInfo->clientFD);
+          failed.push_back(send.clientInfo);
+        }
+        continue;
+      }
+      dropSent(send.clientInfo, send.result);
+      if((size_t)send.result == send.total &&
+         !send.clientInfo->outQueue.empty()) {
+        next.push_back(send.clientInfo);
+      }
+    }
+    active.swap(next);
   }
 
-  k = writeAll(clientInfo.clientFD, packet.getPayload(), pktLen);
-  if(k != pktLen) {
-    DEBUG("TCPComm::writePacket : Can not send packet payload fd:"<<clientInfo.clientFD);
+  for(i = 0; i < batch.size(); i++) {
+    if(std::find(failed.begin(), failed.end(), batch[i]) == failed.end() &&
+       finishFlush(batch[i]) < 0) {
+      failed.push_back(batch[i]);
+    }
+  }
+  for(i = 0; i < failed.size(); i++) {
+    removeClient(failed[i]);
+  }
+}
+/*----------------------------------------------------------------------------*/
+int
+TCPComm::finishFlush(clientInfo_t *clientInfo)
+{
+  std::deque<outFrame_t> &queue = clientInfo->outQueue;
+  struct epoll_event ev;
+
+  updateClientMetrics(clientInfo);
+  if(clientInfo->blocked && !isQueueFull(clientInfo)) {
+    clientInfo->blocked = false;
+    blockedClientCount--;
+  }
+
+  if(queue.empty() && clientInfo->state == CLIENT_CLOSING) {
     return -1;
   }
 
+  // only wait for write readiness while something is left to send
+  bool wantWrite = !queue.empty();
+  if(wantWrite != clientInfo->waitingWrite) {
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0);
+    ev.data.fd = clientInfo->clientFD;
+    if(epoll_ctl(epollFD, EPOLL_CTL_MOD, clientInfo->clientFD, &ev) < 0) {
+      ERROR("TCPComm::finishFlush : epoll_ctl fd:" << clientInfo->clientFD);
+      return -1;
+    }
+    clientInfo->waitingWrite = wantWrite;
+  }
   return 0;
 }
 /*----------------------------------------------------------------------------*/
-int
-TCPComm::readPacket(const clientInfo_t &clientInfo, Packet &packet)
+void
+TCPComm::wakeSender(sender_t *sender)
 {
-  char pktBuf[packet.getMaxPacketSize()]; // for the packet buffer
-  char buf[4]; // for initial meta data of the packet
-  int k;
-  int pktLen;
-  int pktType;
+  uint64_t one = 1;
 
-  k = recv(clientInfo.clientFD, buf, 4, NULL);
-  if(k != 4) {
-    DEBUG("TCPComm::readPacket : Can not receive initial meta data fd : "
-                                                         <<clientInfo.clientFD);
-    return -1;
+  if(write(sender->wakeFD, &one, sizeof(one)) < 0) {
+    DEBUG("TCPComm::wakeSender : can not wake sender");
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::publishToRing()
+{
+  Packet packet;
+  uint64_t next;
+  int i, n = 0;
+
+  while(readBuffer.tryDequeue(packet)) {
+    Metrics::instance().recordSince(METRIC_SERIAL_HANDOFF,
+                                    packet.getTimestamp(), Metrics::now());
+    if(shmRing != NULL) {
+      shmRing->publish(packet);
+    }
+    if(readClientCount == 0) {
+      DEBUG("TCPComm::publishToRing : no clients. discarding the packet");
+      continue;
+    }
+    // the packet takes the slot of the one a whole ring before it
+    next = ring->getPublished();
+    if(next - gateSeq >= (uint64_t)ring->getCapacity()) {
+      gateSeq = slowestCursor();
+    }
+    ring->publish(packet);
+    n++;
   }
 
-  pktLen = (unsigned char)buf[0] + (unsigned char)(buf[1] << 8);
-  pktType = buf[2];
-  //DEBUG("TCPComm::readPacket : receive initial meta data len:" << pktLen);
+  if(shmRing != NULL) {
+    shmRing->notify();
+  }
+  for(i = 0; n > 0 && i < senderCount; i++) {
+    wakeSender(&senders[i]);
+  }
+}
+/*----------------------------------------------------------------------------*/
+uint64_t
+TCPComm::slowestCursor()
+{
+  std::map<int, clientInfo_t *>::iterator it, next;
+  uint64_t published = ring->getPublished();
+  uint64_t slowest = published;
+  uint64_t cursor;
 
-  if(pktLen > packet.getMaxPacketSize()) {
-    DEBUG("TCPComm::readPacket : Can not accept more than the maximum packet size");
-    return -1;
+  for(it = clients.begin(); it != clients.end(); it = next) {
+    clientInfo_t *clientInfo = it->second;
+    next = it;
+    next++;
+
+    if(clientInfo->sender == NULL) {
+      continue;
+    }
+    cursor = __atomic_load_n(&clientInfo->cursor, __ATOMIC_ACQUIRE);
+    if(published - cursor >= (uint64_t)ring->getCapacity()) {
+      DEBUG("TCPComm::slowestCursor : client is too slow, disconnecting fd:"
+            << clientInfo->clientFD);
+      CLIENT_METRIC_ADD(clientInfo->metrics->dropped, 1);
+      Metrics::instance().add(METRIC_CLIENT_DROPS);
+      Metrics::instance().add(METRIC_CLIENT_DISCONNECTS);
+      removeClient(clientInfo);
+      continue;
+    }
+    if(cursor < slowest) {
+      slowest = cursor;
+    }
   }
+  return slowest;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::removeFailedClients()
+{
+  std::map<int, clientInfo_t *>::iterator it, next;
+
+  for(it = clients.begin(); it != clients.end(); it = next) {
+    next = it;
+    next++;
+    if(it->second->sender != NULL &&
+       __atomic_load_n(&it->second->failed, __ATOMIC_ACQUIRE)) {
+      DEBUG("TCPComm::removeFailedClients : removeClient");
+      removeClient(it->second);
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::runSender(sender_t *sender)
+{
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  struct epoll_event ev;
+  uint64_t count, one = 1;
+  unsigned int i;
+  bool failed, wantWrite;
 
-  k = readAll(clientInfo.clientFD, pktBuf, pktLen);
-  if(k != pktLen) {
-    DEBUG("TCPComm::readPacket : Can not receive packet payload");
-    return -1;
+  while(true) {
+    // woken for new packets, answers or a client that takes more
+    if(epoll_wait(sender->epollFD, events, EPOLL_MAX_EVENTS, -1) < 0 &&
+       errno != EINTR) {
+      ERROR("TCPComm::runSender : epoll_wait");
+    }
+    while(read(sender->wakeFD, &count, sizeof(count)) > 0);
+
+    // a half served client would be left locked
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    failed = false;
+    pthread_mutex_lock(&sender->lock);
+    pthread_rwlock_rdlock(&subscriptionLock);
+    for(i = 0; i < sender->clients.size(); i++) {
+      clientInfo_t *clientInfo = sender->clients[i];
+
+      if(clientInfo->failed) {
+        continue;
+      }
+      if(!sendFromRing(clientInfo)) {
+        DEBUG("TCPComm::runSender : Can not send to fd:"<<clientInfo->clientFD);
+        __atomic_store_n(&clientInfo->failed, true, __ATOMIC_RELEASE);
+        failed = true;
+        continue;
+      }
+
+      // only wait for write readiness while something is left to send
+      wantWrite = !clientInfo->pending.empty();
+      if(wantWrite != clientInfo->senderWaiting) {
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLOUT;
+        ev.data.fd = clientInfo->clientFD;
+        if(epoll_ctl(sender->epollFD, wantWrite ? EPOLL_CTL_ADD : EPOLL_CTL_DEL,
+                     clientInfo->clientFD, &ev) < 0) {
+          ERROR("TCPComm::runSender : epoll_ctl fd:" << clientInfo->clientFD);
+        }
+        clientInfo->senderWaiting = wantWrite;
+      }
+    }
+    pthread_rwlock_unlock(&subscriptionLock);
+    pthread_mutex_unlock(&sender->lock);
+
+    // the event thread removes the client
+    if(failed && write(senderFailFD, &one, sizeof(one)) < 0) {
+      ERROR("TCPComm::runSender : can not notify the event thread");
+    }
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+  }
+}
+/*----------------------------------------------------------------------------*/
+bool
+TCPComm::sendFromRing(clientInfo_t *clientInfo)
+{
+  struct msghdr msg;
+  struct iovec iov[CLIENT_IOV_MAX];
+  char heads[CLIENT_FRAME_PACKETS][PKT_HEAD_MAX_LEN];
+  char frameHead[VARINT_MAX_LEN];
+  uint64_t stamps[CLIENT_FRAME_PACKETS];
+  uint64_t seq, published, now;
+  size_t frameLen, done, skip;
+  int i, n, packets, flags;
+  ssize_t k;
+  Metrics &metrics = Metrics::instance();
+
+  // what is left over goes first
+  while(!clientInfo->pending.empty()) {
+    k = send(clientInfo->clientFD, clientInfo->pending.data(),
+             clientInfo->pending.size(), MSG_NOSIGNAL);
+    if(k < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    metrics.add(METRIC_CLIENT_BYTES_OUT, k);
+    CLIENT_METRIC_ADD(clientInfo->metrics->bytesOut, k);
+    clientInfo->pending.erase(0, k);
   }
-  //DEBUG("TCPComm::readPacket : receive payload");
-  packet.setPayload(pktBuf, pktLen, pktType);
 
-  return 0;
+  published = ring->getPublished();
+  seq = clientInfo->cursor;
+  while(seq < published && clientInfo->pending.empty()) {
+    // the packets of one write, a version 2 client gets them in a frame
+    n = (clientInfo->version == PROTOCOL_V2) ? 1 : 0;
+    packets = 0;
+    frameLen = 0;
+    while(seq < published && packets < CLIENT_FRAME_PACKETS &&
+          n + 2 <= CLIENT_IOV_MAX) {
+      const Packet &packet = ring->get(seq++);
+      if(!subscriptions.wants(clientInfo->clientFD, packet)) {
+        continue;
+      }
+      iov[n].iov_base = heads[packets];
+      iov[n].iov_len = buildHead(clientInfo, packet, heads[packets]);
+      frameLen += iov[n++].iov_len;
+      if(packet.getPacketLength() > 0) {
+        iov[n].iov_base = (void *)packet.getPayload();
+        iov[n].iov_len = packet.getPacketLength();
+        frameLen += iov[n++].iov_len;
+      }
+      stamps[packets++] = packet.getTimestamp();
+    }
+    if(packets == 0) {
+      continue;
+    }
+    if(clientInfo->version == PROTOCOL_V2) {
+      iov[0].iov_base = frameHead;
+      iov[0].iov_len = putVarint(frameHead, frameLen);
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+    flags = MSG_NOSIGNAL;
+    if(CLIENT_MSG_MORE && seq < published) {
+      flags |= MSG_MORE;
+    }
+    do {
+      k = sendmsg(clientInfo->clientFD, &msg, flags);
+    } while(k < 0 && errno == EINTR);
+    if(k < 0) {
+      if(errno != EAGAIN && errno != EWOULDBLOCK) {
+        return false;
+      }
+      k = 0;
+    }
+
+    // the ring may overwrite what did not go out, so it is kept aside
+    done = 0;
+    for(i = 0; i < n; i++) {
+      if(done + iov[i].iov_len > (size_t)k) {
+        skip = ((size_t)k > done) ? k - done : 0;
+        clientInfo->pending.append((char *)iov[i].iov_base + skip,
+                                   iov[i].iov_len - skip);
+      }
+      done += iov[i].iov_len;
+    }
+
+    now = Metrics::now();
+    for(i = 0; i < packets; i++) {
+      metrics.recordSince(METRIC_SERIAL_TO_CLIENT, stamps[i], now);
+    }
+    metrics.add(METRIC_CLIENT_FRAMES_OUT, packets);
+    metrics.add(METRIC_CLIENT_BYTES_OUT, k);
+    CLIENT_METRIC_ADD(clientInfo->metrics->queued, packets);
+    CLIENT_METRIC_ADD(clientInfo->metrics->bytesOut, k);
+    // the event thread may reuse the slots up to the cursor
+    __atomic_store_n(&clientInfo->cursor, seq, __ATOMIC_RELEASE);
+  }
+  __atomic_store_n(&clientInfo->cursor, seq, __ATOMIC_RELEASE);
+
+  CLIENT_METRIC_SET(clientInfo->metrics->length, (uint32_t)(published - seq));
+  CLIENT_METRIC_MAX(clientInfo->metrics->highWater,
+                    (uint32_t)(published - seq));
+  CLIENT_METRIC_SET(clientInfo->metrics->oldestStamp,
+                    (seq < published) ? ring->get(seq).getTimestamp() : 0);
+  return true;
 }
 /*----------------------------------------------------------------------------*/
 void
 TCPComm::cancel()
 {
-  pthread_t callingThread = pthread_self();
-
-  if(pthread_equal(callingThread, readerThread)) {
-    DEBUG("TCPComm::cancel : by readerThread")
-    pthread_detach(readerThread);
-    if(writerThreadRunning) {
-      pthread_cancel(writerThread);
-      DEBUG("TCPComm::cancel : writerThread canceled, joining")
-      pthread_join(writerThread, NULL);
-      writerThreadRunning = false;
-    }
-    if(serverThreadRunning) {
-      pthread_cancel(serverThread);
-       DEBUG("TCPComm::cancel : serverThread canceled, joining")
-       pthread_join(serverThread, NULL);
-       serverThreadRunning = false;
-    }
-    readerThreadRunning = false;
-    pthread_exit(NULL);
-
-  } else if(pthread_equal(callingThread, writerThread)) {
-    DEBUG("TCPComm::cancel : by writerThread")
-    pthread_detach(writerThread);
-    if(readerThreadRunning) {
-      pthread_cancel(readerThread);
-      DEBUG("TCPComm::cancel : readerThread canceled, joining")
-      pthread_join(readerThread, NULL);
-      readerThreadRunning = false;
-    }
-    if(serverThreadRunning) {
-      pthread_cancel(serverThread);
-      DEBUG("TCPComm::cancel : serverThread canceled, joining")
-      pthread_join(serverThread, NULL);
-      serverThreadRunning = false;
-    }
-    writerThreadRunning = false;
-    pthread_exit(NULL);
-
-  } else if(pthread_equal(callingThread, serverThread)) {
-    DEBUG("TCPComm::cancel : by serverThread")
-    pthread_detach(serverThread);
-    if(readerThreadRunning) {
-      pthread_cancel(readerThread);
-      DEBUG("TCPComm::cancel : readerThread canceled, joining")
-	    pthread_join(readerThread, NULL);
-      readerThreadRunning = false;
-    }
-    if(writerThreadRunning) {
-      pthread_cancel(writerThread);
-      DEBUG("TCPComm::cancel : writerThread canceled, joining")
-      pthread_join(writerThread, NULL);
-      writerThreadRunning = false;
-    }
-    serverThreadRunning = false;
-    pthread_exit(NULL);
-
-  } else {
+  std::map<int, clientInfo_t *>::iterator it;
+  int i;
+
+  if(eventThreadRunning) {
+    if(pthread_equal(pthread_self(), eventThread)) {
+      DEBUG("TCPComm::cancel : by eventThread")
+      pthread_detach(eventThread);
+      eventThreadRunning = false;
+      pthread_exit(NULL);
+    }
     DEBUG("TCPComm::cancel : by other thread")
-	  if(serverThreadRunning) {
-      pthread_cancel(serverThread);
-      DEBUG("TCPComm::cancel : serverThread canceled, joining")
-      pthread_join(serverThread, NULL);
-      serverThreadRunning = false;
+    pthread_cancel(eventThread);
+    DEBUG("TCPComm::cancel : eventThread canceled, joining")
+    pthread_join(eventThread, NULL);
+    eventThreadRunning = false;
+  }
+
+  for(i = 0; senders != NULL && i < senderCount; i++) {
+    if(senders[i].running) {
+      pthread_cancel(senders[i].thread);
+      pthread_join(senders[i].thread, NULL);
     }
- 	  if(writerThreadRunning) {
-      pthread_cancel(writerThread);
-      DEBUG("TCPComm::cancel : writerThread canceled, joining")
-      pthread_join(writerThread, NULL);
-      writerThreadRunning = false;
+    if(senders[i].wakeFD >= 0) {
+      close(senders[i].wakeFD);
     }
-    if(readerThreadRunning) {
-      pthread_cancel(readerThread);
-      DEBUG("TCPComm::cancel : readerThread canceled, joining")
-      pthread_join(readerThread, NULL);
-      readerThreadRunning = false;
+    if(senders[i].epollFD >= 0) {
+      close(senders[i].epollFD);
     }
+    pthread_mutex_destroy(&senders[i].lock);
   }
+  delete[] senders;
+  senders = NULL;
 
+  readBuffer.setNotifyFD(-1);
+  for(it = clients.begin(); it != clients.end(); it++) {
+    if(it->second->metrics != NULL) {
+      it->second->metrics->fd = -1;
+    }
+    close(it->second->clientFD);
+    delete it->second;
+  }
+  clients.clear();
+  subscriptions.clear();
+  delete ring;
+  ring = NULL;
+  uring.close();
+
+  if(senderFailFD >= 0) {
+    close(senderFailFD);
+    senderFailFD = -1;
+  }
+  if(readBufferFD >= 0) {
+    close(readBufferFD);
+    readBufferFD = -1;
+  }
+  if(epollFD >= 0) {
+    close(epollFD);
+    epollFD = -1;
+  }
+  if(serverFD >= 0) {
+    close(serverFD);
+    serverFD = -1;
+  }
+  if(unixFD >= 0) {
+    close(unixFD);
+    unixFD = -1;
+    unlink(unixPath.c_str());
+  }
 }
+/*----------------------------------------------------------------------------*/
+bool
+TCPComm::waitForReadClient(unsigned int mSecs)
+{
+  struct timespec ts;
+  bool ret;
+
+  clock_gettime(CLOCK_REALTIME, &ts);
+  ts.tv_sec += mSecs / 1000;
+  ts.tv_nsec += (mSecs % 1000) * 1000000L;
+  if(ts.tv_nsec >= 1000000000L) {
+    ts.tv_sec++;
+    ts.tv_nsec -= 1000000000L;
+  }
 
+  pthread_mutex_lock(&readClientLock);
+  while(readClientCount == 0 &&
+        pthread_cond_timedwait(&readClientCond, &readClientLock, &ts) == 0);
+  ret = readClientCount > 0;
+  pthread_mutex_unlock(&readClientLock);
+  return ret;
+}
+/*----------------------------------------------------------------------------*/
+void
+TCPComm::getClientMetrics(std::vector<clientMetrics_t> &metrics) const
+{
+  unsigned int i;
+  clientMetrics_t copy;
+
+  metrics.clear();
+  for(i = 0; i < (unsigned int)clientMetricsCount; i++) {
+    if(__atomic_load_n(&clientMetrics[i].fd, __ATOMIC_ACQUIRE) < 0) {
+      continue;
+    }
+    // the counters may change while they are copied, each one is read
+    // whole
+    copy.fd = clientMetrics[i].fd;
+    copy.port = clientMetrics[i].port;
+    copy.mode = clientMetrics[i].mode;
+    copy.policy = clientMetrics[i].policy;
+    copy.version = clientMetrics[i].version;
+    copy.queued = CLIENT_METRIC_GET(clientMetrics[i].queued);
+    copy.dropped = CLIENT_METRIC_GET(clientMetrics[i].dropped);
+    copy.highWater = CLIENT_METRIC_GET(clientMetrics[i].highWater);
+    copy.length = CLIENT_METRIC_GET(clientMetrics[i].length);
+    copy.bytesOut = CLIENT_METRIC_GET(clientMetrics[i].bytesOut);
+    copy.oldestStamp = CLIENT_METRIC_GET(clientMetrics[i].oldestStamp);
+    if(copy.fd >= 0) {
+      metrics.push_back(copy);
+    }
+  }
+}
+/*----------------------------------------------------------------------------*/
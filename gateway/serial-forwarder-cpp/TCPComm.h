@@ -35,6 +35,20 @@
 
 /* \file
  *      Header file of the TCP communication module.
+ *      One thread runs an epoll loop over the server socket, all connected
+ *      clients and the read buffer. Sockets are non-blocking and every
+ *      client has its own outbound buffer, so a slow client only delays
+ *      itself.
+ *      With sender threads, packets for read clients are put into one
+ *      broadcast ring instead. Each sender thread serves a share of the
+ *      read clients, every client reading the ring from a cursor of its
+ *      own, and the event thread only stores each packet once.
+ *      Local clients may connect to a Unix socket instead of the port,
+ *      they speak the same protocol. Local consumers that only read may
+ *      also map the shared memory ring of ShmRing, which gets every packet
+ *      taken from the read buffer.
+ *      With io_uring, the idle clients written to after a batch of packets
+ *      are sent to with one io_uring_enter() instead of a sendmsg() each.
  */
 
 
@@ -43,14 +57,22 @@
 
 #include <pthread.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <stdint.h>
 
-#include <set>
+#include <deque>
+#include <map>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "BaseComm.h"
+#include "BroadcastRing.h"
+#include "IoUring.h"
+#include "Metrics.h"
 #include "PacketBuffer.h"
+#include "ShmRing.h"
+#include "Subscriptions.h"
 
 /* hanshaking error codes  */
 #define ERR_UNKNOWN -1
@@ -65,11 +87,119 @@
 #define CLIENT_MODE_W  2 // write
 #define CLIENT_MODE_RW 3 // read + write
 
+/*
+ * What happens to a packet for a read client whose queue is full. A client
+ * asks for a policy in the last byte of its handshake, the server answers
+ * with the policy in effect.
+ *   BLOCK       - stop taking packets from the serial side until the client
+ *                 catches up. Every client waits for it.
+ *   DROP_OLDEST - drop the oldest queued packet, for live views.
+ *   DROP_NEWEST - drop the new packet.
+ *   DISCONNECT  - close the client.
+ */
+#define CLIENT_POLICY_DEFAULT     0
+#define CLIENT_POLICY_BLOCK       1
+#define CLIENT_POLICY_DROP_OLDEST 2
+#define CLIENT_POLICY_DROP_NEWEST 3
+#define CLIENT_POLICY_DISCONNECT  4
+
+/* Packet type a client sends, with no payload, to get the counters of its
+ * queue back in a packet of the same type. */
+#define PKT_TYPE_STATS 3
+
+/* Packet type a read client sends to choose the packets it gets. The
+ * payload is a list of filters, see Subscriptions.h, and replaces the
+ * client's filters; an empty list means every packet. The answer is a
+ * packet of the same type with one byte, the number of filters in effect,
+ * or SUBSCRIBE_REJECTED if the list was not accepted. */
+#define PKT_TYPE_SUBSCRIBE 4
+#define SUBSCRIBE_REJECTED 0xFF
+
+/*
+ * Every packet is sent with 4 bytes of meta data in front of it:
+ *   length (2, little endian) | type (1) | sink (1)
+ * The sink byte of a packet from the serial side is the number of the sink
+ * it was read from. A client writing a packet sets it to the sink the
+ * packet is for, or to PKT_SOURCE_ANY for all of them.
+ */
+
+/*
+ * A read client may ask for the time each packet was read from the serial
+ * side by adding one of these flags to the policy byte of its handshake.
+ * The policy byte of the answer carries the flag if it was accepted. Every
+ * frame after the handshake then has the time in nanoseconds, 8 bytes
+ * little endian, after the meta data:
+ *   length (2) | type (1) | sink (1) | time (8) | payload
+ * The length is still that of the payload. The time is 0 for packets that
+ * were not read from a sink, such as answers to PKT_TYPE_STATS. Packets
+ * clients send have no time.
+ * CLIENT_STAMP_MONOTONIC is CLOCK_MONOTONIC of the forwarder's host, for
+ * latencies, CLIENT_STAMP_REALTIME is wall clock time, for merging the
+ * streams of several forwarders. Asking for both gets the monotonic one.
+ */
+#define CLIENT_POLICY_MASK     0x0F
+#define CLIENT_STAMP_MONOTONIC 0x10
+#define CLIENT_STAMP_REALTIME  0x20
+
+/* length of the handshake and of the meta data in front of every packet */
+#define HANDSHAKE_LEN 4
+#define PKT_META_LEN 4
+#define PKT_STAMP_LEN 8
+
+/*
+ * Protocol versions a client may ask for in the first byte of its
+ * handshake, the minor version has to be 0. A client asking for another
+ * version gets the 4 byte answer of version 1 with ERR_UNSUPPORTED_VERSION
+ * and the newest version the forwarder speaks.
+ *
+ * Version 2 carries many packets in a frame. The handshake has a fifth
+ * byte, the features the client wants, and the answer has the same five
+ * bytes with the features that were granted. The stamp flags of the policy
+ * byte are not used, the clock is a feature. After the handshake both
+ * sides send frames:
+ *   length (varint) | record | record | ...
+ * where length counts the bytes of the records and each record is
+ *   length (varint) | type (1) | [sink (1)] | [time (8)] | [seq (varint)]
+ *   | payload
+ * Varints are unsigned LEB128, 7 bits a byte starting with the lowest and
+ * the top bit set on all bytes but the last. The record length is that of
+ * the payload. Which of the fields in brackets are there depends on the
+ * features granted:
+ *   FEATURE_SOURCE         - the sink byte, in both directions. Without it
+ *                            packets from clients go to every sink.
+ *   FEATURE_STAMP_MONOTONIC,
+ *   FEATURE_STAMP_REALTIME - the time the packet was read from a sink, as
+ *                            with the CLIENT_STAMP_* flags of version 1.
+ *                            Only in records sent to the client.
+ *   FEATURE_SEQ            - the number of the record in the stream sent to
+ *                            the client, starting at 0. Packets the client
+ *                            did not get because of its queue policy leave
+ *                            a gap. Only in records sent to the client.
+ * A frame may have no records, and a client is free to send one packet a
+ * frame. The forwarder puts every packet that is waiting for a client, up
+ * to CLIENT_FRAME_PACKETS of them, into one frame.
+ */
+#define PROTOCOL_V1 1
+#define PROTOCOL_V2 2
+#define HANDSHAKE_V2_LEN 5
+
+#define FEATURE_SOURCE          0x01
+#define FEATURE_STAMP_MONOTONIC 0x02
+#define FEATURE_STAMP_REALTIME  0x04
+#define FEATURE_SEQ             0x08
+#define FEATURES_SUPPORTED      0x0F
+
+/* longest varint of a 32 / 64 bit value */
+#define VARINT_MAX_LEN   5
+#define VARINT64_MAX_LEN 10
+
+/* longest head of a frame in either version */
+#define PKT_HEAD_MAX_LEN (VARINT_MAX_LEN + 2 + PKT_STAMP_LEN + VARINT64_MAX_LEN)
 
 #ifdef CONF_MAX_READ_CLIENTS
 #define MAX_READ_CLIENTS CONF_MAX_READ_CLIENTS
 #else
-#define MAX_READ_CLIENTS 10
+#define MAX_READ_CLIENTS 256
 #endif
 
 #ifdef CONF_MAX_WRITE_CLIENTS
@@ -78,28 +208,138 @@
 #define MAX_WRITE_CLIENTS 1
 #endif
 
+/* Connections the kernel queues before they are accepted. */
+#ifdef CONF_LISTEN_QUEUE_LENGTH
+#define LISTEN_QUEUE_LENGTH CONF_LISTEN_QUEUE_LENGTH
+#else
+#define LISTEN_QUEUE_LENGTH 128
+#endif
+
+/* Packets that may wait to be sent to one client. */
+#ifdef CONF_CLIENT_QUEUE_LENGTH
+#define CLIENT_QUEUE_LENGTH CONF_CLIENT_QUEUE_LENGTH
+#else
+#define CLIENT_QUEUE_LENGTH 256
+#endif
+
+/* SO_SNDBUF of client sockets, 0 keeps the kernel default. The kernel
+ * buffer comes before the client queue, so a small one makes the queue
+ * policy act sooner on a stalled client. */
+#ifdef CONF_CLIENT_SNDBUF
+#define CLIENT_SNDBUF CONF_CLIENT_SNDBUF
+#else
+#define CLIENT_SNDBUF 0
+#endif
+
+/* Reads of a client socket per readiness event. Client sockets are level
+ * triggered, so data left behind is reported again on the next wakeup and
+ * a flooding writer can not keep the event thread to itself. */
+#ifdef CONF_CLIENT_READS_PER_EVENT
+#define CLIENT_READS_PER_EVENT CONF_CLIENT_READS_PER_EVENT
+#else
+#define CLIENT_READS_PER_EVENT 1
+#endif
+
+#ifdef CONF_DEFAULT_CLIENT_POLICY
+#define DEFAULT_CLIENT_POLICY CONF_DEFAULT_CLIENT_POLICY
+#else
+#define DEFAULT_CLIENT_POLICY CLIENT_POLICY_DROP_NEWEST
+#endif
+
+/* Number of iovecs of one gather write to a client, a frame takes up to
+ * two of them. */
+#ifdef CONF_CLIENT_IOV_MAX
+#define CLIENT_IOV_MAX CONF_CLIENT_IOV_MAX
+#else
+#define CLIENT_IOV_MAX 64
+#endif
+
+/* Whether a gather write that leaves frames behind is sent with MSG_MORE,
+ * so the kernel fills whole segments across writes. */
+#ifdef CONF_CLIENT_MSG_MORE
+#define CLIENT_MSG_MORE CONF_CLIENT_MSG_MORE
+#else
+#define CLIENT_MSG_MORE 1
+#endif
+
+/* Packets put into one frame for a version 2 client. A frame is sent with
+ * one gather write, which takes two iovecs a packet and one for the
+ * length of the frame. */
+#ifdef CONF_CLIENT_FRAME_PACKETS
+#define CLIENT_FRAME_PACKETS CONF_CLIENT_FRAME_PACKETS
+#else
+#define CLIENT_FRAME_PACKETS ((CLIENT_IOV_MAX - 1) / 2)
+#endif
+
+/* Packets taken from readBuffer before the clients are written to. */
+#ifdef CONF_CLIENT_WRITE_BATCH
+#define CLIENT_WRITE_BATCH CONF_CLIENT_WRITE_BATCH
+#else
+#define CLIENT_WRITE_BATCH 32
+#endif
+
+/* Packets the broadcast ring of the sender threads holds. A read client
+ * that falls that far behind is disconnected, so with sender threads
+ * every read client has the DISCONNECT policy. */
+#ifdef CONF_SENDER_RING_SIZE
+#define SENDER_RING_SIZE CONF_SENDER_RING_SIZE
+#else
+#define SENDER_RING_SIZE 4096
+#endif
+
+/* Sends submitted to io_uring at once, see setIoUring(). */
+#ifdef CONF_CLIENT_URING_ENTRIES
+#define CLIENT_URING_ENTRIES CONF_CLIENT_URING_ENTRIES
+#else
+#define CLIENT_URING_ENTRIES 256
+#endif
+
+/* Number of events taken from epoll at once. */
+#ifdef CONF_EPOLL_MAX_EVENTS
+#define EPOLL_MAX_EVENTS CONF_EPOLL_MAX_EVENTS
+#else
+#define EPOLL_MAX_EVENTS 64
+#endif
+
 class TCPComm : public BaseComm
 {
   protected:
 
-    const static int maxReadClients = MAX_READ_CLIENTS;
+    /* limits, MAX_READ_CLIENTS and the like unless set before start() */
+    int maxReadClients;
+
+    int maxWriteClients;
 
-    const static int maxWriteClients = MAX_WRITE_CLIENTS;
+    int clientQueueLength;
 
-    /* socket server pthread */
-    pthread_t serverThread;
+    int listenBacklog;
 
-    bool serverThreadRunning;
+    int senderRingSize;
 
-    /* pthread for tcp client reading */
-    pthread_t readerThread;
+    /* pthread running the event loop */
+    pthread_t eventThread;
 
-    bool readerThreadRunning;
+    bool eventThreadRunning;
 
-    /* pthread for tcp client writing */
-    pthread_t writerThread;
+    enum ClientState {
+      CLIENT_HANDSHAKE = 1,
+      CLIENT_CONNECTED = 2,
+      CLIENT_CLOSING = 3    // close once the outbound buffer is sent
+    };
 
-    bool writerThreadRunning;
+    /* A frame queued to a client, headLen bytes of head followed by the
+     * payload of packet. The packet is shared with the other clients it is
+     * queued to. For a version 2 client the frames of packets are the
+     * records, and raw ones, the length of a frame or the answer to the
+     * handshake, go in between. */
+    typedef struct outFrame {
+      char head[PKT_HEAD_MAX_LEN];
+      int headLen;
+      bool raw;
+      Packet packet;
+    } outFrame_t;
+
+    struct sender;
 
     /* strcuture to keep information of connected clients. */
     typedef struct clientInfo {
@@ -114,39 +354,132 @@ class TCPComm : public BaseComm
       int clientPort;
       /* client connected mode */
       int mode;
-      /* overriding the default less than operator */
-      friend bool operator<(clientInfo const& a, clientInfo const& b)
-      {
-        return a.clientFD < b.clientFD;
-      }
-
+      int state;
+      /* protocol version, and the features granted to a version 2 client */
+      int version;
+      int features;
+      /* bytes received but not yet handled */
+      char inBuf[PKT_HEAD_MAX_LEN + MAX_PKT_SIZE];
+      int inLen;
+      /* bytes of the version 2 frame being received that are still to
+       * come, 0 between frames */
+      uint32_t inFrameLeft;
+      /* frames to be sent, outPos bytes of the first one are sent */
+      std::deque<outFrame_t> outQueue;
+      size_t outPos;
+      /* frames at the front of outQueue that make up the version 2 frame
+       * being sent, its length included */
+      size_t frameLeft;
+      /* number of the next record for FEATURE_SEQ */
+      uint64_t nextSeq;
+      /* what to do when outQueue is full */
+      int policy;
+      /* clock frames are stamped with, 0 if they are not */
+      int stampClock;
+      /* counters of the client, NULL until the handshake is done */
+      clientMetrics_t *metrics;
+      /* BLOCK client counted in blockedClientCount */
+      bool blocked;
+      /* whether EPOLLOUT is set for the client */
+      bool waitingWrite;
+      /* sender thread of a read client, NULL without sender threads */
+      struct sender *sender;
+      /* the following are guarded by the lock of the sender */
+      /* next sequence of the ring to send */
+      volatile uint64_t cursor;
+      /* bytes to send before anything else, the rest of a partly sent
+       * write and answers queued by the event thread */
+      std::string pending;
+      /* whether the sender waits for the socket to be writable */
+      bool senderWaiting;
+      /* the sender could not write to the client */
+      volatile bool failed;
     } clientInfo_t;
 
-    //typedef std::set<clientInfo_t> clientInfoSet_t;
+    /* a sender thread and the read clients it serves */
+    typedef struct sender {
+      TCPComm *comm;
+      pthread_t thread;
+      bool running;
+      /* epoll over wakeFD and the clients the sender waits to write to */
+      int epollFD;
+      /* signaled when packets are published or answers queued */
+      int wakeFD;
+      /* held while the clients are served and to change them */
+      pthread_mutex_t lock;
+      std::vector<clientInfo_t *> clients;
+    } sender_t;
+
+    /* connected clients by fd, only touched by the event thread */
+    std::map<int, clientInfo_t *> clients;
 
-    typedef struct sharedClientInfo {
+    /* counters of the connected clients, read by other threads. A client
+     * in read and write mode counts against both limits, so there is a
+     * slot for every client that can be connected. */
+    clientMetrics_t *clientMetrics;
+    int clientMetricsCount;
 
-      /* mutex to proect client count and client set */
-      pthread_mutex_t sharedInfoLock;
-      /* mutex to protect read wakeup condition */
-      pthread_mutex_t readWakeupLock;
-      /* wakeup condition which is siganled when clients are connected for reading*/
-      pthread_cond_t readWakeup;
-       /* mutex to protect write wakeup condition */
-      pthread_mutex_t writeWakeupLock;
-      /* wakeup condition which is siganled when clients are connected for writing*/
-      pthread_cond_t writeWakeup;
-      /* connected clients count for reading */
-      int readClientCount;
-      /* connected clients count for writting */
-      int writeClientCount;
-      /* a set to store informsation of connected clients */
-      std::set<clientInfo_t> clients;
+    /* connected clients count for reading */
+    int readClientCount;
 
-    } sharedClientInfo_t;
+    /* signaled when a read client connects */
+    pthread_mutex_t readClientLock;
+    pthread_cond_t readClientCond;
 
-    /* shared client information */
-    sharedClientInfo_t sharedClientInfo;
+    /* connected clients count for writting */
+    int writeClientCount;
+
+    /* connected BLOCK clients whose queue is full */
+    int blockedClientCount;
+
+    /* readBuffer was left undrained because of a BLOCK client */
+    bool readBufferPending;
+
+    /* realtime minus monotonic clock, for CLIENT_STAMP_REALTIME */
+    int64_t realtimeOffset;
+
+    /* filters of the read clients */
+    Subscriptions subscriptions;
+
+    /* held for reading by the senders while they match packets, and for
+     * writing to change the subscriptions */
+    pthread_rwlock_t subscriptionLock;
+
+    /* sender threads, none sends everything from the event thread */
+    int senderCount;
+    sender_t *senders;
+
+    /* packets for the senders */
+    BroadcastRing *ring;
+
+    /* lowest cursor of the read clients when last looked at, the ring
+     * may be published to until it is a whole ring ahead */
+    uint64_t gateSeq;
+
+    /* signaled by a sender that failed to write to a client */
+    int senderFailFD;
+
+    /* clients the packet being sent goes to */
+    std::vector<int> receivers;
+
+    /* whether to write to clients through uring, set up on start() */
+    bool useIoUring;
+    IoUring uring;
+
+    /* a sendmsg() submitted to uring, the message has to stay put until
+     * it completes */
+    typedef struct uringSend {
+      clientInfo_t *clientInfo;
+      struct msghdr msg;
+      struct iovec iov[CLIENT_IOV_MAX];
+      size_t total;
+      int result;
+    } uringSend_t;
+
+    std::vector<uringSend_t> uringSends;
+
+    /* idle clients written to after a batch */
+    std::vector<clientInfo_t *> flushBatch;
 
     /* packet buffer to store packets read from clients. */
     PacketBuffer &readBuffer;
@@ -160,47 +493,144 @@ class TCPComm : public BaseComm
     /* port of the server */
     int serverPort;
 
+    /* file descriptor and path of the Unix socket server, if any */
+    int unixFD;
+    std::string unixPath;
+
+    /* ring every packet from readBuffer is also put into, if any */
+    ShmRing *shmRing;
+
+    /* sink group made the root of queries from clients, -1 for none */
+    int sinkGroup;
+
+    /* epoll instance of the event loop */
+    int epollFD;
+
+    /* signaled by readBuffer when packets are queued */
+    int readBufferFD;
+
     /* create a socket server on specified port */
     int createServer(int port);
 
+    /* create a Unix socket server at path */
+    int createUnixServer(const std::string &path);
+
     /* return the port of a socket address */
     static int getPort(struct sockaddr_storage *ss);
 
     /* return the ip address string of a socket address */
     static std::string getIpAddressString(struct sockaddr_storage *ss);
 
-    /* waiting to accept new clients */
-    void waitForClients();
+    static int setNonBlocking(int fd);
+
+    /* the event loop */
+    void runEventLoop();
 
-    int addClient(clientInfo_t &clientInfo);
+    int addClient(clientInfo_t *clientInfo);
 
-    int removeClient(clientInfo_t &clientInfo);
+    void removeClient(clientInfo_t *clientInfo);
 
-    /* accept a new client */
-    int acceptNewClient();
+    /* accept new clients of a server socket */
+    void acceptNewClients(int listenFD);
 
     /* handshae with the newly connected client. */
-    int handshakeClient(clientInfo_t &clientInfo);
+    int handshakeClient(clientInfo_t *clientInfo);
+
+    /* bytes of the handshake of a client, once the version is known */
+    static int handshakeLength(const clientInfo_t *clientInfo);
 
     /* send handshake error codes */
-    int sendHandshakeError(clientInfo_t &clientInfo, int errorCode);
+    void sendHandshakeError(clientInfo_t *clientInfo, int errorCode);
+
+    /* read from a client, at most CLIENT_READS_PER_EVENT times */
+    int readFromClient(clientInfo_t *clientInfo);
+
+    /* handle the complete packets in the input of a client */
+    int handleClientInput(clientInfo_t *clientInfo);
+
+    /* same for the frames of a version 2 client, returns the bytes used */
+    int handleClientFrames(clientInfo_t *clientInfo, int pos);
 
-    /* read from connected clients */
-    void readFromClients();
+    /* handle one packet from a client */
+    void handleClientPacket(clientInfo_t *clientInfo, int type, int source,
+                            const char *data, int len);
 
-    /* write to connected clients. */
+    /* send packets from readBuffer to connected clients. */
     void writeToClients();
 
-    /* write a packet to client */
-    int writePacket(const clientInfo_t &clientInfo, Packet &packet);
+    /* put packets from readBuffer into the ring and wake the senders */
+    void publishToRing();
+
+    void wakeSender(sender_t *sender);
+
+    /* lowest cursor of the read clients. Clients a whole ring behind are
+     * disconnected. */
+    uint64_t slowestCursor();
+
+    /* the loop of a sender thread */
+    void runSender(sender_t *sender);
 
-    /* read a packet from client */
-    int readPacket(const clientInfo_t &clientInfo, Packet &packet);
+    /* send what is pending and what is new in the ring to a client of a
+     * sender, false if the client has to be removed */
+    bool sendFromRing(clientInfo_t *clientInfo);
+
+    /* remove the clients the senders failed to write to */
+    void removeFailedClients();
+
+    /* write the head a client gets in front of packet, returns its
+     * length */
+    int buildHead(clientInfo_t *clientInfo, const Packet &packet, char *head);
+
+    /* queue a packet to a client applying its policy, false if the client
+     * has to be disconnected */
+    bool queueToClient(clientInfo_t *clientInfo, const Packet &packet);
+
+    /* queue a packet to a client regardless of the queue length, with the
+     * head the client's protocol and features call for */
+    void queueControl(clientInfo_t *clientInfo, const Packet &packet);
+
+    /* queue len bytes to be sent as they are */
+    void queueRaw(clientInfo_t *clientInfo, const char *data, int len);
+
+    /* put the records at the front of outQueue into a version 2 frame */
+    void sealFrame(clientInfo_t *clientInfo);
+
+    bool isQueueFull(const clientInfo_t *clientInfo) const;
+
+    /* answer a PKT_TYPE_STATS request */
+    void sendStats(clientInfo_t *clientInfo);
+
+    /* handle a PKT_TYPE_SUBSCRIBE request */
+    void subscribeClient(clientInfo_t *clientInfo, const char *data, int len);
+
+    /* send as much of the outbound buffer as the socket takes */
+    int flushClient(clientInfo_t *clientInfo);
+
+    /* flushClient() for many clients through uring, removing the ones
+     * that fail */
+    void flushClients(std::vector<clientInfo_t *> &batch);
+
+    /* put the frames of a client that go into one write into iov, returns
+     * the number of iovecs. total is set to their bytes and more to
+     * whether frames are left out. */
+    int gatherFrames(clientInfo_t *clientInfo, struct iovec *iov,
+                     size_t &total, bool &more);
+
+    /* drop the k bytes sent from the front of the queue of a client */
+    void dropSent(clientInfo_t *clientInfo, size_t k);
+
+    /* after a client was written to, update its counters and BLOCK state
+     * and wait for write readiness if anything is left. -1 if the client
+     * has to be removed. */
+    int finishFlush(clientInfo_t *clientInfo);
+
+    /* publish the queue length and lag of a client */
+    void updateClientMetrics(clientInfo_t *clientInfo);
 
     /* friend functions to operate threads  */
-    friend void * serverThreadFunc(void* ob);
-    friend void * readFromClientsThreadFunc(void* ob);
-    friend void * writeToClientsThreadFunc(void* ob);
+    friend void * eventLoopThreadFunc(void* ob);
+
+    friend void * senderThreadFunc(void* ob);
 
   private:
     /* disable standard constructor */
@@ -210,11 +640,51 @@ class TCPComm : public BaseComm
     /* constructor */
     TCPComm(int port, PacketBuffer &readBuffer, PacketBuffer &writeBuffer);
 
+    ~TCPComm();
+
+    /* serve read clients from the broadcast ring with this many sender
+     * threads, 0 for none. Takes effect on start(). */
+    void setSenders(int senders);
+
+    /* also listen on a Unix socket at path. Takes effect on start(). */
+    void setUnixPath(const std::string &path);
+
+    /* put every packet taken from readBuffer into ring, which has to be
+     * open. Takes effect on start(). */
+    void setShmRing(ShmRing *ring);
+
+    /* make the sink group group the root of every query clients send, so
+     * that results go to the nearest sink of the group. -1, the default,
+     * leaves the root the sink put in. */
+    void setSinkGroup(int group);
+
+    /* write to clients through io_uring if the kernel has it, without
+     * sender threads only. Takes effect on start(). */
+    void setIoUring(bool enable);
+
+    /* Limits of clients, the length of their queues and of the backlog of
+     * the server sockets, and the packets the sender ring holds, rounded
+     * up to a power of two. Take effect on start(). */
+    void setClientLimits(int maxReadClients, int maxWriteClients);
+
+    void setClientQueueLength(int length);
+
+    void setListenBacklog(int backlog);
+
+    void setSenderRingSize(int size);
+
     /* start TCP Communication server */
     int start();
 
     void cancel();
 
+    /* waits up to mSecs for a read client, true if there is one */
+    bool waitForReadClient(unsigned int mSecs);
+
+    /* copies the counters of the connected clients, without stopping the
+     * event thread */
+    void getClientMetrics(std::vector<clientMetrics_t> &metrics) const;
+
 };
 
 #endif /* TCPCOMM_H */
@@ -36,7 +36,7 @@
 #ifndef VERSION_H
 #define VERSION_H
 
-#define VERSION_MAJOR 1
+#define VERSION_MAJOR 2
 
 #define VERSION_MINOR 0
 
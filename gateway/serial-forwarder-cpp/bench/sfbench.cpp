@@ -0,0 +1,1046 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Benchmark of the forwarder.
+ *      Starts sf for each scenario, feeds it frames through a pseudo-terminal
+ *      standing in for the sink mote, or a capture log it replays, and
+ *      connects read clients, slow read clients and write clients to it.
+ *      Every frame carries the time it was written, so the clients and the
+ *      mote side measure latency end to end. Replayed frames are timed from
+ *      the stamp sf gives them instead.
+ *      For each scenario it reports the packets a second that reached the
+ *      read clients, p50, p99 and p999 of the latency, the CPU time sf took
+ *      for each packet and the drop counters of sf, as JSON.
+ *
+ *      usage: sfbench [-s sf] [-o output] [-d seconds] [-p port] [-v]
+ *                     [scenario ...]
+ */
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../CaptureLog.h"
+#include "../Packet.h"
+#include "../SlipCodec.h"
+#include "../TCPComm.h"
+
+/* bytes of every payload, the query reply header and the bench fields */
+#define BENCH_PAYLOAD_LEN 32
+/* offset of seq (4) and the time the frame was written (8) in a payload */
+#define BENCH_FIELDS QREPLY_HEADER_LEN
+
+/* read clients whose latencies are kept, and how many at most */
+#define SAMPLED_CLIENTS 16
+#define MAX_SAMPLES 4000000
+
+/* a slow client reads this many bytes every SLOW_CLIENT_PERIOD ms */
+#define SLOW_CLIENT_READ 512
+#define SLOW_CLIENT_PERIOD 100
+
+/* frames a write client has in flight */
+#define WRITE_BATCH 32
+
+/* frames fed at once when feeding as fast as the terminal takes them */
+#define FEED_BATCH 64
+
+#define REPLAY_RECORDS 200000
+/* seconds a replay may take at most */
+#define REPLAY_MAX 60
+
+/* once feeding stops, the scenario ends after the clients were quiet this
+ * long or after DRAIN_MAX ms */
+#define DRAIN_QUIET 300
+#define DRAIN_MAX 3000
+
+#define CLIENT_BUFFER 65536
+
+typedef struct scenario {
+  const char *name;
+  bool replay;
+  int readClients;
+  int slowClients;
+  int writeClients;
+  /* percent of the frames that are debug output */
+  int debugPercent;
+  /* frames a second fed to sf, 0 feeds as fast as sf takes them */
+  int rate;
+  /* more arguments for sf */
+  const char *options;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+  {"clients_1",     false,   1,  0, 0,  0, 5000, ""},
+  {"clients_10",    false,  10,  0, 0,  0, 5000, ""},
+  {"clients_100",   false, 100,  0, 0,  0, 5000, ""},
+  {"clients_500",   false, 500,  0, 0,  0, 2000, "-o max_read_clients=500"},
+  {"saturate",      false,   1,  0, 0,  0,    0, ""},
+  {"mixed_debug",   false,  10,  0, 0, 30, 5000, ""},
+  {"slow_clients",  false,  10, 10, 0,  0, 5000, ""},
+  {"write_flood",   false,  10,  0, 4,  0, 1000, "-o max_write_clients=4"},
+  {"replay_fanout", true,   10,  0, 0,  0,    0, ""}
+};
+
+enum {
+  CLIENT_FAST,
+  CLIENT_SLOW,
+  CLIENT_WRITER
+};
+
+typedef struct benchClient {
+  int fd;
+  int kind;
+  /* bytes of frames not complete yet, or of frames not sent yet */
+  char buffer[CLIENT_BUFFER];
+  int length;
+  int offset;
+  uint64_t packets;
+  uint64_t lastPacket;
+  bool sampled;
+} benchClient_t;
+
+/* what the threads feeding and reading the terminal share with main */
+typedef struct terminal {
+  int master;
+  const scenario_t *scenario;
+  volatile bool stop;
+  uint64_t start;
+  uint64_t fed;
+  uint32_t writeSeq;
+  uint64_t written;
+  std::vector<uint64_t> writeLatencies;
+} terminal_t;
+
+static const char *sfPath = "./sf";
+static std::string workDir;
+static int basePort = 29000;
+static double duration = 3;
+static bool verbose = false;
+
+/*----------------------------------------------------------------------------*/
+static uint64_t
+now()
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*----------------------------------------------------------------------------*/
+static void
+put32(char *p, uint32_t value)
+{
+  memcpy(p, &value, sizeof(value));
+}
+/*----------------------------------------------------------------------------*/
+static void
+put64(char *p, uint64_t value)
+{
+  memcpy(p, &value, sizeof(value));
+}
+/*----------------------------------------------------------------------------*/
+static uint64_t
+get64(const char *p)
+{
+  uint64_t value;
+
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+/*----------------------------------------------------------------------------*/
+/* a payload of the kind the motes send, or a query request for the motes */
+static void
+makePayload(char *payload, int first, uint32_t seq, uint64_t stamp)
+{
+  memset(payload, 0, BENCH_PAYLOAD_LEN);
+  payload[0] = first;
+  payload[QREPLY_QID] = seq & 0xFF;
+  put32(payload + BENCH_FIELDS, seq);
+  put64(payload + BENCH_FIELDS + 4, stamp);
+}
+/*----------------------------------------------------------------------------*/
+static bool
+isDebug(const scenario_t *scenario, uint32_t seq)
+{
+  // 37 walks every residue mod 100, spreading debug frames evenly
+  return (seq * 37) % 100 < (uint32_t)scenario->debugPercent;
+}
+/*----------------------------------------------------------------------------*/
+/* the sink mote, writing frames to sf */
+static void *
+feedThreadFunc(void *ob)
+{
+  terminal_t *term = (terminal_t *)ob;
+  const scenario_t *scenario = term->scenario;
+  static char stream[FEED_BATCH * SLIP_ENCODED_SIZE(BENCH_PAYLOAD_LEN)];
+  char payload[BENCH_PAYLOAD_LEN];
+  struct pollfd pfd;
+  struct timespec pause = {0, 100000};
+  uint64_t due, stamp;
+  uint32_t seq = 0;
+  int i, n, len, pos, k;
+
+  pfd.fd = term->master;
+  pfd.events = POLLOUT;
+  while(!__atomic_load_n(&term->stop, __ATOMIC_RELAXED)) {
+    n = FEED_BATCH;
+    if(scenario->rate > 0) {
+      due = (now() - term->start) * scenario->rate / 1000000000ULL;
+      n = std::min((uint64_t)FEED_BATCH, due - seq);
+      if(n == 0) {
+        nanosleep(&pause, NULL);
+        continue;
+      }
+    }
+
+    len = 0;
+    for(i = 0; i < n; i++, seq++) {
+      stamp = now();
+      makePayload(payload, isDebug(scenario, seq) ? DEBUG_MAKER : MSG_QREPLY,
+                  seq, stamp);
+      len += SlipCodec::encode(payload, BENCH_PAYLOAD_LEN, stream + len);
+    }
+    for(pos = 0; pos < len && !term->stop; pos += k) {
+      k = write(term->master, stream + pos, len - pos);
+      if(k < 0) {
+        k = 0;
+        poll(&pfd, 1, 100);
+      }
+    }
+    __atomic_store_n(&term->fed, seq, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+/* the sink mote, reading what write clients sent through sf */
+static void *
+moteThreadFunc(void *ob)
+{
+  terminal_t *term = (terminal_t *)ob;
+  SlipCodec codec;
+  char in[4096];
+  char frame[MAX_PKT_SIZE];
+  struct pollfd pfd;
+  int k, pos, frameLen;
+
+  pfd.fd = term->master;
+  pfd.events = POLLIN;
+  while(!__atomic_load_n(&term->stop, __ATOMIC_RELAXED)) {
+    if(poll(&pfd, 1, 100) <= 0) {
+      continue;
+    }
+    k = read(term->master, in, sizeof(in));
+    for(pos = 0; pos < k; ) {
+      pos += codec.decode(in + pos, k - pos, frame, sizeof(frame), frameLen);
+      if(frameLen >= BENCH_PAYLOAD_LEN && frame[0] == MSG_QREQUEST) {
+        term->written++;
+        if(term->writeLatencies.size() < MAX_SAMPLES) {
+          term->writeLatencies.push_back(now() -
+                                         get64(frame + BENCH_FIELDS + 4));
+        }
+      }
+    }
+  }
+  return NULL;
+}
+/*----------------------------------------------------------------------------*/
+static int
+openTerminal(std::string &name)
+{
+  int master, slave;
+  char *path;
+  struct termios tios;
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if(master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+     (path = ptsname(master)) == NULL) {
+    perror("Can not create a pseudo-terminal");
+    return -1;
+  }
+  name = path;
+
+  // the slave side stays open, so that the terminal does not hang up
+  // while sf opens and sets it up
+  slave = open(path, O_RDWR | O_NOCTTY);
+  if(slave < 0) {
+    perror("Can not open the pseudo-terminal");
+    close(master);
+    return -1;
+  }
+  tcgetattr(slave, &tios);
+  cfmakeraw(&tios);
+  tcsetattr(slave, TCSANOW, &tios);
+
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+  return master;
+}
+/*----------------------------------------------------------------------------*/
+/* writes the capture log sf replays, the frames the mote would have sent */
+static int
+writeReplayLog(const std::string &path)
+{
+  captureHeader_t header;
+  char record[CAPTURE_RECORD_SIZE(BENCH_PAYLOAD_LEN)];
+  captureRecord_t *rec = (captureRecord_t *)record;
+  FILE *file;
+  uint32_t seq;
+
+  file = fopen(path.c_str(), "w");
+  if(file == NULL) {
+    perror("Can not write the replay log");
+    return -1;
+  }
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+  header.version = CAPTURE_VERSION;
+  header.headerLen = sizeof(header);
+  fwrite(&header, sizeof(header), 1, file);
+
+  memset(record, 0, sizeof(record));
+  for(seq = 0; seq < REPLAY_RECORDS; seq++) {
+    rec->timestamp = (uint64_t)seq * 1000;
+    rec->length = BENCH_PAYLOAD_LEN;
+    rec->type = PKT_TYPE_DATA;
+    rec->source = 1;
+    makePayload(record + sizeof(captureRecord_t), MSG_QREPLY, seq, 0);
+    fwrite(record, sizeof(record), 1, file);
+  }
+  if(fclose(file) != 0) {
+    perror("Can not write the replay log");
+    return -1;
+  }
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
+static pid_t
+startForwarder(const std::vector<std::string> &args)
+{
+  std::vector<char *> argv;
+  unsigned int i;
+  int null;
+  pid_t pid;
+
+  argv.push_back((char *)sfPath);
+  for(i = 0; i < args.size(); i++) {
+    argv.push_back((char *)args[i].c_str());
+  }
+  argv.push_back(NULL);
+
+  pid = fork();
+  if(pid == 0) {
+    if(!verbose) {
+      null = open("/dev/null", O_WRONLY);
+      dup2(null, STDOUT_FILENO);
+      dup2(null, STDERR_FILENO);
+    }
+    execv(sfPath, &argv[0]);
+    perror("Can not run sf");
+    _exit(127);
+  }
+  return pid;
+}
+/*----------------------------------------------------------------------------*/
+static void
+stopForwarder(pid_t pid)
+{
+  int status;
+  int i;
+
+  kill(pid, SIGTERM);
+  for(i = 0; i < 50; i++) {
+    if(waitpid(pid, &status, WNOHANG) == pid) {
+      return;
+    }
+    usleep(100000);
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+}
+/*----------------------------------------------------------------------------*/
+/* CPU time of every thread of the process in nanoseconds */
+static uint64_t
+cpuTime(pid_t pid)
+{
+  char path[PATH_MAX];
+  unsigned long long ns;
+  uint64_t total = 0;
+  struct dirent *entry;
+  FILE *file;
+  DIR *dir;
+
+  snprintf(path, sizeof(path), "/proc/%d/task", pid);
+  dir = opendir(path);
+  if(dir == NULL) {
+    return 0;
+  }
+  while((entry = readdir(dir)) != NULL) {
+    if(entry->d_name[0] == '.') {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/task/%s/schedstat", pid,
+             entry->d_name);
+    file = fopen(path, "r");
+    if(file != NULL) {
+      if(fscanf(file, "%llu", &ns) == 1) {
+        total += ns;
+      }
+      fclose(file);
+    }
+  }
+  closedir(dir);
+  return total;
+}
+/*----------------------------------------------------------------------------*/
+/* the counters of the text report of the stats server */
+static std::map<std::string, uint64_t>
+readCounters(const std::string &path)
+{
+  std::map<std::string, uint64_t> counters;
+  struct sockaddr_un addr;
+  std::string text, line;
+  char buf[4096], name[128];
+  unsigned long long value;
+  size_t pos, end;
+  int fd, k;
+
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    if(fd >= 0) {
+      close(fd);
+    }
+    return counters;
+  }
+  k = write(fd, "\n", 1);
+  while((k = read(fd, buf, sizeof(buf))) > 0) {
+    text.append(buf, k);
+  }
+  close(fd);
+
+  for(pos = 0; pos < text.size(); pos = end + 1) {
+    end = text.find('\n', pos);
+    if(end == std::string::npos) {
+      end = text.size();
+    }
+    line = text.substr(pos, end - pos);
+    if(sscanf(line.c_str(), "%127s %llu", name, &value) == 2 &&
+       line.find(' ', strlen(name) + 1) == std::string::npos) {
+      counters[name] = value;
+    }
+  }
+  return counters;
+}
+/*----------------------------------------------------------------------------*/
+static int
+connectClient(int port)
+{
+  struct sockaddr_in addr;
+  int fd, yes = 1;
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if(fd < 0) {
+    return -1;
+  }
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+  return fd;
+}
+/*----------------------------------------------------------------------------*/
+/* waits up to 3 s for sf to take connections */
+static bool
+waitForForwarder(int port, pid_t pid)
+{
+  int i, fd, status;
+
+  for(i = 0; i < 60; i++) {
+    if(waitpid(pid, &status, WNOHANG) == pid) {
+      return false;
+    }
+    fd = connectClient(port);
+    if(fd >= 0) {
+      // a connection that never handshakes is closed by sf
+      close(fd);
+      return true;
+    }
+    usleep(50000);
+  }
+  return false;
+}
+/*----------------------------------------------------------------------------*/
+/*
+ * Connects every client and then handshakes all of them, so that they are
+ * all there by the time the first one is, which starts a replay.
+ */
+static bool
+connectClients(const scenario_t *scenario, int port,
+               std::vector<benchClient_t *> &clients)
+{
+  char handshake[HANDSHAKE_LEN];
+  benchClient_t *client;
+  struct timeval tv = {3, 0};
+  int total = scenario->readClients + scenario->slowClients +
+              scenario->writeClients;
+  int i, k;
+
+  for(i = 0; i < total; i++) {
+    client = new benchClient_t;
+    client->fd = connectClient(port);
+    client->kind = (i < scenario->readClients) ? CLIENT_FAST :
+                   (i < scenario->readClients + scenario->slowClients) ?
+                   CLIENT_SLOW : CLIENT_WRITER;
+    client->length = 0;
+    client->offset = 0;
+    client->packets = 0;
+    client->lastPacket = 0;
+    client->sampled = client->kind == CLIENT_FAST && i < SAMPLED_CLIENTS;
+    clients.push_back(client);
+    if(client->fd < 0) {
+      fprintf(stderr, "sfbench : can not connect client %d : %s\n", i,
+              strerror(errno));
+      return false;
+    }
+    setsockopt(client->fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  }
+
+  for(i = 0; i < total; i++) {
+    handshake[0] = PROTOCOL_V1;
+    handshake[1] = 0;
+    handshake[2] = (clients[i]->kind == CLIENT_WRITER) ? CLIENT_MODE_W :
+                                                         CLIENT_MODE_R;
+    handshake[3] = (clients[i]->kind == CLIENT_WRITER) ? 0 :
+                                                         CLIENT_STAMP_MONOTONIC;
+    k = write(clients[i]->fd, handshake, HANDSHAKE_LEN);
+  }
+
+  for(i = 0; i < total; i++) {
+    k = recv(clients[i]->fd, handshake, HANDSHAKE_LEN, MSG_WAITALL);
+    if(k != HANDSHAKE_LEN || handshake[2] != ERR_OK) {
+      fprintf(stderr, "sfbench : client %d was refused (%d)\n", i,
+              (k == HANDSHAKE_LEN) ? handshake[2] : -1);
+      return false;
+    }
+    fcntl(clients[i]->fd, F_SETFL, fcntl(clients[i]->fd, F_GETFL) |
+                                   O_NONBLOCK);
+  }
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+/* takes the complete frames out of the buffer of a read client */
+static void
+parseFrames(benchClient_t *client, bool replay,
+            std::vector<uint64_t> &latencies)
+{
+  const char *frame;
+  uint64_t t = now();
+  uint64_t sent;
+  int pos = 0;
+  int len;
+
+  while(client->length - pos >= PKT_META_LEN + PKT_STAMP_LEN) {
+    frame = client->buffer + pos;
+    len = (unsigned char)frame[0] | ((unsigned char)frame[1] << 8);
+    if(client->length - pos < PKT_META_LEN + PKT_STAMP_LEN + len) {
+      break;
+    }
+    pos += PKT_META_LEN + PKT_STAMP_LEN + len;
+    // only what the mote sent, not what the write clients did
+    if(len < BENCH_PAYLOAD_LEN ||
+       (frame[PKT_META_LEN + PKT_STAMP_LEN] != MSG_QREPLY &&
+        frame[PKT_META_LEN + PKT_STAMP_LEN] != DEBUG_MAKER)) {
+      continue;
+    }
+    client->packets++;
+    client->lastPacket = t;
+    if(client->sampled && latencies.size() < MAX_SAMPLES) {
+      // a replayed frame was written long ago, it is timed from when sf
+      // read it from the log
+      sent = replay ? get64(frame + PKT_META_LEN) :
+                      get64(frame + PKT_META_LEN + PKT_STAMP_LEN +
+                            BENCH_FIELDS + 4);
+      latencies.push_back(t - sent);
+    }
+  }
+  memmove(client->buffer, client->buffer + pos, client->length - pos);
+  client->length -= pos;
+}
+/*----------------------------------------------------------------------------*/
+static void
+readClient(benchClient_t *client, int limit, bool replay,
+           std::vector<uint64_t> &latencies)
+{
+  int k;
+
+  do {
+    k = recv(client->fd, client->buffer + client->length,
+             std::min(limit, CLIENT_BUFFER - client->length), 0);
+    if(k > 0) {
+      client->length += k;
+      parseFrames(client, replay, latencies);
+      limit -= k;
+    }
+  } while(k > 0 && limit > 0);
+}
+/*----------------------------------------------------------------------------*/
+/* sends the frames of a write client until the socket is full */
+static void
+writeClient(benchClient_t *client, uint32_t &seq)
+{
+  char payload[BENCH_PAYLOAD_LEN];
+  char *frame;
+  int i, k;
+
+  while(true) {
+    if(client->offset == client->length) {
+      client->offset = 0;
+      client->length = 0;
+      for(i = 0; i < WRITE_BATCH; i++) {
+        frame = client->buffer + client->length;
+        frame[0] = BENCH_PAYLOAD_LEN;
+        frame[1] = 0;
+        frame[2] = PKT_TYPE_DATA;
+        frame[3] = PKT_SOURCE_ANY;
+        makePayload(payload, MSG_QREQUEST, seq++, now());
+        memcpy(frame + PKT_META_LEN, payload, BENCH_PAYLOAD_LEN);
+        client->length += PKT_META_LEN + BENCH_PAYLOAD_LEN;
+      }
+    }
+    k = send(client->fd, client->buffer + client->offset,
+             client->length - client->offset, MSG_NOSIGNAL);
+    if(k <= 0) {
+      return;
+    }
+    client->offset += k;
+  }
+}
+/*----------------------------------------------------------------------------*/
+static void
+printLatency(FILE *out, const char *name, std::vector<uint64_t> &samples)
+{
+  size_t n = samples.size();
+
+  if(n == 0) {
+    fprintf(out, "      \"%s\": null,\n", name);
+    return;
+  }
+  std::sort(samples.begin(), samples.end());
+  fprintf(out, "      \"%s\": {\"samples\": %lu, \"p50\": %.1f, "
+          "\"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f},\n", name,
+          (unsigned long)n, samples[n / 2] / 1e3, samples[n * 99 / 100] / 1e3,
+          samples[n * 999 / 1000] / 1e3, samples[n - 1] / 1e3);
+}
+/*----------------------------------------------------------------------------*/
+static uint64_t
+counter(std::map<std::string, uint64_t> &counters, const char *name)
+{
+  std::map<std::string, uint64_t>::iterator it = counters.find(name);
+
+  return (it == counters.end()) ? 0 : it->second;
+}
+/*----------------------------------------------------------------------------*/
+static bool
+runScenario(const scenario_t *scenario, int port, FILE *out, bool first)
+{
+  std::string statsPath = workDir + "/stats.sock";
+  std::string logPath = workDir + "/replay.log";
+  std::vector<std::string> args;
+  std::vector<benchClient_t *> clients;
+  std::vector<uint64_t> latencies;
+  std::map<std::string, uint64_t> counters;
+  std::string terminalName, error;
+  struct epoll_event ev, events[64];
+  terminal_t term;
+  pthread_t feedThread, moteThread;
+  bool threads = false;
+  uint64_t start = 0, end, deadline, last = 0, lastSlow;
+  uint64_t cpuStart = 0, cpuEnd = 0;
+  uint64_t quietSince;
+  uint64_t delivered = 0, slowDelivered = 0, fed, handled;
+  uint32_t writeSeq = 0;
+  double elapsed;
+  char *options, *arg;
+  char portStr[16];
+  unsigned int i;
+  int n, e, fast = 0, slow = 0, epfd = -1;
+  pid_t pid;
+
+  fprintf(stderr, "sfbench : %s\n", scenario->name);
+  term.master = -1;
+  term.scenario = scenario;
+  term.stop = false;
+  term.fed = 0;
+  term.written = 0;
+
+  if(scenario->replay) {
+    if(writeReplayLog(logPath) < 0) {
+      return false;
+    }
+    args.push_back("-r");
+    args.push_back(logPath);
+    args.push_back("-x");
+    args.push_back("0");
+  } else {
+    term.master = openTerminal(terminalName);
+    if(term.master < 0) {
+      return false;
+    }
+    args.push_back("-s");
+    args.push_back(terminalName);
+    args.push_back("-b");
+    args.push_back("115200");
+  }
+  args.push_back("-p");
+  snprintf(portStr, sizeof(portStr), "%d", port);
+  args.push_back(portStr);
+  args.push_back("-m");
+  args.push_back(statsPath);
+  options = strdup(scenario->options);
+  for(arg = strtok(options, " "); arg != NULL; arg = strtok(NULL, " ")) {
+    args.push_back(arg);
+  }
+  free(options);
+
+  unlink(statsPath.c_str());
+  pid = startForwarder(args);
+  if(pid < 0 || !waitForForwarder(port, pid)) {
+    error = "sf did not start";
+  } else if(!connectClients(scenario, port, clients)) {
+    error = "clients could not connect";
+  }
+
+  if(error.empty()) {
+    epfd = epoll_create1(0);
+    for(i = 0; i < clients.size(); i++) {
+      if(clients[i]->kind == CLIENT_SLOW) {
+        slow++;
+        continue;
+      }
+      fast += clients[i]->kind == CLIENT_FAST;
+      ev.events = (clients[i]->kind == CLIENT_WRITER) ? EPOLLOUT : EPOLLIN;
+      ev.data.ptr = clients[i];
+      epoll_ctl(epfd, EPOLL_CTL_ADD, clients[i]->fd, &ev);
+    }
+
+    cpuStart = cpuTime(pid);
+    start = now();
+    term.start = start;
+    if(!scenario->replay) {
+      pthread_create(&feedThread, NULL, feedThreadFunc, &term);
+      pthread_create(&moteThread, NULL, moteThreadFunc, &term);
+      threads = true;
+    }
+
+    end = start + (uint64_t)(duration * 1e9);
+    deadline = scenario->replay ? start + REPLAY_MAX * 1000000000ULL :
+                                  end + DRAIN_MAX * 1000000ULL;
+    last = lastSlow = quietSince = start;
+    while(true) {
+      n = epoll_wait(epfd, events, 64, 10);
+      for(e = 0; e < n; e++) {
+        benchClient_t *client = (benchClient_t *)events[e].data.ptr;
+        if(client->kind == CLIENT_WRITER) {
+          if(now() < end) {
+            writeClient(client, writeSeq);
+          }
+        } else {
+          readClient(client, CLIENT_BUFFER, scenario->replay, latencies);
+        }
+      }
+      if(n > 0) {
+        quietSince = now();
+      }
+      if(now() - lastSlow >= SLOW_CLIENT_PERIOD * 1000000ULL) {
+        lastSlow = now();
+        for(i = 0; i < clients.size(); i++) {
+          if(clients[i]->kind == CLIENT_SLOW) {
+            readClient(clients[i], SLOW_CLIENT_READ, scenario->replay,
+                       latencies);
+          }
+        }
+      }
+      if(now() >= end && !term.stop) {
+        __atomic_store_n(&term.stop, true, __ATOMIC_RELAXED);
+        for(i = 0; i < clients.size(); i++) {
+          if(clients[i]->kind == CLIENT_WRITER) {
+            epoll_ctl(epfd, EPOLL_CTL_DEL, clients[i]->fd, NULL);
+          }
+        }
+      }
+      // a replay ends when the log is through, the others some time after
+      // the feed stopped
+      if((scenario->replay || term.stop) &&
+         now() - quietSince >= DRAIN_QUIET * 1000000ULL) {
+        break;
+      }
+      if(now() >= deadline) {
+        break;
+      }
+    }
+    cpuEnd = cpuTime(pid);
+    counters = readCounters(statsPath);
+    __atomic_store_n(&term.stop, true, __ATOMIC_RELAXED);
+    if(threads) {
+      pthread_join(feedThread, NULL);
+      pthread_join(moteThread, NULL);
+    }
+
+    for(i = 0; i < clients.size(); i++) {
+      if(clients[i]->kind == CLIENT_FAST) {
+        delivered += clients[i]->packets;
+        if(clients[i]->lastPacket > last) {
+          last = clients[i]->lastPacket;
+        }
+      } else if(clients[i]->kind == CLIENT_SLOW) {
+        slowDelivered += clients[i]->packets;
+      }
+    }
+  }
+
+  for(i = 0; i < clients.size(); i++) {
+    if(clients[i]->fd >= 0) {
+      close(clients[i]->fd);
+    }
+    delete clients[i];
+  }
+  if(epfd >= 0) {
+    close(epfd);
+  }
+  if(pid > 0) {
+    stopForwarder(pid);
+  }
+  if(term.master >= 0) {
+    close(term.master);
+  }
+  unlink(logPath.c_str());
+
+  fprintf(out, "%s    {\n", first ? "" : ",\n");
+  fprintf(out, "      \"name\": \"%s\",\n", scenario->name);
+  fprintf(out, "      \"input\": \"%s\",\n", scenario->replay ? "replay" : "pty");
+  fprintf(out, "      \"read_clients\": %d,\n", scenario->readClients);
+  fprintf(out, "      \"slow_clients\": %d,\n", scenario->slowClients);
+  fprintf(out, "      \"write_clients\": %d,\n", scenario->writeClients);
+  fprintf(out, "      \"debug_percent\": %d,\n", scenario->debugPercent);
+  fprintf(out, "      \"offered_pps\": %d,\n", scenario->rate);
+  fprintf(out, "      \"sf_options\": \"%s\",\n", scenario->options);
+  if(!error.empty()) {
+    fprintf(out, "      \"error\": \"%s\"\n    }", error.c_str());
+    return false;
+  }
+
+  fed = scenario->replay ? REPLAY_RECORDS : term.fed;
+  handled = counter(counters, "serial_frames_in") +
+            counter(counters, "serial_frames_out");
+  if(scenario->replay) {
+    handled += fed;
+  }
+  elapsed = (last - start) / 1e9;
+  fprintf(out, "      \"seconds\": %.3f,\n", elapsed);
+  fprintf(out, "      \"packets_in\": %lu,\n", (unsigned long)fed);
+  fprintf(out, "      \"delivered_pps\": %.1f,\n",
+          (fast > 0 && elapsed > 0) ? delivered / (double)fast / elapsed : 0);
+  fprintf(out, "      \"delivery_ratio\": %.4f,\n",
+          (fast > 0 && fed > 0) ? delivered / (double)fast / fed : 0);
+  fprintf(out, "      \"slow_delivery_ratio\": ");
+  if(slow > 0 && fed > 0) {
+    fprintf(out, "%.4f,\n", slowDelivered / (double)slow / fed);
+  } else {
+    fprintf(out, "null,\n");
+  }
+  printLatency(out, "latency_us", latencies);
+  if(scenario->writeClients > 0) {
+    fprintf(out, "      \"write_pps\": %.1f,\n",
+            term.written / (duration > 0 ? duration : 1));
+    printLatency(out, "write_latency_us", term.writeLatencies);
+  }
+  fprintf(out, "      \"cpu_ns_per_packet\": %.0f,\n",
+          handled > 0 ? (cpuEnd - cpuStart) / (double)handled : 0);
+  fprintf(out, "      \"drops\": {\"read_buffer\": %lu, \"debug\": %lu, "
+          "\"write_buffer\": %lu, \"client\": %lu, \"disconnects\": %lu}\n",
+          (unsigned long)counter(counters, "read_buffer_drops"),
+          (unsigned long)counter(counters, "debug_drops"),
+          (unsigned long)counter(counters, "write_buffer_drops"),
+          (unsigned long)counter(counters, "client_drops"),
+          (unsigned long)counter(counters, "client_disconnects"));
+  fprintf(out, "    }");
+  return true;
+}
+/*----------------------------------------------------------------------------*/
+static void
+usage(const char *name)
+{
+  unsigned int i;
+
+  fprintf(stderr, "Usage: %s [-s <sf>] [-o <output>] [-d <seconds>] "
+          "[-p <port>] [-v] [scenario ...]\n", name);
+  fprintf(stderr, "  -s <sf>       : forwarder to run (default ./sf).\n");
+  fprintf(stderr, "  -o <output>   : file for the JSON results (default"
+          " stdout).\n");
+  fprintf(stderr, "  -d <seconds>  : time each scenario feeds the terminal"
+          " (default 3), a replay\n"
+          "                  runs through its %d frames.\n", REPLAY_RECORDS);
+  fprintf(stderr, "  -p <port>     : port sf listens on (default 29000).\n");
+  fprintf(stderr, "  -v            : show the output of sf.\n");
+  fprintf(stderr, "Scenarios:");
+  for(i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    fprintf(stderr, " %s", scenarios[i].name);
+  }
+  fprintf(stderr, "\n");
+}
+/*----------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  const char *outPath = NULL;
+  char dirTemplate[] = "/tmp/sfbench.XXXXXX";
+  bool ok = true, first = true, wanted;
+  unsigned int i;
+  int c, j, run = 0;
+  FILE *out = stdout;
+
+  while((c = getopt(argc, argv, "s:o:d:p:v")) != -1) {
+    switch(c) {
+      case 's':
+        sfPath = optarg;
+        break;
+      case 'o':
+        outPath = optarg;
+        break;
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 'p':
+        basePort = atoi(optarg);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if(duration <= 0 || basePort <= 0 || access(sfPath, X_OK) < 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  for(j = optind; j < argc; j++) {
+    for(i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+      if(strcmp(argv[j], scenarios[i].name) == 0) {
+        break;
+      }
+    }
+    if(i == sizeof(scenarios) / sizeof(scenarios[0])) {
+      fprintf(stderr, "sfbench : no scenario %s\n", argv[j]);
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(mkdtemp(dirTemplate) == NULL) {
+    perror("Can not create a working directory");
+    return 1;
+  }
+  workDir = dirTemplate;
+  if(outPath != NULL) {
+    out = fopen(outPath, "w");
+    if(out == NULL) {
+      perror("Can not open the output");
+      rmdir(workDir.c_str());
+      return 1;
+    }
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  fprintf(out, "{\n  \"forwarder\": \"%s\",\n", sfPath);
+  fprintf(out, "  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+  fprintf(out, "  \"feed_seconds\": %.1f,\n", duration);
+  fprintf(out, "  \"scenarios\": [\n");
+  for(i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    wanted = optind == argc;
+    for(j = optind; j < argc; j++) {
+      wanted = wanted || strcmp(argv[j], scenarios[i].name) == 0;
+    }
+    if(!wanted) {
+      continue;
+    }
+    // a port of its own for each run, the last one may be in TIME_WAIT
+    ok = runScenario(&scenarios[i], basePort + run++, out, first) && ok;
+    first = false;
+    fflush(out);
+  }
+  fprintf(out, "\n  ]\n}\n");
+  if(out != stdout) {
+    fclose(out);
+  }
+
+  unlink((workDir + "/stats.sock").c_str());
+  rmdir(workDir.c_str());
+  return ok ? 0 : 1;
+}
+/*----------------------------------------------------------------------------*/
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Reference reader of the shared memory ring of sf -z.
+ *      Follows the ring the way ShmRing.h describes, from the record
+ *      published last when it starts on, and checks every record it copies:
+ *      the sequence has to be the one it asked for, the length has to fit
+ *      the slot and the stamp may not lie ahead of the clock it was taken
+ *      from. Records overwritten before it got to them are counted as
+ *      lost. Once a second, and when it ends, it prints the records read,
+ *      the records lost, the bad records and the time from the stamp sf
+ *      gave a record to its copy.
+ *      It exits with 1 if it saw a bad record.
+ *
+ *      usage: shmtail [-d seconds] [-v] <shm name>
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "../ShmRing.h"
+
+/* longest a reader sleeps on the wake word before it looks again */
+#define WAIT_MS 100
+/* time the ring may take to show up after sf starts */
+#define OPEN_TRIES 50
+
+static volatile sig_atomic_t stop = 0;
+
+typedef struct tailStats {
+  uint64_t records;
+  uint64_t lost;
+  uint64_t bad;
+  uint64_t latencySum;
+  uint64_t latencyMax;
+} tailStats_t;
+
+/*----------------------------------------------------------------------------*/
+static uint64_t
+now()
+{
+  struct timespec ts;
+
+  // the clock of Metrics::now, which stamps the packets
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+/*----------------------------------------------------------------------------*/
+static void
+onSignal(int sig)
+{
+  stop = 1;
+}
+/*----------------------------------------------------------------------------*/
+/* maps the ring read only, or returns NULL */
+static shmRingHeader_t *
+openRing(const std::string &name, size_t *length)
+{
+  shmRingHeader_t first;
+  struct stat st;
+  void *map;
+  int fd, i;
+
+  for(i = 0; i < OPEN_TRIES; i++) {
+    fd = shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if(fd >= 0 && fstat(fd, &st) == 0 &&
+       (size_t)st.st_size >= sizeof(shmRingHeader_t) &&
+       pread(fd, &first, sizeof(first), 0) == (ssize_t)sizeof(first) &&
+       memcmp(first.magic, SHMRING_MAGIC, sizeof(first.magic)) == 0) {
+      break;
+    }
+    if(fd >= 0) {
+      close(fd);
+    }
+    usleep(100000);
+  }
+  if(i == OPEN_TRIES) {
+    fprintf(stderr, "shmtail : no ring %s\n", name.c_str());
+    return NULL;
+  }
+  // the magic is written last, the rest of the header is there with it
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if(first.version != SHMRING_VERSION ||
+     first.slotSize < sizeof(shmRingSlot_t) ||
+     first.slotCount == 0 ||
+     (first.slotCount & (first.slotCount - 1)) != 0 ||
+     (size_t)st.st_size <
+       first.headerLen + (size_t)first.slotCount * first.slotSize) {
+    fprintf(stderr, "shmtail : %s is not a version %d ring\n", name.c_str(),
+            SHMRING_VERSION);
+    close(fd);
+    return NULL;
+  }
+
+  *length = first.headerLen + (size_t)first.slotCount * first.slotSize;
+  map = mmap(NULL, *length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if(map == MAP_FAILED) {
+    perror("shmtail : mmap");
+    return NULL;
+  }
+  return (shmRingHeader_t *)map;
+}
+/*----------------------------------------------------------------------------*/
+static void
+printStats(const tailStats_t &s)
+{
+  printf("records %llu lost %llu bad %llu latency avg %.1f us max %.1f us\n",
+         (unsigned long long)s.records, (unsigned long long)s.lost,
+         (unsigned long long)s.bad,
+         s.records > 0 ? s.latencySum / 1e3 / s.records : 0.0,
+         s.latencyMax / 1e3);
+  fflush(stdout);
+}
+/*----------------------------------------------------------------------------*/
+static void
+usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [-d <seconds>] [-v] <shm name>\n", name);
+  fprintf(stderr, "  -d <seconds>  : stop after this long (default until"
+          " interrupted).\n");
+  fprintf(stderr, "  -v            : print every record.\n");
+}
+/*----------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  shmRingHeader_t *header;
+  const shmRingSlot_t *slot;
+  shmRingSlot_t copy;
+  const char *slots;
+  tailStats_t stats;
+  std::string name;
+  size_t length;
+  uint64_t next, published, seq, stamp, t;
+  uint64_t end = 0, report;
+  uint32_t wake, mask;
+  struct timespec timeout;
+  double duration = 0;
+  bool verbose = false;
+  int c, len;
+
+  while((c = getopt(argc, argv, "d:v")) != -1) {
+    switch(c) {
+      case 'd':
+        duration = atof(optarg);
+        break;
+      case 'v':
+        verbose = true;
+        break;
+      default:
+        usage(argv[0]);
+        return 1;
+    }
+  }
+  if(optind != argc - 1 || duration < 0) {
+    usage(argv[0]);
+    return 1;
+  }
+  // the name the way ShmRing makes it
+  name = argv[optind];
+  if(name[0] != '/') {
+    name = "/" + name;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  header = openRing(name, &length);
+  if(header == NULL) {
+    return 1;
+  }
+  slots = (const char *)header + header->headerLen;
+  mask = header->slotCount - 1;
+
+  memset(&stats, 0, sizeof(stats));
+  next = __atomic_load_n(&header->published, __ATOMIC_ACQUIRE);
+  report = now() + 1000000000ULL;
+  if(duration > 0) {
+    end = now() + (uint64_t)(duration * 1e9);
+  }
+  timeout.tv_sec = 0;
+  timeout.tv_nsec = WAIT_MS * 1000000L;
+
+  while(!stop) {
+    // the wake word before published, a batch published after the load
+    // changes it and the futex wait returns at once
+    wake = __atomic_load_n(&header->wake, __ATOMIC_ACQUIRE);
+    published = __atomic_load_n(&header->published, __ATOMIC_ACQUIRE);
+
+    while(next < published) {
+      slot = (const shmRingSlot_t *)(slots + (next & mask) *
+                                             header->slotSize);
+      seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+      if(seq == next + 1) {
+        len = slot->length;
+        if(len > MAX_PKT_SIZE) {
+          len = MAX_PKT_SIZE;
+        }
+        copy.timestamp = slot->timestamp;
+        copy.length = slot->length;
+        copy.type = slot->type;
+        copy.source = slot->source;
+        memcpy(copy.payload, slot->payload, len);
+        // the copy has to be done before seq is looked at again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+      }
+      if(seq > next + 1 || seq == 0) {
+        // overwritten while we copied it or before we got to it, go on
+        // from the oldest record still there
+        published = __atomic_load_n(&header->published, __ATOMIC_ACQUIRE);
+        if(published > header->slotCount &&
+           next < published - header->slotCount) {
+          stats.lost += published - header->slotCount - next;
+          next = published - header->slotCount;
+        }
+        continue;
+      }
+      if(seq != next + 1) {
+        // a slot behind published that does not have its record yet
+        fprintf(stderr, "shmtail : record %llu has seq %llu\n",
+                (unsigned long long)next, (unsigned long long)seq);
+        stats.bad++;
+        next++;
+        continue;
+      }
+
+      t = now();
+      stamp = copy.timestamp;
+      if(copy.length > MAX_PKT_SIZE || stamp > t) {
+        fprintf(stderr, "shmtail : record %llu has length %u stamp %llu\n",
+                (unsigned long long)next, copy.length,
+                (unsigned long long)stamp);
+        stats.bad++;
+      } else {
+        stats.records++;
+        stats.latencySum += t - stamp;
+        if(t - stamp > stats.latencyMax) {
+          stats.latencyMax = t - stamp;
+        }
+      }
+      if(verbose) {
+        printf("%llu type %u sink %u length %u\n",
+               (unsigned long long)next, copy.type, copy.source,
+               copy.length);
+      }
+      next++;
+    }
+
+    t = now();
+    if(t >= report) {
+      printStats(stats);
+      report = t + 1000000000ULL;
+    }
+    if(end != 0 && t >= end) {
+      break;
+    }
+    if(next == __atomic_load_n(&header->published, __ATOMIC_ACQUIRE)) {
+      syscall(SYS_futex, &header->wake, FUTEX_WAIT, wake, &timeout, NULL,
+              0);
+    }
+  }
+
+  printStats(stats);
+  munmap(header, length);
+  return stats.bad > 0 ? 1 : 0;
+}
+/*----------------------------------------------------------------------------*/
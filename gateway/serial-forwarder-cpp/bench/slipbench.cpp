@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2009, Wireless Ad-Hoc Sensor Network Laboratory -
+ * University of Colombo School of Computing.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * This file is part of the tikiridb system.
+ *
+ * \author
+ *      Kasun Hewage <kch@ucsc.cmb.ac.lk>
+ */
+
+/* \file
+ *      Microbenchmark of the SLIP codec.
+ *      Encodes and decodes a stream of frames with SlipCodec and with the
+ *      byte at a time loops it replaced, checks that both agree and prints
+ *      the throughput of each.
+ *
+ *      usage: slipbench [frames] [payload length] [special bytes per 1000]
+ */
+
+#include <sys/time.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../SlipCodec.h"
+
+#define FRAME_SIZE 256
+#define READ_SIZE 4096
+#define ROUNDS 20
+
+/*----------------------------------------------------------------------------*/
+static double
+now()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1e6;
+}
+/*----------------------------------------------------------------------------*/
+/* the encoder SerialComm used before SlipCodec */
+static int
+encodeBytewise(const char *in, int len, char *out)
+{
+  int i;
+  int k = 0;
+
+  out[k++] = SLIP_END;
+  for(i = 0; i < len; i++) {
+    switch((unsigned char)in[i]) {
+      case SLIP_END:
+        out[k++] = SLIP_ESC;
+        out[k++] = SLIP_ESC_END;
+        break;
+      case SLIP_ESC:
+        out[k++] = SLIP_ESC;
+        out[k++] = SLIP_ESC_ESC;
+        break;
+      default:
+        out[k++] = in[i];
+        break;
+    }
+  }
+  out[k++] = SLIP_END;
+  return k;
+}
+/*----------------------------------------------------------------------------*/
+/* the decoder SerialComm used before SlipCodec, reading from a FIFO. The
+ * frames are put one after the other into out. */
+static int
+decodeBytewise(const char *in, int inLen, char *out,
+               std::vector<int> &lengths)
+{
+  char *frame = out;
+  int received = 0;
+  int frames = 0;
+  int pos = 0;
+  unsigned char c;
+
+  while(pos < inLen) {
+    c = in[pos++];
+    switch(c) {
+      case SLIP_END:
+        if(received > 0) {
+          lengths.push_back(received);
+          frames++;
+          frame += received;
+          received = 0;
+        }
+        break;
+      case SLIP_ESC:
+        if(pos == inLen) {
+          return frames;
+        }
+        c = in[pos++];
+        if(c == SLIP_ESC_END) {
+          c = SLIP_END;
+        } else if(c == SLIP_ESC_ESC) {
+          c = SLIP_ESC;
+        }
+        // fall through
+      default:
+        if(received < FRAME_SIZE) {
+          frame[received++] = c;
+        }
+    }
+  }
+  return frames;
+}
+/*----------------------------------------------------------------------------*/
+/* decodes in READ_SIZE chunks the way SerialComm reads the device */
+static int
+decodeBulk(const char *in, int inLen, char *out, std::vector<int> &lengths)
+{
+  SlipCodec codec;
+  char *frame = out;
+  int frameLen;
+  int frames = 0;
+  int pos, end, chunk;
+
+  for(chunk = 0; chunk < inLen; chunk += READ_SIZE) {
+    end = (chunk + READ_SIZE < inLen) ? chunk + READ_SIZE : inLen;
+    pos = chunk;
+    while(pos < end) {
+      pos += codec.decode(in + pos, end - pos, frame, FRAME_SIZE, frameLen);
+      if(frameLen > 0) {
+        lengths.push_back(frameLen);
+        frames++;
+        frame += frameLen;
+      }
+    }
+  }
+  return frames;
+}
+/*----------------------------------------------------------------------------*/
+int
+main(int argc, char *argv[])
+{
+  int nframes = (argc > 1) ? atoi(argv[1]) : 100000;
+  int payloadLen = (argc > 2) ? atoi(argv[2]) : 64;
+  int special = (argc > 3) ? atoi(argv[3]) : 8;
+  std::vector<char> payloads((size_t)nframes * payloadLen);
+  std::vector<char> stream((size_t)nframes * SLIP_ENCODED_SIZE(payloadLen));
+  std::vector<char> check(stream.size());
+  std::vector<char> decodedRef(payloads.size()), decodedBulk(payloads.size());
+  std::vector<int> lengthsRef, lengthsBulk;
+  double t, encRef, encBulk, decRef, decBulk;
+  size_t i, len, lenRef;
+  int r, n, framesRef, framesBulk;
+
+  if(payloadLen < 1 || payloadLen > FRAME_SIZE) {
+    fprintf(stderr, "payload length must be 1..%d\n", FRAME_SIZE);
+    return 1;
+  }
+
+  srand(1);
+  for(i = 0; i < payloads.size(); i++) {
+    if(rand() % 1000 < special) {
+      payloads[i] = (rand() & 1) ? SLIP_END : SLIP_ESC;
+    } else {
+      do {
+        payloads[i] = rand();
+      } while((unsigned char)payloads[i] == SLIP_END ||
+              (unsigned char)payloads[i] == SLIP_ESC);
+    }
+  }
+
+  t = now();
+  for(r = 0; r < ROUNDS; r++) {
+    lenRef = 0;
+    for(n = 0; n < nframes; n++) {
+      lenRef += encodeBytewise(&payloads[(size_t)n * payloadLen], payloadLen,
+                               &check[lenRef]);
+    }
+  }
+  encRef = now() - t;
+
+  t = now();
+  for(r = 0; r < ROUNDS; r++) {
+    len = 0;
+    for(n = 0; n < nframes; n++) {
+      len += SlipCodec::encode(&payloads[(size_t)n * payloadLen], payloadLen,
+                               &stream[len]);
+    }
+  }
+  encBulk = now() - t;
+
+  if(len != lenRef || memcmp(&stream[0], &check[0], len) != 0) {
+    fprintf(stderr, "encoders disagree\n");
+    return 1;
+  }
+
+  t = now();
+  for(r = 0; r < ROUNDS; r++) {
+    lengthsRef.clear();
+    framesRef = decodeBytewise(&stream[0], len, &decodedRef[0], lengthsRef);
+  }
+  decRef = now() - t;
+
+  t = now();
+  for(r = 0; r < ROUNDS; r++) {
+    lengthsBulk.clear();
+    framesBulk = decodeBulk(&stream[0], len, &decodedBulk[0], lengthsBulk);
+  }
+  decBulk = now() - t;
+
+  if(framesRef != nframes || framesBulk != nframes ||
+     lengthsRef != lengthsBulk || decodedRef != payloads ||
+     decodedBulk != payloads) {
+    fprintf(stderr, "decoders disagree: %d and %d of %d frames\n",
+            framesRef, framesBulk, nframes);
+    return 1;
+  }
+
+  printf("%d frames of %d bytes, %d special bytes per 1000, %lu bytes "
+         "encoded\n", nframes, payloadLen, special, (unsigned long)len);
+  printf("encode  bytewise %8.1f MB/s  bulk %8.1f MB/s  x%.1f\n",
+         ROUNDS * len / encRef / 1e6, ROUNDS * len / encBulk / 1e6,
+         encRef / encBulk);
+  printf("decode  bytewise %8.1f MB/s  bulk %8.1f MB/s  x%.1f\n",
+         ROUNDS * len / decRef / 1e6, ROUNDS * len / decBulk / 1e6,
+         decRef / decBulk);
+  return 0;
+}
+/*----------------------------------------------------------------------------*/
@@ -38,17 +38,28 @@
  */
 
 #include <signal.h>
+#include <sched.h>
 #include <errno.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <cstdlib>
+#include <climits>
+#include <algorithm>
 
 
-#include "SerialComm.h"
+#include "CaptureLog.h"
+#include "PacketPool.h"
+#include "QueueTuner.h"
+#include "ReplayComm.h"
+#include "ShmRing.h"
+#include "SinkGroup.h"
+#include "StatsServer.h"
 #include "TCPComm.h"
 #include "Version.h"
 
@@ -70,16 +81,66 @@
 #endif
 
 // number of command line options
-// 0 - serial device
+// 0 - serial device, may be given once per sink mote
 // 1 - baudrate
 // 2 - port
-#define OPT_NUM     3
+// 3 - capture log to write
+// 4 - capture log to replay
+// 5 - replay speed
+// 6 - stats port or socket
+// 7 - sender threads
+// 8 - Unix socket
+// 9 - shared memory ring
+// 10 - io_uring
+// 11 - low latency ingest
+// 12 - reader CPU
+// 13 - reader SCHED_FIFO priority
+// 14 - limit, may be given more than once
+// 15 - limits file
+// 16 - sink group of queries
+#define OPT_NUM     17
+
+// packets a buffer lane holds when not told otherwise
+#define BUFFER_SIZE 25
 
 
 using namespace std;
 
 static volatile int exit_flag;  /* Program termination flag	*/
 
+/* Sizes and limits that can be set with -o or in a -k file. */
+typedef struct limits {
+  int readBuffer;
+  int writeBuffer;
+  int sinkBuffer;
+  int packetPool;
+  int clientQueue;
+  int maxReadClients;
+  int maxWriteClients;
+  int listenBacklog;
+  int senderRing;
+  int adaptiveMB;  // memory the buffers may grow to, 0 keeps them fixed
+} limits_t;
+
+typedef struct limitOption {
+  const char *key;
+  int limits_t::*field;
+  int min;
+} limitOption_t;
+
+static const limitOption_t limitOptions[] = {
+  {"read_buffer",       &limits_t::readBuffer,      1},
+  {"write_buffer",      &limits_t::writeBuffer,     1},
+  {"sink_buffer",       &limits_t::sinkBuffer,      1},
+  {"packet_pool",       &limits_t::packetPool,      0},
+  {"client_queue",      &limits_t::clientQueue,     1},
+  {"max_read_clients",  &limits_t::maxReadClients,  0},
+  {"max_write_clients", &limits_t::maxWriteClients, 0},
+  {"listen_backlog",    &limits_t::listenBacklog,   1},
+  {"sender_ring",       &limits_t::senderRing,      1},
+  {"adaptive_mb",       &limits_t::adaptiveMB,      0}
+};
+
 
 /*---------------------------------------------------------------------------*/
 static void
@@ -97,6 +158,85 @@ signalHandler(int sig_num)
   }
 }
 /*---------------------------------------------------------------------------*/
+static string
+trim(const string &str)
+{
+  size_t first = str.find_first_not_of(" \t\r\n");
+  size_t last = str.find_last_not_of(" \t\r\n");
+
+  if(first == string::npos) {
+    return "";
+  }
+  return str.substr(first, last - first + 1);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Sets one limit from "key=value".
+ * Returns false, and tells why, if key is unknown or value is not a number
+ * the limit can take.
+ */
+static bool
+setLimit(limits_t &limits, const string &option)
+{
+  size_t eq = option.find('=');
+  string key, value;
+  char *end;
+  long number;
+  unsigned int i;
+
+  if(eq == string::npos) {
+    cerr<<"main : expected key=value, got \""<<option<<"\""<<endl;
+    return false;
+  }
+  key = trim(option.substr(0, eq));
+  value = trim(option.substr(eq + 1));
+  for(i = 0; i < sizeof(limitOptions) / sizeof(limitOptions[0]); i++) {
+    if(key != limitOptions[i].key) {
+      continue;
+    }
+    errno = 0;
+    number = strtol(value.c_str(), &end, 10);
+    if(value.empty() || *end != '\0' || errno != 0 ||
+       number < limitOptions[i].min || number > INT_MAX) {
+      cerr<<"main : bad value \""<<value<<"\" for "<<key<<endl;
+      return false;
+    }
+    limits.*limitOptions[i].field = (int)number;
+    return true;
+  }
+  cerr<<"main : unknown limit \""<<key<<"\""<<endl;
+  return false;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Reads limits from a file of "key = value" lines. Empty lines and
+ * everything after a '#' are skipped.
+ */
+static bool
+readLimits(limits_t &limits, const string &path)
+{
+  ifstream file(path.c_str());
+  string line;
+  int lineNo = 0;
+
+  if(!file) {
+    ERROR("main : can not open " << path);
+    return false;
+  }
+  while(getline(file, line)) {
+    lineNo++;
+    line = trim(line.substr(0, line.find('#')));
+    if(line.empty()) {
+      continue;
+    }
+    if(!setLimit(limits, line)) {
+      cerr<<"main : in "<<path<<" line "<<lineNo<<endl;
+      return false;
+    }
+  }
+  return true;
+}
+/*---------------------------------------------------------------------------*/
 static void
 showVersion()
 {
@@ -111,30 +251,101 @@ printUsage(string str)
 {
   showVersion();
   cout<<"Usage:"<<endl;
-  cout<<str<<" -s <serial device> -b <baudrate> -p <port>"<<endl;
+  cout<<str<<" -s <serial device> [-s <serial device> ...] -b <baudrate> -p <port>"
+            " [-w <capture log>] [-m <stats port | stats socket>]"
+            " [-t <sender threads>] [-u <socket>] [-z <shm name>] [-i]"
+            " [-l] [-c <cpu>] [-f <priority>] [-g <sink group>]"
+            " [-k <limits file>] [-o <key>=<value> ...]"<<endl;
+  cout<<str<<" -r <capture log> [-x <speed>] -p <port>"
+            " [-m <stats port | stats socket>] [-t <sender threads>]"
+            " [-u <socket>] [-z <shm name>] [-i]"
+            " [-k <limits file>] [-o <key>=<value> ...]"<<endl;
+  cout<<"  -w appends every frame read to the log"<<endl;
+  cout<<"  -r replays the log, once a read client is connected, instead of"
+        " reading serial devices. -x scales its pace, 0 replays without"
+        " gaps"<<endl;
+  cout<<"  -m serves counters and latencies on a local port or Unix socket,"
+        " as text or, asked for with \"json\", as JSON"<<endl;
+  cout<<"  -t sends to read clients from a shared ring with this many"
+        " threads. A client that falls a whole ring behind is"
+        " disconnected"<<endl;
+  cout<<"  -u also serves clients on a Unix socket"<<endl;
+  cout<<"  -z puts every packet read into a shared memory ring for local"
+        " readers, see ShmRing.h and bench/shmtail.cpp"<<endl;
+  cout<<"  -i reads serial devices and writes to clients through io_uring,"
+        " falling back to read() and sendmsg() where the kernel has"
+        " none"<<endl;
+  cout<<"  -l reads serial devices with low latency, handing every byte on"
+        " as it comes instead of waiting for more. -c pins the reader"
+        " threads to a CPU, -f runs them with SCHED_FIFO at a priority"<<endl;
+  cout<<"  -g makes a sink group, 0 to 255, the root of every query clients"
+        " send. The sinks join it and results go to the nearest of"
+        " them"<<endl;
+  cout<<"  -k reads limits from a file of key = value lines, -o sets one."
+        " -o given later wins. The keys are"<<endl;
+  cout<<"     read_buffer, write_buffer, sink_buffer  packets a buffer lane"
+        " holds ("<<BUFFER_SIZE<<", "<<BUFFER_SIZE<<", "
+        <<SINK_WRITE_BUFFER_SIZE<<")"<<endl;
+  cout<<"     packet_pool        packets kept allocated ("
+        <<PACKET_POOL_SIZE<<")"<<endl;
+  cout<<"     client_queue       packets queued for a read client ("
+        <<CLIENT_QUEUE_LENGTH<<")"<<endl;
+  cout<<"     max_read_clients, max_write_clients  ("<<MAX_READ_CLIENTS
+        <<", "<<MAX_WRITE_CLIENTS<<")"<<endl;
+  cout<<"     listen_backlog     ("<<LISTEN_QUEUE_LENGTH<<")"<<endl;
+  cout<<"     sender_ring        packets in the -t ring ("
+        <<SENDER_RING_SIZE<<")"<<endl;
+  cout<<"     adaptive_mb        grows the read and write buffers under"
+        " pressure, using up to this many MB (0, fixed)"<<endl;
 }
 /*---------------------------------------------------------------------------*/
 int main(int argc, char *argv[])
 {
 
   int i, c;
-  char *serialPort;
+  vector<string> serialPorts;
   int baudrate;
   int port;
+  string capturePath;
+  string replayPath;
+  string statsAddress;
+  string unixPath;
+  string shmName;
+  double replaySpeed = 1;
+  int senders = 0;
+  int sinkGroup = -1;
+  ingestOptions_t ingest;
   bool argErr = false;
   int wantOpt[OPT_NUM];
+  vector<string> limitArgs;
+  string limitsPath;
+  limits_t limits;
 
 
   for(i = 0; i < OPT_NUM; i++) {
     wantOpt[i] = 0;
   }
+  ingest.lowLatency = false;
+  ingest.cpu = -1;
+  ingest.fifoPriority = 0;
 
   // processing command line args
-  while((c = getopt(argc, argv, "s:b:p:v")) != -1) {
+  limits.readBuffer = BUFFER_SIZE;
+  limits.writeBuffer = BUFFER_SIZE;
+  limits.sinkBuffer = SINK_WRITE_BUFFER_SIZE;
+  limits.packetPool = PACKET_POOL_SIZE;
+  limits.clientQueue = CLIENT_QUEUE_LENGTH;
+  limits.maxReadClients = MAX_READ_CLIENTS;
+  limits.maxWriteClients = MAX_WRITE_CLIENTS;
+  limits.listenBacklog = LISTEN_QUEUE_LENGTH;
+  limits.senderRing = SENDER_RING_SIZE;
+  limits.adaptiveMB = 0;
+
+  while((c = getopt(argc, argv, "s:b:p:w:r:x:m:t:u:z:ilc:f:k:o:g:v")) != -1) {
     switch(c) {
       case 's':
         wantOpt[0]++;
-        serialPort = optarg;
+        serialPorts.push_back(optarg);
         break;
       case 'b':
         wantOpt[1]++;
@@ -144,6 +355,61 @@ int main(int argc, char *argv[])
         wantOpt[2]++;
         port = atoi(optarg);
         break;
+      case 'w':
+        wantOpt[3]++;
+        capturePath = optarg;
+        break;
+      case 'r':
+        wantOpt[4]++;
+        replayPath = optarg;
+        break;
+      case 'x':
+        wantOpt[5]++;
+        replaySpeed = atof(optarg);
+        break;
+      case 'm':
+        wantOpt[6]++;
+        statsAddress = optarg;
+        break;
+      case 't':
+        wantOpt[7]++;
+        senders = atoi(optarg);
+        break;
+      case 'u':
+        wantOpt[8]++;
+        unixPath = optarg;
+        break;
+      case 'z':
+        wantOpt[9]++;
+        shmName = optarg;
+        break;
+      case 'i':
+        wantOpt[10]++;
+        break;
+      case 'l':
+        wantOpt[11]++;
+        ingest.lowLatency = true;
+        break;
+      case 'c':
+        wantOpt[12]++;
+        ingest.cpu = atoi(optarg);
+        break;
+      case 'f':
+        wantOpt[13]++;
+        ingest.fifoPriority = atoi(optarg);
+        break;
+      case 'o':
+        wantOpt[14]++;
+        limitArgs.push_back(optarg);
+        break;
+      case 'k':
+        wantOpt[15]++;
+        limitsPath = optarg;
+        break;
+      case 'g':
+        wantOpt[16]++;
+        sinkGroup = atoi(optarg);
+        break;
       case 'v':
         showVersion();
         return 0;
@@ -157,15 +423,43 @@ int main(int argc, char *argv[])
     }
   }
 
-  for(i = 0; i < OPT_NUM; i++) {
-    if(wantOpt[i] == 0) {
-      printUsage(argv[0]);
+  // either serial devices and their baudrate or a log to replay
+  if(wantOpt[2] == 0 || replaySpeed < 0 || senders < 0 ||
+     (wantOpt[16] != 0 && (sinkGroup < 0 || sinkGroup > 0xFF)) ||
+     (wantOpt[12] != 0 && ingest.cpu < 0) ||
+     (wantOpt[13] != 0 &&
+      (ingest.fifoPriority < sched_get_priority_min(SCHED_FIFO) ||
+       ingest.fifoPriority > sched_get_priority_max(SCHED_FIFO))) ||
+     (wantOpt[4] == 0 && (wantOpt[0] == 0 || wantOpt[1] == 0)) ||
+     (wantOpt[4] != 0 && (wantOpt[0] != 0 || wantOpt[3] != 0))) {
+    printUsage(argv[0]);
+    return -1;
+  }
+
+  // the file first, so that -o can override it
+  if(wantOpt[15] != 0 && !readLimits(limits, limitsPath)) {
+    return -1;
+  }
+  for(i = 0; i < (int)limitArgs.size(); i++) {
+    if(!setLimit(limits, limitArgs[i])) {
       return -1;
     }
   }
 
-  PacketBuffer readPktBuffer("ReadBuffer", 25);
-  PacketBuffer writePktBuffer("WriteBuffer", 25);
+  // adaptive buffers get slots for what half of the memory holds, each,
+  // and start with the size asked for
+  int readCapacity = limits.readBuffer;
+  int writeCapacity = limits.writeBuffer;
+  if(limits.adaptiveMB > 0) {
+    int capacity = PacketBuffer::capacityFor((uint64_t)limits.adaptiveMB
+                                             * 1024 * 1024 / 2);
+    readCapacity = max(readCapacity, capacity);
+    writeCapacity = max(writeCapacity, capacity);
+  }
+  PacketBuffer readPktBuffer("ReadBuffer", limits.readBuffer, readCapacity);
+  PacketBuffer writePktBuffer("WriteBuffer", limits.writeBuffer,
+                              writeCapacity);
+  PacketPool::instance().setSize(limits.packetPool);
 
   exit_flag = 0;
   (void) signal(SIGCHLD, signalHandler);
@@ -178,24 +472,85 @@ int main(int argc, char *argv[])
   (void) signal(SIGQUIT, signalHandler);
 
   TCPComm tcpComm(port, readPktBuffer, writePktBuffer);
-  SerialComm serComm(serialPort, baudrate, readPktBuffer, writePktBuffer);
+  tcpComm.setSenders(senders);
+  tcpComm.setClientLimits(limits.maxReadClients, limits.maxWriteClients);
+  tcpComm.setClientQueueLength(limits.clientQueue);
+  tcpComm.setListenBacklog(limits.listenBacklog);
+  tcpComm.setSenderRingSize(limits.senderRing);
+  tcpComm.setUnixPath(unixPath);
+  tcpComm.setIoUring(wantOpt[10] != 0);
+  ShmRing shmRing(shmName);
+  if(!shmName.empty()) {
+    if(shmRing.open() < 0) {
+      DEBUG("main : can not create the shared memory ring. Exiting..");
+      return -1;
+    }
+    tcpComm.setShmRing(&shmRing);
+  }
+  tcpComm.setSinkGroup(sinkGroup);
+  SinkGroup sinks(readPktBuffer, writePktBuffer);
+  sinks.setIoUring(wantOpt[10] != 0);
+  sinks.setIngest(ingest);
+  sinks.setWriteBufferSize(limits.sinkBuffer);
+  for(i = 0; i < (int)serialPorts.size(); i++) {
+    sinks.addSink(serialPorts[i], baudrate);
+  }
+  CaptureLog capture(capturePath);
+  ReplayComm replay(replayPath, replaySpeed, readPktBuffer);
+  StatsServer stats(statsAddress, tcpComm, readPktBuffer, writePktBuffer);
+  QueueTuner tuner;
+  tuner.addBuffer(&readPktBuffer);
+  tuner.addBuffer(&writePktBuffer);
 
   if(tcpComm.start() < 0) {
     DEBUG("main : can not start TCPComm. Exiting..");
     exit_flag = 1;
   }
 
-  if(serComm.start() < 0) {
-    DEBUG("main : can not start SerialComm. Exiting..");
+  if(exit_flag == 0 && !statsAddress.empty() && stats.start() < 0) {
+    DEBUG("main : can not start the stats server. Exiting..");
     exit_flag = 1;
   }
 
+  if(exit_flag == 0 && limits.adaptiveMB > 0 && tuner.start() < 0) {
+    DEBUG("main : can not start the queue tuner. Exiting..");
+    exit_flag = 1;
+  }
+
+  if(!replayPath.empty()) {
+    // nothing is replayed before someone is there to get it. Readers of
+    // the shared memory ring can not be seen, with one it starts at once.
+    while(exit_flag == 0 && shmName.empty() &&
+          !tcpComm.waitForReadClient(1000));
+    if(exit_flag == 0 && replay.start() < 0) {
+      DEBUG("main : can not start replay. Exiting..");
+      exit_flag = 1;
+    }
+  } else {
+    if(!capturePath.empty()) {
+      if(capture.open() < 0) {
+        DEBUG("main : can not open capture log. Exiting..");
+        exit_flag = 1;
+      }
+      sinks.setCapture(&capture);
+    }
+    if(exit_flag == 0 && sinks.start() < 0) {
+      DEBUG("main : can not start SerialComm. Exiting..");
+      exit_flag = 1;
+    }
+  }
+
   while(exit_flag == 0) {
     sleep(1);
   }
 
-  serComm.cancel();
+  tuner.cancel();
+  stats.cancel();
+  replay.cancel();
+  sinks.cancel();
   tcpComm.cancel();
+  shmRing.close();
+  capture.close();
 
   return 0;
 }
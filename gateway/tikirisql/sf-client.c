@@ -397,7 +397,15 @@ send_query(packet_t * packet, int qLength, int nepoches, char *host, int port)
 
   if (!connected)
     {
-      sockfd = connect_to_server(host, port);
+      /* a host starting with a slash is the Unix socket of sf -u */
+      if (host[0] == '/')
+        {
+          sockfd = connect_to_unix_server(host);
+        }
+      else
+        {
+          sockfd = connect_to_server(host, port);
+        }
       if (sockfd < 0)
         {
           perror("can not connect to the server");
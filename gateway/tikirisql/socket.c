@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netdb.h>
 #include <arpa/inet.h>
@@ -324,6 +325,41 @@ connect_to_server(char *address, int port)
   return sockfd;
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Connect to the Unix socket at path, the one sf -u listens on.
+ */
+int
+connect_to_unix_server(char *path)
+{
+  int sockfd;
+  struct sockaddr_un un;
+  char error_str[MAX_ERROR_STR_SIZE +1];
+
+  if(strlen(path) >= sizeof(un.sun_path)) {
+    LOG_DEBUG("Socket path is too long : %s\n", path);
+    return -1;
+  }
+
+  if((sockfd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1) {
+    strerror_r(errno, error_str, MAX_ERROR_STR_SIZE);
+    LOG_DEBUG("socket: Can not create a socket : %s\n", error_str);
+    return -1;
+  }
+
+  memset(&un, 0, sizeof(un));
+  un.sun_family = AF_UNIX;
+  strcpy(un.sun_path, path);
+
+  if(connect(sockfd, (struct sockaddr *)&un, sizeof(un)) == -1) {
+    close(sockfd);
+    strerror_r(errno, error_str, MAX_ERROR_STR_SIZE);
+    LOG_DEBUG("connect: Can not connect to %s : %s\n", path, error_str);
+    return -1;
+  }
+
+  return sockfd;
+}
+/*---------------------------------------------------------------------------*/
 unsigned int
 get_ready_bytes(SOCKET socketfd)
 {
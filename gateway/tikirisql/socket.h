@@ -44,6 +44,8 @@ int create_server_socket(int port, struct socket * s_socket, int queue_len);
 
 int connect_to_server(char *address, int port);
 
+int connect_to_unix_server(char *path);
+
 unsigned int get_ready_bytes(SOCKET socketfd);
 
 int socket_wait(SOCKET socketfd, int mask, unsigned int m_secs);
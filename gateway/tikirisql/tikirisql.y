@@ -41,6 +41,7 @@
 #include "parser-helper.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 //#define YYSTYPE char *
 #define YYDEBUG 1
 
@@ -272,6 +273,7 @@ lvalue:
 set_host_port:
    set_port set_host ';'
    | set_host set_port ';'
+   | set_host ';'
    ;
 
 set_port:
@@ -284,6 +286,12 @@ set_port:
 set_host:
    HOST NAME {
    host=$2;
+   printf("Setting HOST: %s\n",host);
+	}
+   /* a quoted path is the Unix socket of sf -u, the port is not used */
+   | HOST STRING {
+   host=(char *)$2 + 1;
+   host[strlen(host) - 1]='\0';
    printf("Setting HOST: %s\n",host);
 	}
    ;
@@ -1,21 +1,22 @@
-/* A Bison parser, made by GNU Bison 2.5.  */
+/* A Bison parser, made by GNU Bison 3.8.2.  */
 
 /* Bison interface for Yacc-like parsers in C
-   
-      Copyright (C) 1984, 1989-1990, 2000-2011 Free Software Foundation, Inc.
-   
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
    This program is free software: you can redistribute it and/or modify
    it under the terms of the GNU General Public License as published by
    the Free Software Foundation, either version 3 of the License, or
    (at your option) any later version.
-   
+
    This program is distributed in the hope that it will be useful,
    but WITHOUT ANY WARRANTY; without even the implied warranty of
    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
    GNU General Public License for more details.
-   
+
    You should have received a copy of the GNU General Public License
-   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
 
 /* As a special exception, you may create a larger work that contains
    part or all of the Bison parser skeleton and distribute that work
@@ -26,52 +27,73 @@
    special exception, which will cause the skeleton and the resulting
    Bison output files to be licensed under the GNU General Public
    License without this special exception.
-   
+
    This special exception was added by the Free Software Foundation in
    version 2.2 of Bison.  */
 
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_TIKIRISQLY_H_INCLUDED
+# define YY_YY_TIKIRISQLY_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
 
-/* Tokens.  */
+/* Token kinds.  */
 #ifndef YYTOKENTYPE
 # define YYTOKENTYPE
-   /* Put the tokens into the symbol table, so that GDB and other debuggers
-      know about them.  */
-   enum yytokentype {
-     PORT = 258,
-     HOST = 259,
-     NAME = 260,
-     STRING = 261,
-     INTNUM = 262,
-     NOT = 263,
-     AND = 264,
-     OR = 265,
-     COMPARISON = 266,
-     WHERE = 267,
-     SELECT = 268,
-     FROM = 269,
-     CREATE = 270,
-     STORE = 271,
-     SIZE = 272,
-     AS = 273,
-     ON = 274,
-     EVENT = 275,
-     DO = 276,
-     DELETE = 277,
-     QUERY = 278,
-     SAMPLE = 279,
-     FOR = 280,
-     PERIOD = 281
-   };
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    PORT = 258,                    /* PORT  */
+    HOST = 259,                    /* HOST  */
+    NAME = 260,                    /* NAME  */
+    STRING = 261,                  /* STRING  */
+    INTNUM = 262,                  /* INTNUM  */
+    OR = 263,                      /* OR  */
+    AND = 264,                     /* AND  */
+    NOT = 265,                     /* NOT  */
+    COMPARISON = 266,              /* COMPARISON  */
+    WHERE = 267,                   /* WHERE  */
+    SELECT = 268,                  /* SELECT  */
+    FROM = 269,                    /* FROM  */
+    CREATE = 270,                  /* CREATE  */
+    STORE = 271,                   /* STORE  */
+    SIZE = 272,                    /* SIZE  */
+    AS = 273,                      /* AS  */
+    ON = 274,                      /* ON  */
+    EVENT = 275,                   /* EVENT  */
+    DO = 276,                      /* DO  */
+    DELETE = 277,                  /* DELETE  */
+    QUERY = 278,                   /* QUERY  */
+    SAMPLE = 279,                  /* SAMPLE  */
+    FOR = 280,                     /* FOR  */
+    PERIOD = 281                   /* PERIOD  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
 #endif
-/* Tokens.  */
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
 #define PORT 258
 #define HOST 259
 #define NAME 260
 #define STRING 261
 #define INTNUM 262
-#define NOT 263
+#define OR 263
 #define AND 264
-#define OR 265
+#define NOT 265
 #define COMPARISON 266
 #define WHERE 267
 #define SELECT 268
@@ -89,30 +111,29 @@
 #define FOR 280
 #define PERIOD 281
 
-
-
-
+/* Value type.  */
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
-typedef union YYSTYPE
+union YYSTYPE
 {
-
-/* Line 2068 of yacc.c  */
-#line 63 "tikirisql.y"
+#line 64 "tikirisql.y"
 
   int number;
   unsigned char *string;
 //  int subtok;
 
+#line 125 "tikirisqly.h"
 
-
-/* Line 2068 of yacc.c  */
-#line 110 "tikirisqly.h"
-} YYSTYPE;
+};
+typedef union YYSTYPE YYSTYPE;
 # define YYSTYPE_IS_TRIVIAL 1
-# define yystype YYSTYPE /* obsolescent; will be withdrawn */
 # define YYSTYPE_IS_DECLARED 1
 #endif
 
+
 extern YYSTYPE yylval;
 
 
+int yyparse (void);
+
+
+#endif /* !YY_YY_TIKIRISQLY_H_INCLUDED  */
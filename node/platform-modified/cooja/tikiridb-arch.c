@@ -70,6 +70,9 @@ tikiridb_arch_init(void)
 {
   /* Add attribute "node address" */
   add_attr_entry(1, get_node_address, compare_node_address);
+#if ROUTING_TIKIRIMC
+  tikiridb_set_address_attr(1);
+#endif
   /* Add attribute "temperature" */
   add_attr_entry(2, get_temp, compare_temp);
 }
@@ -71,4 +71,7 @@ tikiridb_arch_init(void)
   add_attr_entry(1, get_temp, compare_temp);
   /* Add attribute "node address" */
   add_attr_entry(2, get_node_address, compare_node_address);
+#if ROUTING_TIKIRIMC
+  tikiridb_set_address_attr(2);
+#endif
 }
@@ -53,6 +53,14 @@
 #define MSG_QREQUEST 1
 #define MSG_QREPLY 2
 
+/*
+ * The query root may name a group of sink motes instead of a single one,
+ * {SINK_GROUP_PREFIX, group id}. Results then go to whichever sink of the
+ * group is cheapest to reach.
+ */
+#define SINK_GROUP_PREFIX 0xFE
+#define is_sink_group(addr) ((addr)->u8[0] == SINK_GROUP_PREFIX)
+
 /* Query message types */
 #define QTYPE_SELECT 1
 #define QTYPE_CREATE 2
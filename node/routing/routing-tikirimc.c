@@ -9,15 +9,15 @@
 #define PRINTF(...)
 #endif
 
-static int
+static void
 tikirimc_recv(struct tikirimc_conn *c, const rimeaddr_t *source)
 {
   struct __routing_conn *r = (struct __routing_conn *)c;
   
   PRINTF("%d.%d: bc: tikirimc_recv, receiver %d.%d\n",
 	 rimeaddr_node_addr.u8[0], rimeaddr_node_addr.u8[1],
-	 from->u8[0],
-	 from->u8[1]);
+	 source->u8[0],
+	 source->u8[1]);
   if(r->u->recv) {
     r->u->recv(r, source);
   }
@@ -42,19 +42,32 @@ __routing_close(struct __routing_conn *c)
 int 
 __routing_send_unicast(struct __routing_conn *c, const rimeaddr_t *addr)
 {
-  tikirimc_send_unicast(&c->c, addr);
+  return tikirimc_send_unicast(&c->c, addr);
 }
 
 int 
 __routing_send_broadcast(struct __routing_conn *c)
 {
-  tikirimc_send_broadcast(&c->c);
+  return tikirimc_send_broadcast(&c->c);
+}
+
+int 
+__routing_send_srt_broadcast(struct __routing_conn *c, const srt_pred *pred)
+{
+  return tikirimc_send_srt_broadcast(&c->c, pred);
+}
+
+int 
+__routing_send_unicast_within(struct __routing_conn *c, 
+    const rimeaddr_t *addr, clock_time_t budget)
+{
+  return tikirimc_send_unicast_within(&c->c, addr, budget);
 }
 
 int 
 __routing_send_multicast(struct __routing_conn *c, const rimeaddr_t *addr)
 {
-  tikirimc_send_multicast(&c->c, addr);
+  return tikirimc_send_multicast(&c->c, addr);
 }
 
 rimeaddr_t 
@@ -88,3 +101,9 @@ __routing_remove_multicast_group(struct __routing_conn *c,
 {
   return tikirimc_remove_multicast_group(&c->c, group);
 }
+
+int 
+__routing_join_sink_group(uint8_t group)
+{
+  return tikirimc_join_sink_group(group);
+}
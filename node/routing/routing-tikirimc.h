@@ -25,6 +25,12 @@ int __routing_send_unicast(struct __routing_conn *c, const rimeaddr_t *addr);
 
 int __routing_send_broadcast(struct __routing_conn *c);
 
+int __routing_send_srt_broadcast(struct __routing_conn *c, 
+    const srt_pred *pred);
+
+int __routing_send_unicast_within(struct __routing_conn *c, 
+    const rimeaddr_t *addr, clock_time_t budget);
+
 int __routing_send_multicast(struct __routing_conn *c, const rimeaddr_t *addr);
 
 rimeaddr_t __routing_create_multicast_group(struct __routing_conn *c);
@@ -41,6 +47,8 @@ int __routing_leave_multicast_group(struct __routing_conn *c,
 int __routing_remove_multicast_group(struct __routing_conn *c, 
     const rimeaddr_t *group);
 
+int __routing_join_sink_group(uint8_t group);
+
 #endif /* __ROUTING_TIKIRIMC_H__ */
 /** @} */
 /** @} */
@@ -0,0 +1,202 @@
+#include "agg.h"
+#include "tikirimc-header.h"
+
+#include <string.h>
+
+#define DEBUG 0
+
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+#define AGG_MAX_RECORDS (AGG_FRAME_SIZE / AGG_RECORD_HDR_SIZE)
+
+typedef struct agg_slot {
+  struct subcast_conn *c;
+  rimeaddr_t destination;
+  rimeaddr_t next_hop;
+  uint8_t ttl;
+  uint8_t len;
+  uint8_t count;
+  struct ctimer ct;
+  /* time the frame is sent at the latest */
+  clock_time_t flush_at;
+  /* where each record starts and when its budget runs out; the budget
+   * left is written into the record when the frame is sent */
+  uint8_t offset[AGG_MAX_RECORDS];
+  clock_time_t deadline[AGG_MAX_RECORDS];
+  uint8_t frame[AGG_FRAME_SIZE];
+} agg_slot;
+
+static agg_slot slots[AGG_SLOTS];
+
+/*---------------------------------------------------------------------------*/
+/* time from now until deadline, 0 if it has passed */
+static clock_time_t
+time_left(clock_time_t deadline, clock_time_t now)
+{
+  clock_time_t d = deadline - now;
+
+  if(d > ((clock_time_t)~0) / 2) {
+    return 0;
+  }
+  return d;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+flush(agg_slot *s)
+{
+  clock_time_t now;
+  uint32_t ms;
+  uint8_t i;
+
+  if(s->count == 0) {
+    return;
+  }
+  ctimer_stop(&s->ct);
+
+  now = clock_time();
+  for(i = 0; i < s->count; i++) {
+    ms = (uint32_t)time_left(s->deadline[i], now) * 1000 / CLOCK_SECOND;
+    if(ms > 0xFFFF) {
+      ms = 0xFFFF;
+    }
+    s->frame[s->offset[i] + 6] = ms & 0xFF;
+    s->frame[s->offset[i] + 7] = (ms >> 8) & 0xFF;
+  }
+
+  PRINTF("Sending %d aggregated packets to %d.%d via %d.%d\n", s->count,
+      s->destination.u8[0], s->destination.u8[1],
+      s->next_hop.u8[0], s->next_hop.u8[1]);
+
+  packetbuf_clear();
+  packetbuf_copyfrom(s->frame, s->len);
+  subcast_send_unicast(s->c, &s->destination, &s->next_hop, s->ttl,
+      RT_ALL_NODES | CT_UNICAST | PKT_APPLICATION_LEVEL_AGG);
+  s->count = 0;
+  s->len = 0;
+  s->ttl = 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+hold_timeout(void *ptr)
+{
+  flush((agg_slot *)ptr);
+}
+/*---------------------------------------------------------------------------*/
+void
+agg_init(void)
+{
+  memset(slots, 0, sizeof(slots));
+}
+/*---------------------------------------------------------------------------*/
+int
+agg_add(struct subcast_conn *c, const rimeaddr_t *destination,
+    const rimeaddr_t *next_hop, const rimeaddr_t *source, uint8_t hops,
+    uint8_t ttl, int16_t original_seq_no, clock_time_t budget)
+{
+  uint8_t i;
+  uint8_t rec[AGG_RECORD_HDR_SIZE + AGG_MAX_RECORD_DATA];
+  uint16_t len = packetbuf_datalen();
+  clock_time_t hold = budget / 2;
+  clock_time_t now;
+  agg_slot *s = NULL;
+
+  if(hold == 0 || len > AGG_MAX_RECORD_DATA) {
+    return 0;
+  }
+
+  for(i = 0; i < AGG_SLOTS; i++) {
+    if(slots[i].count > 0 && slots[i].c == c &&
+        rimeaddr_cmp(&slots[i].destination, destination) &&
+        rimeaddr_cmp(&slots[i].next_hop, next_hop)) {
+      s = &slots[i];
+      break;
+    }
+    if(s == NULL && slots[i].count == 0) {
+      s = &slots[i];
+    }
+  }
+  if(s == NULL) {
+    return 0;
+  }
+
+  /* Build the record first, flushing a full slot reuses packetbuf. */
+  rec[0] = source->u8[0];
+  rec[1] = source->u8[1];
+  rec[2] = original_seq_no & 0xFF;
+  rec[3] = (original_seq_no >> 8) & 0xFF;
+  rec[4] = hops;
+  rec[5] = ttl;
+  /* rec[6] and rec[7] get the budget left when the frame is sent */
+  rec[8] = len;
+  memcpy(&rec[AGG_RECORD_HDR_SIZE], packetbuf_dataptr(), len);
+  len += AGG_RECORD_HDR_SIZE;
+
+  if(s->count > 0 && (s->len + len > AGG_FRAME_SIZE ||
+      s->count == AGG_MAX_RECORDS)) {
+    flush(s);
+  }
+
+  /* the frame goes out when the first of its records has used up its
+   * share of the budget */
+  now = clock_time();
+  if(s->count == 0) {
+    s->c = c;
+    rimeaddr_copy(&s->destination, destination);
+    rimeaddr_copy(&s->next_hop, next_hop);
+    s->flush_at = now + hold;
+    ctimer_set(&s->ct, hold, hold_timeout, s);
+  } else if(time_left(s->flush_at, now) > hold) {
+    s->flush_at = now + hold;
+    ctimer_set(&s->ct, hold, hold_timeout, s);
+  }
+  s->offset[s->count] = s->len;
+  s->deadline[s->count] = now + budget;
+  memcpy(&s->frame[s->len], rec, len);
+  s->len += len;
+  s->count++;
+  if(ttl > s->ttl) {
+    s->ttl = ttl;
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+agg_flush_all(void)
+{
+  uint8_t i;
+
+  for(i = 0; i < AGG_SLOTS; i++) {
+    flush(&slots[i]);
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+agg_next_record(const uint8_t **pos, const uint8_t *end, agg_record *r)
+{
+  const uint8_t *p = *pos;
+
+  if(end - p < AGG_RECORD_HDR_SIZE) {
+    return 0;
+  }
+  r->source.u8[0] = p[0];
+  r->source.u8[1] = p[1];
+  r->original_seq_no = (int16_t)(p[2] | (p[3] << 8));
+  r->hops = p[4];
+  r->ttl = p[5];
+  r->budget = (clock_time_t)((uint32_t)(p[6] | (p[7] << 8)) * CLOCK_SECOND /
+      1000);
+  r->len = p[8];
+  r->data = p + AGG_RECORD_HDR_SIZE;
+  if(end - r->data < r->len) {
+    return 0;
+  }
+  *pos = r->data + r->len;
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,65 @@
+#ifndef __AGG_H__
+#define __AGG_H__
+
+#include "contiki.h"
+#include "net/rime.h"
+
+#include "config.h"
+#include "subcast.h"
+
+/**
+ *  Opportunistic aggregation of forwarded unicast packets.
+ *
+ *  Small packets that a node sends to the same destination through the
+ *  same next hop are held for a short while and sent as one
+ *  PKT_APPLICATION_LEVEL_AGG frame. The frame is a sequence of records, each
+ *  one the subcast fields of a packet followed by its data:
+ *
+ *    source (2) | original seq no (2) | hops (1) | ttl (1) | budget (2) |
+ *    len (1) | data
+ *
+ *  budget is the time in ms the packet may still spend in the network,
+ *  little endian. Every node holds a packet for at most half of what is
+ *  left and passes the rest on, so all the holds on the way add up to less
+ *  than the budget the source gave it.
+ */
+
+#define AGG_RECORD_HDR_SIZE 9
+
+typedef struct agg_record {
+  rimeaddr_t source;
+  int16_t original_seq_no;
+  uint8_t hops;
+  uint8_t ttl;
+  clock_time_t budget;
+  uint8_t len;
+  const uint8_t *data;
+} agg_record;
+
+void agg_init(void);
+
+/**
+ * \brief       Queue the packet in packetbuf for sending
+ * \retval      1 if the packet was queued, 0 if the caller has to send it.
+ *
+ *              hops and ttl are the values the packet is sent with. budget
+ *              is the time the packet may still spend in the network, a
+ *              packet with less than two ticks left is not held.
+ */
+int agg_add(struct subcast_conn *c, const rimeaddr_t *destination,
+    const rimeaddr_t *next_hop, const rimeaddr_t *source, uint8_t hops,
+    uint8_t ttl, int16_t original_seq_no, clock_time_t budget);
+
+/**
+ * \brief       Send all held packets now
+ */
+void agg_flush_all(void);
+
+/**
+ * \brief       Read the record at *pos of a received frame
+ * \retval      1 and advances *pos, or 0 at the end of the frame or if the
+ *              record is truncated.
+ */
+int agg_next_record(const uint8_t **pos, const uint8_t *end, agg_record *r);
+
+#endif /* __AGG_H__ */
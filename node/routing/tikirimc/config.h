@@ -9,9 +9,24 @@
 
 #define BEACON_MESSAGE_INTERVAL_INIT 5 * CLOCK_SECOND
 #define BEACON_MESSAGE_INTERVAL_CONVERGED 30 * CLOCK_SECOND
-#define MAX_ROUTING_ENTRIES 10
+#define MAX_ROUTING_ENTRIES 32
+/* Size of the routing table hash index. Must be a power of two and larger
+ * than MAX_ROUTING_ENTRIES. */
+#define ROUTING_INDEX_SIZE 64
+/* Routing entry timeouts are kept on a wheel of ROUTING_WHEEL_SLOTS slots
+ * (power of two) that advances once per ROUTING_WHEEL_TICK. One turn of the
+ * wheel must be longer than the longest entry timeout. */
+#define ROUTING_WHEEL_TICK (10 * CLOCK_SECOND)
+#define ROUTING_WHEEL_SLOTS 64
 #define ROUTING_ENTRY_TIMEOUT 540 * CLOCK_SECOND
 #define PARENT_ENTRY_TIMEOUT 540 * CLOCK_SECOND
+/* Sub-roots send their parent only the routing entries changed since the 
+ * last acknowledged version, at most RTABLE_MAX_DELTA_ENTRIES per packet, 
+ * and the whole table every RTABLE_FULL_REFRESH control process ticks. The 
+ * full refresh has to come well before ROUTING_ENTRY_TIMEOUT. */
+#define RTABLE_MAX_DELTA_ENTRIES 8
+#define RTABLE_MAX_REMOVED 8
+#define RTABLE_FULL_REFRESH 60
 
 #define SEQ_ENTRY_TIMEOUT 300 * CLOCK_SECOND
 
@@ -37,5 +52,27 @@
 #define MAX_TTL 25
 #define MULTICAST_GROUP_TIMEOUT 10 * 60 * CLOCK_SECOND
 
+/* Number of sink groups a node keeps a route to. A route that is not 
+ * announced again within SINK_ENTRY_TIMEOUT is dropped, so results move to 
+ * another sink of the group soon after a sink fails. */
+#define SINK_MAX_GROUPS 2
+#define SINK_ENTRY_TIMEOUT 120 * CLOCK_SECOND
+#define SINK_COST_UNREACHABLE 0xFF
+
+/* Number of children whose subtree ranges are kept for semantic routing. */
+#define SRT_MAX_CHILDREN 8
+/* An unchanged subtree range is resent every SRT_SUMMARY_REFRESH control 
+ * process ticks. */
+#define SRT_SUMMARY_REFRESH 12
+
+/* Unicast packets of up to AGG_MAX_RECORD_DATA bytes are held for at most 
+ * half of their latency budget and sent together in frames of AGG_FRAME_SIZE 
+ * bytes. AGG_SLOTS frames, each to a different destination, can be filled at 
+ * once. Packets that arrive without a budget get AGG_DEFAULT_BUDGET. */
+#define AGG_SLOTS 2
+#define AGG_FRAME_SIZE 96
+#define AGG_MAX_RECORD_DATA 32
+#define AGG_DEFAULT_BUDGET (CLOCK_SECOND / 2)
+
 
 #endif /* __TIKIRIMC_CONFIG_H__ */
@@ -0,0 +1,235 @@
+#include "rtable.h"
+
+#include <string.h>
+
+#define DEBUG 0
+
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+#define INDEX_MASK (ROUTING_INDEX_SIZE - 1)
+#define WHEEL_MASK (ROUTING_WHEEL_SLOTS - 1)
+
+enum {
+  ENTRY_FREE,
+  ENTRY_IDLE,   /* in use, no timeout running */
+  ENTRY_TIMED,  /* in use and linked into a wheel slot */
+};
+
+static routing_entry pool[MAX_ROUTING_ENTRIES];
+static uint8_t free_head;
+static uint8_t nentries;
+
+/* pool index + 1 of the entry hashed to each slot, 0 if the slot is empty */
+static uint8_t rtable_index[ROUTING_INDEX_SIZE];
+
+static uint8_t wheel[ROUTING_WHEEL_SLOTS];
+static uint16_t wheel_now;
+static struct ctimer wheel_timer;
+
+static void (*expired_callback)(routing_entry *e);
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+hash(const rimeaddr_t *addr)
+{
+  return ((addr->u8[0] << 3) ^ (addr->u8[0] >> 5) ^ addr->u8[1]) & INDEX_MASK;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_insert(routing_entry *e)
+{
+  uint8_t slot = e->expires & WHEEL_MASK;
+
+  e->wheel_next = wheel[slot];
+  wheel[slot] = e - pool;
+  e->used = ENTRY_TIMED;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_unlink(routing_entry *e)
+{
+  uint8_t *p = &wheel[e->expires & WHEEL_MASK];
+
+  while(*p != RTABLE_NULL_INDEX) {
+    if(&pool[*p] == e) {
+      *p = e->wheel_next;
+      break;
+    }
+    p = &pool[*p].wheel_next;
+  }
+  e->used = ENTRY_IDLE;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_tick(void *ptr)
+{
+  uint8_t slot, i;
+  routing_entry *e;
+
+  ctimer_reset(&wheel_timer);
+  wheel_now++;
+  slot = wheel_now & WHEEL_MASK;
+
+  /* Timeouts are shorter than one wheel turn, so everything queued on this
+   * slot expires now. Entries are unlinked one at a time since the callback
+   * may touch other entries of the same slot. */
+  while((i = wheel[slot]) != RTABLE_NULL_INDEX) {
+    e = &pool[i];
+    wheel[slot] = e->wheel_next;
+    e->used = ENTRY_IDLE;
+    PRINTF("Routing entry for %d.%d expired\n",
+        e->node_addr.u8[0], e->node_addr.u8[1]);
+    if(expired_callback != NULL) {
+      expired_callback(e);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+rtable_init(void (*expired)(routing_entry *e))
+{
+  uint8_t i;
+
+  memset(pool, 0, sizeof(pool));
+  memset(rtable_index, 0, sizeof(rtable_index));
+  memset(wheel, RTABLE_NULL_INDEX, sizeof(wheel));
+
+  for(i = 0; i < MAX_ROUTING_ENTRIES; i++) {
+    pool[i].wheel_next = (i + 1 < MAX_ROUTING_ENTRIES) ? i + 1 :
+        RTABLE_NULL_INDEX;
+  }
+  free_head = 0;
+  nentries = 0;
+  wheel_now = 0;
+  expired_callback = expired;
+
+  ctimer_set(&wheel_timer, ROUTING_WHEEL_TICK, wheel_tick, NULL);
+}
+/*---------------------------------------------------------------------------*/
+routing_entry *
+rtable_lookup(const rimeaddr_t *addr)
+{
+  uint8_t i, slot;
+
+  for(i = hash(addr); (slot = rtable_index[i]) != 0; i = (i + 1) & INDEX_MASK) {
+    if(rimeaddr_cmp(&pool[slot - 1].node_addr, addr)) {
+      return &pool[slot - 1];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+routing_entry *
+rtable_add(const rimeaddr_t *addr)
+{
+  uint8_t i;
+  routing_entry *e;
+
+  if(free_head == RTABLE_NULL_INDEX) {
+    PRINTF("Routing table full, %d.%d not added\n", addr->u8[0], addr->u8[1]);
+    return NULL;
+  }
+
+  e = &pool[free_head];
+  free_head = e->wheel_next;
+
+  memset(e, 0, sizeof(routing_entry));
+  rimeaddr_copy(&e->node_addr, addr);
+  e->wheel_next = RTABLE_NULL_INDEX;
+  e->used = ENTRY_IDLE;
+
+  for(i = hash(addr); rtable_index[i] != 0; i = (i + 1) & INDEX_MASK);
+  rtable_index[i] = (e - pool) + 1;
+  nentries++;
+
+  return e;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtable_remove(routing_entry *e)
+{
+  uint8_t i, j, k;
+  uint8_t slot = (e - pool) + 1;
+
+  if(e->used == ENTRY_FREE) {
+    return;
+  }
+  if(e->used == ENTRY_TIMED) {
+    wheel_unlink(e);
+  }
+
+  for(i = hash(&e->node_addr); rtable_index[i] != slot;
+      i = (i + 1) & INDEX_MASK);
+  rtable_index[i] = 0;
+
+  /* Shift back the rest of the probe run so lookups never stop early at
+   * the hole we just made. */
+  for(j = (i + 1) & INDEX_MASK; rtable_index[j] != 0;
+      j = (j + 1) & INDEX_MASK) {
+    k = hash(&pool[rtable_index[j] - 1].node_addr);
+    if((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    rtable_index[i] = rtable_index[j];
+    rtable_index[j] = 0;
+    i = j;
+  }
+
+  e->used = ENTRY_FREE;
+  e->wheel_next = free_head;
+  free_head = e - pool;
+  nentries--;
+}
+/*---------------------------------------------------------------------------*/
+void
+rtable_set_timeout(routing_entry *e, clock_time_t timeout)
+{
+  clock_time_t ticks = (timeout + ROUTING_WHEEL_TICK - 1) / ROUTING_WHEEL_TICK;
+
+  if(ticks == 0) {
+    ticks = 1;
+  } else if(ticks >= ROUTING_WHEEL_SLOTS) {
+    ticks = ROUTING_WHEEL_SLOTS - 1;
+  }
+
+  if(e->used == ENTRY_TIMED) {
+    wheel_unlink(e);
+  }
+  e->expires = wheel_now + ticks;
+  wheel_insert(e);
+}
+/*---------------------------------------------------------------------------*/
+int
+rtable_length(void)
+{
+  return nentries;
+}
+/*---------------------------------------------------------------------------*/
+static routing_entry *
+first_used(routing_entry *e)
+{
+  for(; e < &pool[MAX_ROUTING_ENTRIES]; e++) {
+    if(e->used != ENTRY_FREE) {
+      return e;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+routing_entry *
+rtable_head(void)
+{
+  return first_used(pool);
+}
+/*---------------------------------------------------------------------------*/
+routing_entry *
+rtable_next(routing_entry *e)
+{
+  return first_used(e + 1);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,75 @@
+#ifndef __RTABLE_H__
+#define __RTABLE_H__
+
+#include "contiki.h"
+#include "net/rime.h"
+
+#include "config.h"
+
+/**
+ *  TikiriMC routing table.
+ *
+ *  Entries live in a fixed pool and are found through an open-addressing
+ *  index keyed by rimeaddr_t, so a lookup costs the same no matter how many
+ *  decendents a sub-root keeps. Entry timeouts are driven by one shared
+ *  timeout wheel instead of a ctimer per entry.
+ */
+
+#define RTABLE_NULL_INDEX 0xFF
+
+typedef struct routing_entry {
+  rimeaddr_t node_addr;
+  uint8_t relation;
+  rimeaddr_t next_hop_addr;
+  uint16_t hop_count;
+  uint16_t beacon_value;
+  /* routing table version of the last change, see PKT_RTABLE_DELTA. */
+  uint8_t version;
+  /* set while a full PKT_RTABLE_DELTA refresh from the next hop has not
+   * listed the entry yet. */
+  uint8_t stale;
+  /* wheel tick on which this entry expires. */
+  uint16_t expires;
+  /* pool index of the next entry in the same wheel slot. */
+  uint8_t wheel_next;
+  uint8_t used;
+} routing_entry;
+
+/**
+ * \brief       Initialize the routing table
+ * \param expired  Called for every entry whose timeout has passed. The
+ *                 callback is expected to call rtable_remove().
+ */
+void rtable_init(void (*expired)(routing_entry *e));
+
+/**
+ * \brief       Find the entry of a node or multicast group
+ * \retval      The entry, or NULL if there is no entry for addr.
+ */
+routing_entry *rtable_lookup(const rimeaddr_t *addr);
+
+/**
+ * \brief       Allocate an entry for addr
+ * \retval      The new entry with only node_addr set, or NULL if the table
+ *              is full. The caller must make sure addr is not in the table.
+ */
+routing_entry *rtable_add(const rimeaddr_t *addr);
+
+void rtable_remove(routing_entry *e);
+
+/**
+ * \brief       (Re)start the timeout of an entry
+ *
+ *              Timeouts are rounded up to the wheel tick and must not be
+ *              longer than ROUTING_WHEEL_SLOTS * ROUTING_WHEEL_TICK.
+ */
+void rtable_set_timeout(routing_entry *e, clock_time_t timeout);
+
+int rtable_length(void);
+
+/* Iterate over all entries: for(e = rtable_head(); e; e = rtable_next(e)) */
+routing_entry *rtable_head(void);
+
+routing_entry *rtable_next(routing_entry *e);
+
+#endif /* __RTABLE_H__ */
@@ -0,0 +1,252 @@
+#include "srt.h"
+
+#include <string.h>
+
+#define DEBUG 0
+
+#if DEBUG
+#include <stdio.h>
+#define PRINTF(...) printf(__VA_ARGS__)
+#else
+#define PRINTF(...)
+#endif
+
+typedef struct srt_child {
+  rimeaddr_t addr;
+  uint8_t used;
+  srt_range range;
+} srt_child;
+
+static srt_range local;
+static srt_range subtree;
+static uint8_t changed;
+/* a child summary was refused for lack of space */
+static uint8_t overflow;
+/* some child has not reported its range yet */
+static uint8_t unknown;
+
+static srt_child children[SRT_MAX_CHILDREN];
+
+/*---------------------------------------------------------------------------*/
+static void
+merge(srt_range *to, const srt_range *from)
+{
+  uint8_t i;
+
+  for(i = 0; i < SRT_NUM_ATTRS; i++) {
+    if(from->min[i] < to->min[i]) {
+      to->min[i] = from->min[i];
+    }
+    if(from->max[i] > to->max[i]) {
+      to->max[i] = from->max[i];
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+update_subtree(void)
+{
+  srt_range r;
+  uint8_t i;
+
+  memcpy(&r, &local, sizeof(srt_range));
+  if(overflow || unknown) {
+    for(i = 0; i < SRT_NUM_ATTRS; i++) {
+      r.min[i] = 0;
+      r.max[i] = 0xFFFF;
+    }
+  } else {
+    for(i = 0; i < SRT_MAX_CHILDREN; i++) {
+      if(children[i].used) {
+        merge(&r, &children[i].range);
+      }
+    }
+  }
+
+  if(memcmp(&r, &subtree, sizeof(srt_range)) != 0) {
+    memcpy(&subtree, &r, sizeof(srt_range));
+    changed = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static int
+overlaps(const srt_pred *p, const srt_range *r)
+{
+  uint8_t i;
+
+  for(i = 0; i < SRT_NUM_ATTRS; i++) {
+    if((p->attrs & (1 << i)) == 0) {
+      continue;
+    }
+    if(r->max[i] < p->range.min[i] || r->min[i] > p->range.max[i]) {
+      return 0;
+    }
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static srt_child *
+find_child(const rimeaddr_t *child)
+{
+  uint8_t i;
+
+  for(i = 0; i < SRT_MAX_CHILDREN; i++) {
+    if(children[i].used && rimeaddr_cmp(&children[i].addr, child)) {
+      return &children[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_init(void)
+{
+  uint8_t i;
+
+  memset(children, 0, sizeof(children));
+  overflow = 0;
+  unknown = 0;
+  for(i = 0; i < SRT_NUM_ATTRS; i++) {
+    local.min[i] = 0;
+    local.max[i] = 0xFFFF;
+  }
+  local.min[SRT_ATTR_NODE_ID] = rimeaddr_node_addr.u8[0];
+  local.max[SRT_ATTR_NODE_ID] = rimeaddr_node_addr.u8[0];
+
+  memset(&subtree, 0, sizeof(srt_range));
+  update_subtree();
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_set_value(uint8_t attr, uint16_t value)
+{
+  if(attr >= SRT_NUM_ATTRS) {
+    return;
+  }
+  local.min[attr] = value;
+  local.max[attr] = value;
+  update_subtree();
+}
+/*---------------------------------------------------------------------------*/
+int
+srt_update_child(const rimeaddr_t *child, const srt_range *range)
+{
+  uint8_t i;
+  srt_child *c = find_child(child);
+
+  if(c == NULL) {
+    for(i = 0; i < SRT_MAX_CHILDREN; i++) {
+      if(!children[i].used) {
+        c = &children[i];
+        break;
+      }
+    }
+    if(c == NULL) {
+      PRINTF("No space for the summary of %d.%d\n", child->u8[0],
+          child->u8[1]);
+      if(!overflow) {
+        overflow = 1;
+        update_subtree();
+      }
+      return 0;
+    }
+    rimeaddr_copy(&c->addr, child);
+    c->used = 1;
+  }
+
+  memcpy(&c->range, range, sizeof(srt_range));
+  update_subtree();
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_remove_child(const rimeaddr_t *child)
+{
+  srt_child *c = find_child(child);
+
+  if(c != NULL) {
+    c->used = 0;
+    /* the refused child gets the slot when it sends its range again, until
+     * then the caller marks it unknown */
+    overflow = 0;
+    update_subtree();
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+srt_has_child(const rimeaddr_t *child)
+{
+  return find_child(child) != NULL;
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_set_unknown(uint8_t u)
+{
+  if(unknown != u) {
+    unknown = u;
+    update_subtree();
+  }
+}
+/*---------------------------------------------------------------------------*/
+const srt_range *
+srt_subtree_range(void)
+{
+  return &subtree;
+}
+/*---------------------------------------------------------------------------*/
+int
+srt_subtree_changed(void)
+{
+  uint8_t c = changed;
+
+  changed = 0;
+  return c;
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_pred_init(srt_pred *p)
+{
+  memset(p, 0, sizeof(srt_pred));
+}
+/*---------------------------------------------------------------------------*/
+void
+srt_pred_restrict(srt_pred *p, uint8_t attr, uint16_t min, uint16_t max)
+{
+  if(attr >= SRT_NUM_ATTRS) {
+    return;
+  }
+  if(p->attrs & (1 << attr)) {
+    if(min < p->range.min[attr]) {
+      min = p->range.min[attr];
+    }
+    if(max > p->range.max[attr]) {
+      max = p->range.max[attr];
+    }
+  }
+  p->attrs |= 1 << attr;
+  p->range.min[attr] = min;
+  p->range.max[attr] = max;
+}
+/*---------------------------------------------------------------------------*/
+int
+srt_match_local(const srt_pred *p)
+{
+  return overlaps(p, &local);
+}
+/*---------------------------------------------------------------------------*/
+int
+srt_match_children(const srt_pred *p)
+{
+  uint8_t i;
+
+  if(overflow || unknown) {
+    return 1;
+  }
+  for(i = 0; i < SRT_MAX_CHILDREN; i++) {
+    if(children[i].used && overlaps(p, &children[i].range)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,103 @@
+#ifndef __SRT_H__
+#define __SRT_H__
+
+#include "contiki.h"
+#include "net/rime.h"
+
+#include "config.h"
+
+/**
+ *  Semantic routing tree.
+ *
+ *  Every node keeps the min/max of a few constant or slowly changing
+ *  attributes over its subtree. Children report their subtree range to the
+ *  parent, so a query that carries an srt_pred is only forwarded into
+ *  subtrees where some node could satisfy it.
+ */
+
+enum {
+  SRT_ATTR_NODE_ID = 0,
+  SRT_ATTR_LOCATION_X = 1,
+  SRT_ATTR_LOCATION_Y = 2,
+  SRT_ATTR_ZONE = 3,
+  SRT_NUM_ATTRS,
+};
+
+typedef struct srt_range {
+  uint16_t min[SRT_NUM_ATTRS];
+  uint16_t max[SRT_NUM_ATTRS];
+} srt_range;
+
+/* Conjunction of "min <= attr <= max" terms, one per bit set in attrs. */
+typedef struct srt_pred {
+  uint8_t attrs;
+  srt_range range;
+} srt_pred;
+
+/**
+ * \brief       Initialize the local attribute values and forget all children
+ *
+ *              The node id defaults to the first byte of the node address.
+ *              Other attributes are unknown until set and never cause a
+ *              node to be pruned.
+ */
+void srt_init(void);
+
+/**
+ * \brief       Set the value of one of the local attributes
+ */
+void srt_set_value(uint8_t attr, uint16_t value);
+
+/**
+ * \brief       Store the subtree range reported by a child
+ * \retval      0 if there is no space left for the child, 1 otherwise.
+ */
+int srt_update_child(const rimeaddr_t *child, const srt_range *range);
+
+void srt_remove_child(const rimeaddr_t *child);
+
+/**
+ * \brief       Whether the subtree range of child is stored
+ */
+int srt_has_child(const rimeaddr_t *child);
+
+/**
+ * \brief       Mark whether some child has not reported its subtree range
+ *
+ *              While set, or while a child summary had to be refused for
+ *              lack of space, the subtree range covers every value and
+ *              srt_match_children() matches every predicate.
+ */
+void srt_set_unknown(uint8_t unknown);
+
+/**
+ * \brief       Range covering this node and all reported children
+ */
+const srt_range *srt_subtree_range(void);
+
+/**
+ * \brief       Whether the subtree range changed since it was last sent
+ *
+ *              The flag is cleared by this call.
+ */
+int srt_subtree_changed(void);
+
+void srt_pred_init(srt_pred *p);
+
+/**
+ * \brief       Restrict attr to [min, max]. Restricting the same attribute
+ *              twice keeps the intersection.
+ */
+void srt_pred_restrict(srt_pred *p, uint8_t attr, uint16_t min, uint16_t max);
+
+/**
+ * \brief       Whether the local attribute values satisfy p
+ */
+int srt_match_local(const srt_pred *p);
+
+/**
+ * \brief       Whether any reported child subtree could satisfy p
+ */
+int srt_match_children(const srt_pred *p);
+
+#endif /* __SRT_H__ */
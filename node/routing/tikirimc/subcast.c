@@ -158,6 +158,12 @@ subcast_fwd_multicast(struct subcast_conn *c, const rimeaddr_t *group,
       original_seq_no);
 }
 /*---------------------------------------------------------------------------*/
+int16_t
+subcast_next_seq_no(void)
+{
+  return seq_no++;
+}
+/*---------------------------------------------------------------------------*/
 int 
 subcast_send_single_hop_broadcast(struct subcast_conn *c, 
     const uint8_t header)
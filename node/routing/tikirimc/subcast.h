@@ -65,6 +65,10 @@ int subcast_fwd_multicast(struct subcast_conn *c, const rimeaddr_t *group,
     
 int subcast_send_single_hop_broadcast(struct subcast_conn *c, 
     const uint8_t header);
+
+/* Sequence number for a packet this node originates but does not send 
+ * through subcast_send_*, e.g. as a record of an aggregate frame. */
+int16_t subcast_next_seq_no(void);
 #endif /* __SUBCAST_H__ */
 
 
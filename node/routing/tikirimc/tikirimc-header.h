@@ -28,6 +28,10 @@ enum{
   PKT_MCAST_GROUP_CREATED = 0x0B,
   PKT_MCAST_GROUP_REMOVED = 0x0C,
   PKT_MCAST_GROUP_INVITED = 0x0D,
+  PKT_SRT_SUMMARY = 0x0E,
+  PKT_APPLICATION_LEVEL_AGG = 0x0F,
+  PKT_RTABLE_DELTA = 0x10,
+  PKT_RTABLE_ACK = 0x11,
 };
 
 enum{
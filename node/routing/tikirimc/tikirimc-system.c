@@ -1,4 +1,6 @@
 #include "tikirimc-system.h"
+#include "rtable.h"
+#include "agg.h"
 
 #include "dev/serial-line.h"
 #include "dev/leds.h"
@@ -29,15 +31,31 @@ static const struct packetbuf_attrlist attributes[] =
   };
   
 
-typedef struct routing_entry {
-  struct routing_entry * next;
+/* Routing entry as carried by PKT_ADD_NEW_DECENDENT, 
+ * PKT_DECENDENT_ENTRY_REFRESH and PKT_RTABLE_DELTA messages. */
+typedef struct routing_msg {
   rimeaddr_t node_addr;
   uint8_t relation;
   rimeaddr_t next_hop_addr;
   uint16_t hop_count;
   uint16_t beacon_value;
-  struct ctimer ctimer;
-} routing_entry; 
+} routing_msg;
+
+/* Header of a PKT_RTABLE_DELTA message. It is followed by nentries 
+ * routing_msg and nremoved addresses of entries the sender no longer has. 
+ * A full refresh lists every child of the sender in one or more packets, 
+ * numbered from 0 in the upper bits of flags; the receiver drops the 
+ * children via the sender that the refresh did not list. */
+typedef struct rtable_delta_hdr {
+  uint8_t version;
+  uint8_t flags;
+  uint8_t nentries;
+  uint8_t nremoved;
+} rtable_delta_hdr;
+
+#define RTABLE_DELTA_FULL 0x01
+#define RTABLE_DELTA_LAST 0x02
+#define RTABLE_DELTA_INDEX_SHIFT 4
 
 typedef struct seq_entry {
 	struct seq_entry * next;
@@ -62,11 +80,12 @@ enum {
 	REL_ROOT,
 	REL_PARENT_REFUCED,
 	REL_MCAST_GROUP,
+	REL_SINK,
 };
 
 static const char* relation_arr[] = {"REL_NEIGHBOUR", "REL_CHILD", 
 		"REL_PARENT", "REL_DECENDANT", "REL_ROOT", "REL_PARENT_REFUCED", 
-		"REL_MCAST_GROUP"};
+		"REL_MCAST_GROUP", "REL_SINK"};
 
 static const rimeaddr_t broadcast_addr = {{255,255}};
 static rimeaddr_t mcast_groups[MAX_MULTICAST_GROUPS];
@@ -75,6 +94,17 @@ static uint8_t multicast_addr_no = 0;
 static uint16_t start_channel;
 
 static struct announcement beacon;
+
+/* The route to a sink group is its routing entry, hop_count being the cost. 
+ * Each group we know of also gets an announcement of our own cost. */
+typedef struct sink_group {
+  struct announcement a;
+  rimeaddr_t addr;
+  uint8_t used;
+  uint8_t member;
+} sink_group;
+
+static sink_group sink_groups[SINK_MAX_GROUPS];
 static struct subcast_conn control_conn;
 
 static uint8_t current_state = STATE_INIT;
@@ -84,12 +114,26 @@ static uint16_t current_beacon;
 //static routing_entry* parent_entry = NULL;
 static rimeaddr_t parent, parent_next, root_addr;
 
-LIST(routing_table);
-MEMB(routing_entry_mem, routing_entry, MAX_ROUTING_ENTRIES);
-
 LIST(seq_no_list);
 MEMB(seq_entry_mem, seq_entry, MAX_SEQ_ENTRIES);
 
+/* Versioned routing table sync to the parent. Every change of a REL_CHILD 
+ * entry gets a new version and only entries newer than the version the 
+ * parent acknowledged are sent. */
+static uint8_t rtable_version, rtable_acked_version;
+static rimeaddr_t rtable_sync_parent;
+static rimeaddr_t rtable_removed[RTABLE_MAX_REMOVED];
+static uint8_t rtable_removed_version[RTABLE_MAX_REMOVED];
+static uint8_t rtable_removed_next;
+/* set when an unacknowledged removal was overwritten, only a full refresh 
+ * tells the parent about it then */
+static uint8_t rtable_force_full;
+/* full refresh being received, next is RTABLE_FULL_NONE when there is none 
+ * or a packet of it was missed */
+static rimeaddr_t rtable_full_source;
+static uint8_t rtable_full_version, rtable_full_next;
+#define RTABLE_FULL_NONE 0xFF
+
 uint8_t get_node_cost();
 uint16_t get_node_state();
 uint8_t get_no_of_root_nodes();
@@ -105,17 +149,29 @@ void calculate_values();
 void add_child_node(const rimeaddr_t *addr);
 uint8_t calculate_average_comm_cost();
 rimeaddr_t calculate_max_comm_cost();
-void add_decendent(routing_entry new);
-void refresh_decendent(routing_entry new);
+void add_decendent(routing_msg new);
+void refresh_decendent(routing_msg new);
 void send_routing_table_to_parent();
+void send_srt_summary_to_parent();
+static uint8_t children_unsummarised();
+void rtable_delta_received(const rimeaddr_t *source);
 rimeaddr_t* get_next_hop(const rimeaddr_t *dest);
 int update_seq_no(const rimeaddr_t *node, int16_t no);
 
-static void remove_routing_entry(void *n);
+static int add_mcast_group_entry(const rimeaddr_t *group);
+static void remove_routing_entry(routing_entry *e);
+static int rtable_unacked(uint8_t v);
+static void child_changed(routing_entry *e);
+static void rtable_clear_acked_removed();
 static void handle_parent_timeout(void *n);
 static void start_network(void *n);
 static void remove_seq_entry(void *n);
 
+static sink_group *find_sink_group(const rimeaddr_t *addr, int create);
+static int is_sink_member(const rimeaddr_t *addr);
+static void update_sink_beacons();
+static void received_sink_beacon(struct announcement *a, 
+		const rimeaddr_t *from, uint16_t id, uint16_t value);
 static void received_beacon(struct announcement *a, const rimeaddr_t *from,
           uint16_t id, uint16_t value);
 static void control_msg_received(struct subcast_conn *c, const rimeaddr_t *source, 
@@ -133,6 +189,96 @@ PROCESS(network_init_process, "TikiriMC Network Init Process");
 PROCESS(control_process, "TikiriMC Control Process");
 PROCESS(ui_process, "TikiriMC User Interface Process");
 
+/*---------------------------------------------------------------------------*/
+static int
+fwd_unicast(struct subcast_conn *sc, const rimeaddr_t *destination, 
+		const rimeaddr_t *next_hop, const rimeaddr_t *source, const uint8_t hops, 
+		const uint8_t ttl, const uint8_t header, const int16_t original_seq_no, 
+		const clock_time_t budget)
+{
+	if((header & MASK_PKT_BITS) == PKT_APPLICATION_LEVEL && 
+			agg_add(sc, destination, next_hop, source, hops, ttl, 
+					original_seq_no, budget)) {
+		return 1;
+	}
+	return subcast_fwd_unicast(sc, destination, next_hop, source, hops, ttl, 
+			header, original_seq_no);
+}
+/*---------------------------------------------------------------------------*/
+static void
+recv_unicast(struct tikirimc_system_conn *c, const rimeaddr_t *source, 
+		const rimeaddr_t *destination, const rimeaddr_t *next_hop, 
+		const uint8_t hops, const uint8_t ttl, const uint8_t header, 
+		const int16_t original_seq_no, const clock_time_t budget)
+{
+	struct subcast_conn *sc = &c->c;
+	uint8_t pkt_hdr;
+	
+	if(rimeaddr_cmp(destination, &rimeaddr_node_addr) || 
+			is_sink_member(destination)) {
+		if(update_seq_no(source, original_seq_no) == TRUE) {
+			c->u->recv(c, source);
+		}
+		return;
+	} else if(rimeaddr_cmp(next_hop, &rimeaddr_node_addr) || 
+			rimeaddr_cmp(next_hop, &broadcast_addr)) {
+		if(ttl <= 0) {
+			printf("DROPPED TTL\n");
+			return;
+		}
+		rimeaddr_t n = *get_next_hop(destination);
+		if(rimeaddr_cmp(&n, &rimeaddr_null)) {
+			if(current_state == STATE_ROOT) {
+				printf("Unicast Root TTL %d\n", ttl);
+				pkt_hdr = RT_ROOT_ONLY | CT_BROADCAST | 
+						PKT_APPLICATION_LEVEL_UCAST;
+				subcast_fwd_unicast(sc, destination, &broadcast_addr, source, 
+						hops + 1, ttl - 1, pkt_hdr, original_seq_no);
+			} else if(current_state == STATE_SUB_ROOT) {
+				printf("Unicast Sub-Root TTL %d\n", ttl);
+				fwd_unicast(sc, destination, &parent, source, hops + 1, 
+						ttl - 1, header, original_seq_no, budget);
+			} else if(current_state == STATE_LEAF) {
+				printf("Unicast Leaf TTL %d\n", ttl);
+				printf("DROPPED LEAF\n");
+				return;
+			} else {
+				printf("Unicast Init TTL %d\n", ttl);
+				subcast_fwd_unicast(sc, destination, &broadcast_addr, source, 
+						hops + 1, ttl - 1, header, original_seq_no);
+			}						
+		} else {
+			fwd_unicast(sc, destination, &n, source, hops + 1, ttl - 1, 
+					header, original_seq_no, budget);
+		}
+	}
+}
+/*---------------------------------------------------------------------------*/
+static void
+recv_aggregate(struct tikirimc_system_conn *c, const rimeaddr_t *destination, 
+		const rimeaddr_t *next_hop)
+{
+	static uint8_t frame[PACKETBUF_SIZE];
+	const uint8_t *pos, *end;
+	agg_record r;
+	
+	if(!rimeaddr_cmp(destination, &rimeaddr_node_addr) && 
+			!rimeaddr_cmp(next_hop, &rimeaddr_node_addr)) {
+		return;
+	}
+	
+	/* Every record is put back into packetbuf and handled like a unicast 
+	 * packet received from its original source. */
+	memcpy(frame, packetbuf_dataptr(), packetbuf_datalen());
+	end = frame + packetbuf_datalen();
+	for(pos = frame; agg_next_record(&pos, end, &r); ) {
+		packetbuf_clear();
+		packetbuf_copyfrom(r.data, r.len);
+		recv_unicast(c, &r.source, destination, &rimeaddr_node_addr, r.hops, 
+				r.ttl, RT_ALL_NODES | CT_UNICAST | PKT_APPLICATION_LEVEL, 
+				r.original_seq_no, r.budget);
+	}
+}
 /*---------------------------------------------------------------------------*/
 static void 
 recv_from_subcast(struct subcast_conn *sc, const rimeaddr_t *source, 
@@ -266,50 +412,49 @@ recv_from_subcast(struct subcast_conn *sc, const rimeaddr_t *source,
 		}
 		case CT_SUBTREE_BCAST:
 		{
-			printf("CT_SUBTREE_BCAST\n");
+			PRINTF("CT_SUBTREE_BCAST\n");
+			
+			srt_pred pred;
+			routing_entry *e;
+			
+			if(packetbuf_datalen() < sizeof(srt_pred)) {
+				PRINTF("DROPPED SHORT SUBTREE BCAST\n");
+				return;
+			}
+			memcpy(&pred, packetbuf_dataptr(), sizeof(srt_pred));
+			
+			/* Roots and nodes without a tree always forward. Others forward 
+			 * packets still travelling up the tree, and packets going down only 
+			 * if one of the child subtrees can match. */
+			e = rtable_lookup(last_hop);
+			srt_set_unknown(children_unsummarised());
+			if(ttl > 0 && (current_state == STATE_ROOT || 
+					current_state == STATE_INIT || 
+					(e != NULL && e->relation == REL_CHILD) || 
+					srt_match_children(&pred))) {
+				subcast_fwd_broadcast(sc, source, hops + 1, ttl - 1, header, 
+						original_seq_no);
+			} else {
+				PRINTF("SUBTREE BCAST PRUNED\n");
+			}
+			
+			if(srt_match_local(&pred) && 
+					update_seq_no(source, original_seq_no) == TRUE) {
+				packetbuf_hdrreduce(sizeof(srt_pred));
+				c->u->recv(c, source);
+			}
 			break;
 		}
 		case CT_UNICAST:
 		{
 			//PRINTF("CT_UNICAST\n");
 			
-			if(rimeaddr_cmp(destination, &rimeaddr_node_addr)) {
-				if(update_seq_no(source, original_seq_no) == TRUE) {
-					c->u->recv(c, source);
-				}
-				return;
-			} else if(rimeaddr_cmp(next_hop, &rimeaddr_node_addr) || 
-					rimeaddr_cmp(next_hop, &broadcast_addr)) {
-				if(ttl <= 0) {
-					printf("DROPPED TTL\n");
-					return;
-				}
-				rimeaddr_t n = *get_next_hop(destination);
-				if(rimeaddr_cmp(&n, &rimeaddr_null)) {
-					if(current_state == STATE_ROOT) {
-						printf("Unicast Root TTL %d\n", ttl);
-						pkt_hdr = RT_ROOT_ONLY | CT_BROADCAST | 
-								PKT_APPLICATION_LEVEL_UCAST;
-						subcast_fwd_unicast(sc, destination, &broadcast_addr, source, 
-								hops + 1, ttl - 1, pkt_hdr, original_seq_no);
-					} else if(current_state == STATE_SUB_ROOT) {
-						printf("Unicast Sub-Root TTL %d\n", ttl);
-						subcast_fwd_unicast(sc, destination, &parent, source, hops + 1, 
-								ttl - 1, header, original_seq_no);
-					} else if(current_state == STATE_LEAF) {
-						printf("Unicast Leaf TTL %d\n", ttl);
-						printf("DROPPED LEAF\n");
-						return;
-					} else {
-						printf("Unicast Init TTL %d\n", ttl);
-						subcast_fwd_unicast(sc, destination, &broadcast_addr, source, 
-								hops + 1, ttl - 1, header, original_seq_no);
-					}						
-				} else {
-					subcast_fwd_unicast(sc, destination, &n, source, hops + 1, ttl - 1, 
-							header, original_seq_no);
-				}
-			}			
+			if((header & MASK_PKT_BITS) == PKT_APPLICATION_LEVEL_AGG) {
+				recv_aggregate(c, destination, next_hop);
+			} else {
+				recv_unicast(c, source, destination, next_hop, hops, ttl, header, 
+						original_seq_no, AGG_DEFAULT_BUDGET);
+			}
 			break;
 		}
 		default:
@@ -332,12 +477,14 @@ void tikirimc_system_open(struct tikirimc_system_conn *c, uint16_t channel,
   ui_init();
   control_init();
   subcast_open(&c->c, channel, &routing_call);
+  agg_init();
   c->u = u;
 	channel_set_attributes(start_channel, attributes);
 }
 /*---------------------------------------------------------------------------*/
 void tikirimc_system_close(struct tikirimc_system_conn *c)
 {
+	agg_flush_all();
 	subcast_close(&c->c);
 }
 /*---------------------------------------------------------------------------*/
@@ -351,7 +498,41 @@ tikirimc_system_send_broadcast(struct tikirimc_system_conn *c)
 }
 /*---------------------------------------------------------------------------*/
 int 
+tikirimc_system_send_srt_broadcast(struct tikirimc_system_conn *c, 
+		const srt_pred *pred)
+{
+	uint8_t pkt_hdr = RT_ALL_NODES | CT_SUBTREE_BCAST | 
+			PKT_APPLICATION_LEVEL_BCAST;
+	
+	if(packetbuf_hdralloc(sizeof(srt_pred)) == 0) {
+		return 0;
+	}
+	memcpy(packetbuf_hdrptr(), pred, sizeof(srt_pred));
+	return subcast_send_broadcast(&c->c, MAX_TTL, pkt_hdr);
+}
+/*---------------------------------------------------------------------------*/
+int 
 tikirimc_system_send_unicast(struct tikirimc_system_conn *c, const rimeaddr_t *dest)
+{
+	return tikirimc_system_send_unicast_within(c, dest, 0);
+}
+/*---------------------------------------------------------------------------*/
+/* Sends to next_hop, through the aggregation of agg.c while the packet has 
+ * a budget to spend. */
+static void
+send_unicast_via(struct tikirimc_system_conn *c, const rimeaddr_t *dest, 
+		const rimeaddr_t *next_hop, uint8_t pkt_hdr, clock_time_t budget)
+{
+	if(budget > 0 && agg_add(&c->c, dest, next_hop, &rimeaddr_node_addr, 0, 
+			MAX_TTL, subcast_next_seq_no(), budget)) {
+		return;
+	}
+	subcast_send_unicast(&c->c, dest, next_hop, MAX_TTL, pkt_hdr);
+}
+/*---------------------------------------------------------------------------*/
+int 
+tikirimc_system_send_unicast_within(struct tikirimc_system_conn *c, 
+		const rimeaddr_t *dest, clock_time_t budget)
 {
 	uint8_t pkt_hdr = RT_ALL_NODES | CT_UNICAST | PKT_APPLICATION_LEVEL;
 	PRINTF("Tikirimc system send unicast\n");
@@ -363,15 +544,15 @@ tikirimc_system_send_unicast(struct tikirimc_system_conn *c, const rimeaddr_t *d
 			pkt_hdr = RT_ROOT_ONLY | CT_BROADCAST | PKT_APPLICATION_LEVEL_UCAST;
 			subcast_send_unicast(&c->c, dest, &broadcast_addr, MAX_TTL, pkt_hdr);
 		} else if(current_state == STATE_SUB_ROOT) {
-			subcast_send_unicast(&c->c, dest, &parent, MAX_TTL, pkt_hdr);
+			send_unicast_via(c, dest, &parent, pkt_hdr, budget);
 		} else if(current_state == STATE_LEAF) {
-			subcast_send_unicast(&c->c, dest, &parent, MAX_TTL, pkt_hdr);
+			send_unicast_via(c, dest, &parent, pkt_hdr, budget);
 		} else {
 			PRINTF("rimeaddr_null + INIT = broadcast\n");
 			subcast_send_unicast(&c->c, dest, &broadcast_addr, MAX_TTL, pkt_hdr);
 		}						
 	} else {
-		subcast_send_unicast(&c->c, dest, &n, MAX_TTL, pkt_hdr);
+		send_unicast_via(c, dest, &n, pkt_hdr, budget);
 	}
 	
   return 0;
@@ -381,16 +562,7 @@ int
 tikirimc_system_send_multicast(struct tikirimc_system_conn *c, 
 		const rimeaddr_t *group)
 {		
-	routing_entry *e;
-	
-	for(e = list_head(routing_table); e!= NULL; e=e->next) {
-		if(rimeaddr_cmp(group, &e->node_addr)) {
-			//ctimer(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
-			break;
-		}
-	}
-	
-	if(e == NULL) {
+	if(rtable_lookup(group) == NULL) {
 		return 0;
 	}
 	uint8_t pkt_hdr = RT_ALL_NODES | CT_MULTICAST | PKT_APPLICATION_LEVEL;
@@ -404,24 +576,7 @@ tikirimc_system_create_multicast_group(struct tikirimc_system_conn *c)
 	mcast_addr.u8[0] = rimeaddr_node_addr.u8[0];
 	mcast_addr.u8[1] = ++multicast_addr_no;
 	
-	routing_entry *e;
-	
-	for(e = list_head(routing_table); e!= NULL; e=e->next) {
-		if(rimeaddr_cmp(&mcast_addr, &e->node_addr)) {
-			ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
-			break;
-		}
-	}
-	
-	if(e == NULL) {
-		e = memb_alloc(&routing_entry_mem);
-		rimeaddr_copy(&e->node_addr, &mcast_addr);
-		rimeaddr_copy(&e->next_hop_addr, &mcast_addr);
-		e->hop_count = MAX_TTL;
-		e->relation = REL_MCAST_GROUP;
-		list_add(routing_table, e);
-		ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
-	} else {
+	if(add_mcast_group_entry(&mcast_addr) <= 0) {
 		//mcast_addr tikirimc_system_create_multicast_group(c);
 		return rimeaddr_null;
 	}
@@ -441,24 +596,7 @@ int
 tikirimc_system_join_multicast_group(struct tikirimc_system_conn *c, 
 		const rimeaddr_t *group)
 {
-  routing_entry *e;
-	
-	for(e = list_head(routing_table); e!= NULL; e=e->next) {
-		if(rimeaddr_cmp(group, &e->node_addr)) {
-			ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
-			break;
-		}
-	}
-	
-	if(e == NULL) {
-		e = memb_alloc(&routing_entry_mem);
-		rimeaddr_copy(&e->node_addr, group);
-		rimeaddr_copy(&e->next_hop_addr, group);
-		e->hop_count = MAX_TTL;
-		e->relation = REL_MCAST_GROUP;
-		list_add(routing_table, e);
-		ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
-	} else {
+	if(add_mcast_group_entry(group) <= 0) {
 		//mcast_addr tikirimc_system_create_multicast_group(c);
 		return 0;
 	}
@@ -504,6 +642,30 @@ tikirimc_system_remove_multicast_group(struct tikirimc_system_conn *c,
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+int 
+tikirimc_system_join_sink_group(uint8_t group)
+{
+	sink_group *g;
+	routing_entry *e;
+	rimeaddr_t addr;
+	
+	addr.u8[0] = SINK_GROUP_PREFIX;
+	addr.u8[1] = group;
+	g = find_sink_group(&addr, TRUE);
+	if(g == NULL) {
+		return 0;
+	}
+	g->member = TRUE;
+	
+	/* A member never routes results of its own group to another sink. */
+	e = rtable_lookup(&addr);
+	if(e != NULL && e->relation == REL_SINK) {
+		remove_routing_entry(e);
+	}
+	update_sink_beacons();
+	return 1;
+}
+/*---------------------------------------------------------------------------*/
 
 static void
 control_msg_received(struct subcast_conn *c, const rimeaddr_t *source, 
@@ -593,49 +755,66 @@ control_msg_received(struct subcast_conn *c, const rimeaddr_t *source,
 				{
 					PRINTF("PKT_ADD_NEW_DECENDENT\n");
 					
-					routing_entry new = *(routing_entry *)packetbuf_dataptr();
+					routing_msg new;
+					memcpy(&new, packetbuf_dataptr(), sizeof(routing_msg));
 					add_decendent(new);
 					
 					break;
 				}
+				case PKT_SRT_SUMMARY:
+				{
+					PRINTF("PKT_SRT_SUMMARY\n");
+					
+					if(rimeaddr_cmp(destination, &rimeaddr_node_addr) && 
+							packetbuf_datalen() >= sizeof(srt_range) && 
+							rtable_lookup(source) != NULL) {
+						srt_range range;
+						memcpy(&range, packetbuf_dataptr(), sizeof(srt_range));
+						srt_update_child(source, &range);
+					}
+					
+					break;
+				}
 				case PKT_DECENDENT_ENTRY_REFRESH:
 				{
 					PRINTF("PKT_DECENDENT_ENTRY_REFRESH\n");
 					
-					routing_entry new = *(routing_entry *)packetbuf_dataptr();
+					routing_msg new;
+					memcpy(&new, packetbuf_dataptr(), sizeof(routing_msg));
 					refresh_decendent(new);
 					
 					break;
 				}
+				case PKT_RTABLE_DELTA:
+				{
+					PRINTF("PKT_RTABLE_DELTA\n");
+					
+					if(rimeaddr_cmp(destination, &rimeaddr_node_addr)) {
+						rtable_delta_received(source);
+					}
+					break;
+				}
+				case PKT_RTABLE_ACK:
+				{
+					uint8_t v = *(uint8_t *)packetbuf_dataptr();
+					
+					PRINTF("PKT_RTABLE_ACK %d\n", v);
+					/* Ignore acks older than the one we already have. */
+					if(rimeaddr_cmp(source, &parent) && 
+							(uint8_t)(rtable_version - v) < 
+							(uint8_t)(rtable_version - rtable_acked_version)) {
+						rtable_acked_version = v;
+						rtable_clear_acked_removed();
+					}
+					break;
+				}
 				case PKT_MCAST_GROUP_CREATED:
 				{
 						PRINTF("PKT_MCAST_GROUP_CREATED %d.%d\n", 
 								((rimeaddr_t *)packetbuf_dataptr())->u8[0], 
 								((rimeaddr_t *)packetbuf_dataptr())->u8[1]);
 								
-						routing_entry *e;
-	
-						for(e = list_head(routing_table); e!= NULL; e=e->next) {
-							if(rimeaddr_cmp(((rimeaddr_t *)packetbuf_dataptr()), 
-									&e->node_addr)) {
-								ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-										remove_routing_entry, e);
-								break;
-							}
-						}
-						
-						if(e == NULL) {
-							e = memb_alloc(&routing_entry_mem);
-							rimeaddr_copy(&e->node_addr, 
-									((rimeaddr_t *)packetbuf_dataptr()));
-							rimeaddr_copy(&e->next_hop_addr, 
-									((rimeaddr_t *)packetbuf_dataptr()));
-							e->hop_count = MAX_TTL;
-							e->relation = REL_MCAST_GROUP;
-							list_add(routing_table, e);
-							ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-									remove_routing_entry, e);
-						}
+						add_mcast_group_entry((rimeaddr_t *)packetbuf_dataptr());
 						
 						pkt_hdr = RT_ALL_NODES | CT_UNICAST | PKT_MCAST_GROUP_CREATED;
 						packetbuf_copyfrom((rimeaddr_t *)packetbuf_dataptr(), 
@@ -653,29 +832,7 @@ control_msg_received(struct subcast_conn *c, const rimeaddr_t *source,
 								((rimeaddr_t *)packetbuf_dataptr())->u8[0], 
 								((rimeaddr_t *)packetbuf_dataptr())->u8[1]);
 								
-						routing_entry *e;
-	
-						for(e = list_head(routing_table); e!= NULL; e=e->next) {
-							if(rimeaddr_cmp(((rimeaddr_t *)packetbuf_dataptr()), 
-									&e->node_addr)) {
-								ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-										remove_routing_entry, e);
-								break;
-							}
-						}
-						
-						if(e == NULL) {
-							e = memb_alloc(&routing_entry_mem);
-							rimeaddr_copy(&e->node_addr, 
-									((rimeaddr_t *)packetbuf_dataptr()));
-							rimeaddr_copy(&e->next_hop_addr, 
-									((rimeaddr_t *)packetbuf_dataptr()));
-							e->hop_count = MAX_TTL;
-							e->relation = REL_MCAST_GROUP;
-							list_add(routing_table, e);
-							ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-									remove_routing_entry, e);
-						}
+						add_mcast_group_entry((rimeaddr_t *)packetbuf_dataptr());
 						
 						pkt_hdr = RT_ALL_NODES | CT_UNICAST | PKT_MCAST_GROUP_CREATED;
 						packetbuf_copyfrom((rimeaddr_t *)packetbuf_dataptr(), 
@@ -773,29 +930,7 @@ control_msg_received(struct subcast_conn *c, const rimeaddr_t *source,
 								((rimeaddr_t *)packetbuf_dataptr())->u8[0], 
 								((rimeaddr_t *)packetbuf_dataptr())->u8[1]);
 								
-								routing_entry *e;
-			
-								for(e = list_head(routing_table); e!= NULL; e=e->next) {
-									if(rimeaddr_cmp(((rimeaddr_t *)packetbuf_dataptr()), 
-											&e->node_addr)) {
-										ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-												remove_routing_entry, e);
-										break;
-									}
-								}
-								
-								if(e == NULL) {
-									e = memb_alloc(&routing_entry_mem);
-									rimeaddr_copy(&e->node_addr, 
-											((rimeaddr_t *)packetbuf_dataptr()));
-									rimeaddr_copy(&e->next_hop_addr, 
-											((rimeaddr_t *)packetbuf_dataptr()));
-									e->hop_count = MAX_TTL;
-									e->relation = REL_MCAST_GROUP;
-									list_add(routing_table, e);
-									ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, 
-											remove_routing_entry, e);
-								}
+								add_mcast_group_entry((rimeaddr_t *)packetbuf_dataptr());
 								
 								pkt_hdr = RT_ALL_NODES | CT_UNICAST | PKT_MCAST_GROUP_CREATED;
 								packetbuf_copyfrom((rimeaddr_t *)packetbuf_dataptr(), 
@@ -879,29 +1014,80 @@ received_beacon(struct announcement *a, const rimeaddr_t *from,
             from->u8[0], from->u8[1],
             cost, state_ch, comm_cost);
             
-  for(e=list_head(routing_table); e != NULL; e = e->next) {
-    PRINTF("Inside list for %d.%d\n", e->node_addr.u8[0], e->node_addr.u8[1]);
-    if(rimeaddr_cmp(from, &e->node_addr)) {
-      rimeaddr_copy(&e->next_hop_addr, from);
-      e->hop_count = 1;
-      e->beacon_value = value;
-      ctimer_set(&e->ctimer, ROUTING_ENTRY_TIMEOUT, remove_routing_entry, e);
-      return;
-    }
+  e = rtable_lookup(from);
+  if(e != NULL) {
+    rimeaddr_copy(&e->next_hop_addr, from);
+    e->hop_count = 1;
+    e->beacon_value = value;
+    rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
+    return;
   }
   
-  e = memb_alloc(&routing_entry_mem);
+  e = rtable_add(from);
   
   if(e != NULL) {
     PRINTF("Creating entry for %d.%d\n", from->u8[0], from->u8[1]);
-    rimeaddr_copy(&e->node_addr, from);
     rimeaddr_copy(&e->next_hop_addr, from);
     e->hop_count = 1;
     e->beacon_value = value;
     e->relation = REL_NEIGHBOUR;
-    list_add(routing_table, e);
-    ctimer_set(&e->ctimer, ROUTING_ENTRY_TIMEOUT, remove_routing_entry, e);
+    rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+
+/* The value of a sink announcement is the group id in the high byte and the 
+ * sender's hop count to the nearest sink of that group in the low byte. */
+static void
+received_sink_beacon(struct announcement *a, const rimeaddr_t *from,
+          uint16_t id, uint16_t value)
+{
+  rimeaddr_t addr;
+  uint8_t cost = value & 0xFF;
+  sink_group *g;
+  routing_entry *e;
+  
+  addr.u8[0] = SINK_GROUP_PREFIX;
+  addr.u8[1] = value >> 8;
+  
+  PRINTF("%d.%d: Sink group %d is %d hops from %d.%d\n",
+            rimeaddr_node_addr.u8[0], rimeaddr_node_addr.u8[1],
+            addr.u8[1], cost, from->u8[0], from->u8[1]);
+  
+  e = rtable_lookup(&addr);
+  if(e != NULL && e->relation != REL_SINK) {
+    return;
   }
+  
+  if(cost >= MAX_TTL - 1) {
+    /* Our next hop lost its route, drop ours instead of waiting for the 
+     * timeout so the next announcement of another neighbour is taken. */
+    if(e != NULL && rimeaddr_cmp(&e->next_hop_addr, from)) {
+      remove_routing_entry(e);
+    }
+    return;
+  }
+  cost++;
+  
+  g = find_sink_group(&addr, TRUE);
+  if(g == NULL || g->member) {
+    return;
+  }
+  
+  if(e == NULL) {
+    e = rtable_add(&addr);
+    if(e == NULL) {
+      return;
+    }
+    e->relation = REL_SINK;
+  } else if(!rimeaddr_cmp(&e->next_hop_addr, from) && cost >= e->hop_count) {
+    return;
+  }
+  
+  rimeaddr_copy(&e->next_hop_addr, from);
+  e->hop_count = cost;
+  rtable_set_timeout(e, SINK_ENTRY_TIMEOUT);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -915,8 +1101,9 @@ PROCESS_THREAD(beacon_process, ev, data)
   //static uint16_t beacon_value; 
   static struct etimer et;
   
-  memb_init(&routing_entry_mem);
-  list_init(routing_table);
+  rtable_init(remove_routing_entry);
+  srt_init();
+  rtable_full_next = RTABLE_FULL_NONE;
   
   memb_init(&seq_entry_mem);
   list_init(seq_no_list);
@@ -941,6 +1128,7 @@ PROCESS_THREAD(beacon_process, ev, data)
     announcement_listen(1);
     calculate_values();
     announcement_set_value(&beacon, get_node_beacon_value());
+    update_sink_beacons();
   }
   
   PROCESS_END();
@@ -1002,7 +1190,7 @@ PROCESS_THREAD(ui_process, ev, data)
     } else if(strcmp((char *)data, "rtable") == 0) {
       routing_entry *e;
       printf("~#~#~#~#~#~Routing Table~#~#~#~#~#~\n");
-      for(e = list_head(routing_table); e != NULL; e = e->next) {
+      for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
         printf("%d.%d via %d.%d, Relation = %s, hops = %d, "
 						"beacon_value = %04X\n",
 						e->node_addr.u8[0], e->node_addr.u8[1],
@@ -1013,6 +1201,14 @@ PROCESS_THREAD(ui_process, ev, data)
 						e->hop_count, e->beacon_value);
       }
 			continue;
+    } else if(strcmp((char *)data, "srt") == 0) {
+      const srt_range *r = srt_subtree_range();
+      uint8_t i;
+      printf("~#~#~#~#~#~Subtree Range~#~#~#~#~#~\n");
+      for(i = 0; i < SRT_NUM_ATTRS; i++) {
+        printf("attr %d: %u - %u\n", i, r->min[i], r->max[i]);
+      }
+      continue;
     } else if(strcmp((char *)data, "initN") == 0) {
 			printf("Start Network Init Process\n");
       network_init();
@@ -1020,7 +1216,7 @@ PROCESS_THREAD(ui_process, ev, data)
     } else {
         printf("Invalid input\n");
         printf("Possible inputs are, cost, state, roots, beacon, rtable, "
-						"initN\n");
+						"srt, initN\n");
 				continue;
     }
   }
@@ -1060,7 +1256,7 @@ PROCESS_THREAD(control_process, ev, data)
       
       max = NULL;
       
-      for(e = list_head(routing_table); e != NULL; e = e->next) {
+      for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
 				if(get_state_from_beacon(e->beacon_value) != STATE_INIT){					
 					if(max == NULL) {
 						max = e;
@@ -1095,6 +1291,7 @@ PROCESS_THREAD(control_process, ev, data)
       leds_off(LEDS_RED+LEDS_GREEN+LEDS_BLUE);
       leds_on(LEDS_GREEN);
       start_network_counter = START_NETWORK_COUNTER_VALUE;
+      send_srt_summary_to_parent();
       continue;
     } else if(current_state == STATE_ROOT) {
       PRINTF("Root state\n");
@@ -1159,7 +1356,11 @@ void calculate_values()
   
   res_cost = (uint16_t)node_cost;
   
-  for(e=list_head(routing_table); e != NULL; e = e->next) {
+  for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
+     /* Sink group routes are not neighbours. */
+     if(e->relation == REL_SINK) {
+       continue;
+     }
      if(get_state_from_beacon(e->beacon_value) == (uint8_t)STATE_INIT) {
        comm_cost += COMM_COST_INIT_WEIGHT;
      } else if(get_state_from_beacon(e->beacon_value) == (uint8_t)STATE_LEAF) {
@@ -1247,9 +1448,8 @@ void network_init()
 /*---------------------------------------------------------------------------*/
 
 static void
-remove_routing_entry(void *n)
+remove_routing_entry(routing_entry *e)
 {
-  routing_entry *e = n;
   rimeaddr_t temp;
   
   rimeaddr_copy(&temp, &e->node_addr);
@@ -1257,8 +1457,17 @@ remove_routing_entry(void *n)
   PRINTF("Removing routing entry for %d.%d\n", 
           e->node_addr.u8[0], e->node_addr.u8[1]);
   
-  list_remove(routing_table, e);
-  memb_free(&routing_entry_mem, e);
+  if(e->relation == REL_CHILD) {
+    if(!rimeaddr_cmp(&rtable_removed[rtable_removed_next], &rimeaddr_null) && 
+        rtable_unacked(rtable_removed_version[rtable_removed_next])) {
+      rtable_force_full = 1;
+    }
+    rimeaddr_copy(&rtable_removed[rtable_removed_next], &temp);
+    rtable_removed_version[rtable_removed_next] = ++rtable_version;
+    rtable_removed_next = (rtable_removed_next + 1) % RTABLE_MAX_REMOVED;
+  }
+  rtable_remove(e);
+  srt_remove_child(&temp);
   
   if(rimeaddr_cmp(&temp, &parent)) {
 		rimeaddr_copy(&parent, &rimeaddr_null);
@@ -1274,7 +1483,7 @@ remove_routing_entry(void *n)
 		}
 	}
   
-  if(list_length(routing_table) <= 0) {
+  if(rtable_length() <= 0) {
 		rimeaddr_copy(&parent, &rimeaddr_null);
 		rimeaddr_copy(&parent_next, &rimeaddr_null);
 		current_state = STATE_INIT;
@@ -1306,7 +1515,7 @@ handle_parent_timeout(void *n)
       
 	max = NULL;
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
+	for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
 		if((get_state_from_beacon(e->beacon_value) == STATE_ROOT) || 
 				(get_state_from_beacon(e->beacon_value) == STATE_SUB_ROOT)){					
 			if(max == NULL) {
@@ -1362,17 +1571,13 @@ add_child_node(const rimeaddr_t *addr)
 {
 	routing_entry *e;
 	
-	for(e=list_head(routing_table); e != NULL; e = e->next) {
-    if(rimeaddr_cmp(addr, &e->node_addr)) {
-      e->relation = REL_CHILD;
-      ctimer_set(&e->ctimer, ROUTING_ENTRY_TIMEOUT, remove_routing_entry, e);
-      break;
-    }
-  }
-  
+	e = rtable_lookup(addr);
   if(e == NULL){
 		return;
 	}
+	e->relation = REL_CHILD;
+	child_changed(e);
+	rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
 	static uint8_t pkt_hdr;
 	if(get_comm_cost_from_beacon(e->beacon_value) > 
 			(get_comm_cost_from_beacon(get_node_beacon_value()) / 2)) {
@@ -1391,7 +1596,7 @@ add_child_node(const rimeaddr_t *addr)
 	
 	pkt_hdr = 0x00;
 	pkt_hdr = CT_UNICAST | PKT_ADD_NEW_DECENDENT;
-	routing_entry new;
+	routing_msg new;
 	rimeaddr_copy(&new.node_addr, &e->node_addr);
 	rimeaddr_copy(&new.next_hop_addr, &rimeaddr_node_addr);
 	new.beacon_value = e->beacon_value;
@@ -1399,7 +1604,7 @@ add_child_node(const rimeaddr_t *addr)
 	new.relation = REL_CHILD;
 	
 	packetbuf_clear();
-	packetbuf_copyfrom(&new, sizeof(routing_entry));
+	packetbuf_copyfrom(&new, sizeof(routing_msg));
 	subcast_send_unicast(&control_conn, &parent, &parent, new.hop_count + 1, 
 			pkt_hdr);
 }
@@ -1412,11 +1617,16 @@ calculate_average_comm_cost()
 	routing_entry *e, *max;
   uint32_t total = 0;
   uint8_t avg = 0;   
+  uint16_t n = 0;
   
-	max = list_head(routing_table);
+	max = rtable_head();
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
+	for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
 		PRINTF("Routing entry processing\n");
+		if(e->relation == REL_SINK) {
+			continue;
+		}
+		n++;
 		total += get_comm_cost_from_beacon(e->beacon_value);
 		if(get_comm_cost_from_beacon(max->beacon_value) < 
 				get_comm_cost_from_beacon(e->beacon_value)){
@@ -1425,7 +1635,10 @@ calculate_average_comm_cost()
 		PRINTF("RES_BITS %X, %d\n", get_comm_cost_from_beacon(e->beacon_value), 
 				get_comm_cost_from_beacon(e->beacon_value));
 	}
-	avg = (uint8_t)(total / list_length(routing_table));
+	if(n == 0) {
+		return 0;
+	}
+	avg = (uint8_t)(total / n);
 	
 	avg = avg + (get_comm_cost_from_beacon(max->beacon_value) - avg) * 7 / 8; //
 	
@@ -1439,9 +1652,9 @@ calculate_max_comm_cost()
 {
 	routing_entry *e, *max; 
   
-	max = list_head(routing_table);
+	max = rtable_head();
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
+	for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
 		PRINTF("Routing entry processing\n");
 		if(get_comm_cost_from_beacon(max->beacon_value) < 
 				get_comm_cost_from_beacon(e->beacon_value)){
@@ -1455,49 +1668,45 @@ calculate_max_comm_cost()
 }
 
 void
-add_decendent(routing_entry new)
+add_decendent(routing_msg new)
 {
 	routing_entry *e; 
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
-		PRINTF("Routing entry processing\n");
-		if(rimeaddr_cmp(&e->node_addr, &new.node_addr)){
-			e->hop_count = new.hop_count;
-			e->relation = REL_CHILD;
-			rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);
-			
-			if(current_state != STATE_ROOT) {
-				uint8_t pkt_hdr = 0x00;
-				pkt_hdr = CT_UNICAST | PKT_ADD_NEW_DECENDENT;
-				
-				rimeaddr_copy(&new.next_hop_addr, &rimeaddr_node_addr);
-				new.hop_count = new.hop_count + 1;
-			
-				packetbuf_clear();
-				packetbuf_copyfrom(&new, sizeof(routing_entry));
-				subcast_send_unicast(&control_conn, &parent, &parent, 
-						new.hop_count + 1, pkt_hdr);
-			}
+	e = rtable_lookup(&new.node_addr);
+	if(e != NULL) {
+		e->hop_count = new.hop_count;
+		e->relation = REL_CHILD;
+		child_changed(e);
+		rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);
+		
+		if(current_state != STATE_ROOT) {
+			uint8_t pkt_hdr = 0x00;
+			pkt_hdr = CT_UNICAST | PKT_ADD_NEW_DECENDENT;
 			
-			return;
-		}		
+			rimeaddr_copy(&new.next_hop_addr, &rimeaddr_node_addr);
+			new.hop_count = new.hop_count + 1;
+		
+			packetbuf_clear();
+			packetbuf_copyfrom(&new, sizeof(routing_msg));
+			subcast_send_unicast(&control_conn, &parent, &parent, 
+					new.hop_count + 1, pkt_hdr);
+		}
+		
+		return;
 	}
 	
-	if(e == NULL) {
-		e = memb_alloc(&routing_entry_mem);
-	}
+	e = rtable_add(&new.node_addr);
 	
 	if(e != NULL) {
 		e->hop_count = new.hop_count;
 		e->beacon_value = new.beacon_value;
 		e->relation = new.relation;
+		child_changed(e);
 		rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);
-		rimeaddr_copy(&e->node_addr, &new.node_addr);
-		list_add(routing_table, e);
 		if(e->relation == REL_MCAST_GROUP) {
-			ctimer_set(&e->ctimer, MULTICAST_GROUP_TIMEOUT, remove_routing_entry, e);
+			rtable_set_timeout(e, MULTICAST_GROUP_TIMEOUT);
 		} else {
-			ctimer_set(&e->ctimer, ROUTING_ENTRY_TIMEOUT, remove_routing_entry, e);
+			rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
 		}
 		if(current_state == STATE_SUB_ROOT) {
 			uint8_t pkt_hdr = 0x00;
@@ -1507,68 +1716,289 @@ add_decendent(routing_entry new)
 			new.hop_count = new.hop_count + 1;
 		
 			packetbuf_clear();
-			packetbuf_copyfrom(&new, sizeof(routing_entry));
+			packetbuf_copyfrom(&new, sizeof(routing_msg));
 			subcast_send_unicast(&control_conn, &parent, &parent, new.hop_count + 1, 
 					pkt_hdr);
 		}
 	}
 }
 
+/* Whether version v is newer than the one the parent acknowledged. */
+static int
+rtable_unacked(uint8_t v)
+{
+	return v != rtable_acked_version && (uint8_t)(v - rtable_acked_version) <= 
+			(uint8_t)(rtable_version - rtable_acked_version);
+}
+
+/* A child entry was added or changed: give it a new version and forget an 
+ * unacknowledged removal of it, which would remove it again at the parent. */
+static void
+child_changed(routing_entry *e)
+{
+	uint8_t i;
+	
+	e->version = ++rtable_version;
+	for(i = 0; i < RTABLE_MAX_REMOVED; i++) {
+		if(rimeaddr_cmp(&rtable_removed[i], &e->node_addr)) {
+			rimeaddr_copy(&rtable_removed[i], &rimeaddr_null);
+		}
+	}
+}
+
+/* Forget the removals the parent acknowledged. Their versions would fall 
+ * back into the unacknowledged window once rtable_version wraps. */
+static void
+rtable_clear_acked_removed()
+{
+	uint8_t i;
+	
+	for(i = 0; i < RTABLE_MAX_REMOVED; i++) {
+		if(!rtable_unacked(rtable_removed_version[i])) {
+			rimeaddr_copy(&rtable_removed[i], &rimeaddr_null);
+			rtable_removed_version[i] = rtable_acked_version;
+		}
+	}
+}
+
 void
 send_routing_table_to_parent()
 {
+	static uint8_t full_refresh_counter = 0;
 	routing_entry *e;
-	routing_entry new; 
+	routing_msg *msg;
+	rtable_delta_hdr *hdr;
+	uint8_t full = 0, pending = 0, index = 0, i;
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
-		PRINTF("Routing entry processing\n");
-		if(e->relation == REL_CHILD){
-			new.hop_count = e->hop_count + 1;
-			new.beacon_value = e->beacon_value;
-			new.relation = REL_CHILD;
-			rimeaddr_copy(&new.next_hop_addr, &rimeaddr_node_addr);
-			rimeaddr_copy(&new.node_addr, &e->node_addr);
-			
-			uint8_t pkt_hdr = 0x00;
-			pkt_hdr = CT_UNICAST | PKT_DECENDENT_ENTRY_REFRESH;
+	send_srt_summary_to_parent();
+	
+	if(!rimeaddr_cmp(&parent, &rtable_sync_parent)) {
+		rimeaddr_copy(&rtable_sync_parent, &parent);
+		full = 1;
+	}
+	if(++full_refresh_counter >= RTABLE_FULL_REFRESH || rtable_force_full) {
+		full = 1;
+	}
+	if(!full) {
+		if(rtable_version == rtable_acked_version) {
+			return;
+		}
+		for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
+			if(e->relation == REL_CHILD && rtable_unacked(e->version)) {
+				pending++;
+			}
+		}
+		if(pending > RTABLE_MAX_DELTA_ENTRIES || 
+				(uint8_t)(rtable_version - rtable_acked_version) > 127) {
+			full = 1;
+		}
+	}
+	if(full) {
+		full_refresh_counter = 0;
+		rtable_force_full = 0;
+	}
+	
+	/* A full refresh may take several packets, the parent only acks the 
+	 * last one. */
+	e = rtable_head();
+	do {
+		packetbuf_clear();
+		hdr = (rtable_delta_hdr *)packetbuf_dataptr();
+		hdr->version = rtable_version;
+		hdr->flags = full ? 
+				RTABLE_DELTA_FULL | (index++ << RTABLE_DELTA_INDEX_SHIFT) : 0;
+		hdr->nentries = 0;
+		hdr->nremoved = 0;
+		msg = (routing_msg *)(hdr + 1);
 		
-			packetbuf_clear();
-			packetbuf_copyfrom(&new, sizeof(routing_entry));
-			subcast_send_unicast(&control_conn, &parent, &parent, new.hop_count + 1, 
-					pkt_hdr);
-			
-		}		
+		for(; e != NULL && hdr->nentries < RTABLE_MAX_DELTA_ENTRIES; 
+				e = rtable_next(e)) {
+			if(e->relation != REL_CHILD || (!full && !rtable_unacked(e->version))) {
+				continue;
+			}
+			msg->hop_count = e->hop_count + 1;
+			msg->beacon_value = e->beacon_value;
+			msg->relation = REL_CHILD;
+			rimeaddr_copy(&msg->next_hop_addr, &rimeaddr_node_addr);
+			rimeaddr_copy(&msg->node_addr, &e->node_addr);
+			msg++;
+			hdr->nentries++;
+		}
+		
+		if(e == NULL) {
+			hdr->flags |= RTABLE_DELTA_LAST;
+			for(i = 0; i < RTABLE_MAX_REMOVED; i++) {
+				if(!rimeaddr_cmp(&rtable_removed[i], &rimeaddr_null) && 
+						rtable_unacked(rtable_removed_version[i])) {
+					rimeaddr_copy((rimeaddr_t *)msg + hdr->nremoved, &rtable_removed[i]);
+					hdr->nremoved++;
+				}
+			}
+		}
+		
+		PRINTF("Routing table version %d to parent, %d entries, %d removed%s\n", 
+				hdr->version, hdr->nentries, hdr->nremoved, full ? ", full" : "");
+		packetbuf_set_datalen(sizeof(rtable_delta_hdr) + 
+				hdr->nentries * sizeof(routing_msg) + 
+				hdr->nremoved * sizeof(rimeaddr_t));
+		subcast_send_unicast(&control_conn, &parent, &parent, 1, 
+				CT_UNICAST | PKT_RTABLE_DELTA);
+	} while(e != NULL);
+}
+
+void
+rtable_delta_received(const rimeaddr_t *source)
+{
+	rtable_delta_hdr hdr;
+	routing_msg new;
+	rimeaddr_t addr;
+	routing_entry *e;
+	uint8_t *p = packetbuf_dataptr();
+	uint8_t i, index;
+	
+	if(packetbuf_datalen() < sizeof(rtable_delta_hdr)) {
+		return;
 	}
+	memcpy(&hdr, p, sizeof(rtable_delta_hdr));
+	if(packetbuf_datalen() < sizeof(rtable_delta_hdr) + 
+			hdr.nentries * sizeof(routing_msg) + hdr.nremoved * sizeof(rimeaddr_t)) {
+		PRINTF("Truncated routing table delta from %d.%d\n", source->u8[0], 
+				source->u8[1]);
+		return;
+	}
+	p += sizeof(rtable_delta_hdr);
+	
+	if(hdr.flags & RTABLE_DELTA_FULL) {
+		index = hdr.flags >> RTABLE_DELTA_INDEX_SHIFT;
+		if(index == 0) {
+			/* Every child via source is stale until the refresh lists it. */
+			for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
+				e->stale = e->relation == REL_CHILD && 
+						rimeaddr_cmp(&e->next_hop_addr, source);
+			}
+			rimeaddr_copy(&rtable_full_source, source);
+			rtable_full_version = hdr.version;
+			rtable_full_next = 1;
+		} else if(rtable_full_next == index && 
+				rtable_full_version == hdr.version && 
+				rimeaddr_cmp(&rtable_full_source, source)) {
+			rtable_full_next++;
+		} else {
+			/* Part of the refresh was lost, the next one purges instead. */
+			rtable_full_next = RTABLE_FULL_NONE;
+		}
+	}
+	
+	for(i = 0; i < hdr.nentries; i++, p += sizeof(routing_msg)) {
+		memcpy(&new, p, sizeof(routing_msg));
+		refresh_decendent(new);
+		e = rtable_lookup(&new.node_addr);
+		if(e != NULL) {
+			e->stale = 0;
+		}
+	}
+	for(i = 0; i < hdr.nremoved; i++, p += sizeof(rimeaddr_t)) {
+		memcpy(&addr, p, sizeof(rimeaddr_t));
+		e = rtable_lookup(&addr);
+		if(e != NULL && e->relation == REL_CHILD && 
+				rimeaddr_cmp(&e->next_hop_addr, source)) {
+			remove_routing_entry(e);
+		}
+	}
+	
+	if((hdr.flags & RTABLE_DELTA_FULL) && (hdr.flags & RTABLE_DELTA_LAST) && 
+			rtable_full_next != RTABLE_FULL_NONE && 
+			rimeaddr_cmp(&rtable_full_source, source)) {
+		for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
+			if(e->stale && e->relation == REL_CHILD && 
+					rimeaddr_cmp(&e->next_hop_addr, source)) {
+				PRINTF("%d.%d not in the full refresh from %d.%d\n", 
+						e->node_addr.u8[0], e->node_addr.u8[1], 
+						source->u8[0], source->u8[1]);
+				remove_routing_entry(e);
+			}
+		}
+		rtable_full_next = RTABLE_FULL_NONE;
+	}
+	
+	if(hdr.flags & RTABLE_DELTA_LAST) {
+		packetbuf_clear();
+		packetbuf_copyfrom(&hdr.version, sizeof(uint8_t));
+		subcast_send_unicast(&control_conn, source, source, 1, 
+				CT_UNICAST | PKT_RTABLE_ACK);
+	}
+}
+
+void
+send_srt_summary_to_parent()
+{
+	static uint8_t refresh_counter = 0;
+	
+	/* A child without a summary makes the whole subtree range unknown, so 
+	 * the parent does not prune it either. */
+	srt_set_unknown(children_unsummarised());
+	
+	/* Subtree ranges change rarely, so only send them when they did or once 
+	 * every SRT_SUMMARY_REFRESH control ticks. */
+	if(srt_subtree_changed() == 0 && ++refresh_counter < SRT_SUMMARY_REFRESH) {
+		return;
+	}
+	refresh_counter = 0;
+	
+	uint8_t pkt_hdr = CT_UNICAST | PKT_SRT_SUMMARY;
+	
+	packetbuf_clear();
+	packetbuf_copyfrom(srt_subtree_range(), sizeof(srt_range));
+	subcast_send_unicast(&control_conn, &parent, &parent, MAX_TTL, pkt_hdr);
+}
+
+/* Whether a child has not reported its subtree range yet, because it has
+ * not sent one since it joined or because there was no space for it. */
+static uint8_t
+children_unsummarised()
+{
+	routing_entry *e;
+	
+	for(e = rtable_head(); e != NULL; e = rtable_next(e)) {
+		/* decendents further down are covered by the child they are behind */
+		if(e->relation == REL_CHILD && 
+				rimeaddr_cmp(&e->next_hop_addr, &e->node_addr) && 
+				!srt_has_child(&e->node_addr)) {
+			return 1;
+		}
+	}
+	return 0;
 }
 
 void 
-refresh_decendent(routing_entry new)
+refresh_decendent(routing_msg new)
 {
 	routing_entry *e; 
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
-		PRINTF("Routing entry processing\n");
-		if(rimeaddr_cmp(&e->node_addr, &new.node_addr)){
-			e->hop_count = new.hop_count;
-			e->relation = REL_CHILD;
-			rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);			
+	e = rtable_lookup(&new.node_addr);
+	if(e != NULL) {
+		rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
+		if(e->relation == REL_CHILD && e->hop_count == new.hop_count && 
+				rimeaddr_cmp(&e->next_hop_addr, &new.next_hop_addr)) {
 			return;
-		}		
+		}
+		e->hop_count = new.hop_count;
+		e->relation = REL_CHILD;
+		child_changed(e);
+		rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);			
+		return;
 	}
 	
-	if(e == NULL) {
-		e = memb_alloc(&routing_entry_mem);
-	}
+	e = rtable_add(&new.node_addr);
 	
 	if(e != NULL) {
 		e->hop_count = new.hop_count;
 		e->beacon_value = new.beacon_value;
 		e->relation = REL_CHILD;
+		child_changed(e);
 		rimeaddr_copy(&e->next_hop_addr, &new.next_hop_addr);
-		rimeaddr_copy(&e->node_addr, &new.node_addr);
-		list_add(routing_table, e);
 		
-		ctimer_set(&e->ctimer, ROUTING_ENTRY_TIMEOUT, remove_routing_entry, e);
+		rtable_set_timeout(e, ROUTING_ENTRY_TIMEOUT);
 	}
 }
 
@@ -1577,16 +2007,39 @@ get_next_hop(const rimeaddr_t *dest)
 {
 	routing_entry *e; 
 	
-	for(e = list_head(routing_table); e != NULL; e = e->next) {
-		PRINTF("Routing entry processing\n");
-		if(rimeaddr_cmp(&e->node_addr, dest)){		
-			return &e->next_hop_addr;
-		}
+	e = rtable_lookup(dest);
+	if(e != NULL) {
+		return &e->next_hop_addr;
 	}
 	
 	return (&rimeaddr_null);
 }
 
+/* Create the routing entry of a multicast group, or restart its timeout if 
+ * it is already known. Returns 1 if a new entry was created, 0 if it was 
+ * refreshed and -1 if the routing table is full. */
+static int
+add_mcast_group_entry(const rimeaddr_t *group)
+{
+	routing_entry *e;
+	
+	e = rtable_lookup(group);
+	if(e != NULL) {
+		rtable_set_timeout(e, MULTICAST_GROUP_TIMEOUT);
+		return 0;
+	}
+	
+	e = rtable_add(group);
+	if(e == NULL) {
+		return -1;
+	}
+	rimeaddr_copy(&e->next_hop_addr, group);
+	e->hop_count = MAX_TTL;
+	e->relation = REL_MCAST_GROUP;
+	rtable_set_timeout(e, MULTICAST_GROUP_TIMEOUT);
+	return 1;
+}
+
 int
 update_seq_no(const rimeaddr_t *node, int16_t no)
 {
@@ -1624,3 +2077,67 @@ update_seq_no(const rimeaddr_t *node, int16_t no)
 	return FALSE;
 }
 			
+
+/* Find the sink group of addr, taking a free slot and registering its 
+ * announcement if create is set and the group is new. */
+static sink_group *
+find_sink_group(const rimeaddr_t *addr, int create)
+{
+	uint8_t i;
+	sink_group *free = NULL;
+	
+	for(i = 0; i < SINK_MAX_GROUPS; i++) {
+		if(!sink_groups[i].used) {
+			if(free == NULL) {
+				free = &sink_groups[i];
+			}
+		} else if(rimeaddr_cmp(&sink_groups[i].addr, addr)) {
+			return &sink_groups[i];
+		}
+	}
+	
+	if(!create || free == NULL) {
+		return NULL;
+	}
+	rimeaddr_copy(&free->addr, addr);
+	free->used = TRUE;
+	free->member = FALSE;
+	announcement_register(&free->a, SINK_BEACON_ID + (free - sink_groups), 
+			(addr->u8[1] << 8) | SINK_COST_UNREACHABLE, received_sink_beacon);
+	return free;
+}
+
+static int
+is_sink_member(const rimeaddr_t *addr)
+{
+	sink_group *g;
+	
+	if(addr->u8[0] != SINK_GROUP_PREFIX) {
+		return FALSE;
+	}
+	g = find_sink_group(addr, FALSE);
+	return g != NULL && g->member;
+}
+
+/* Announce our current cost to every known sink group. */
+static void
+update_sink_beacons()
+{
+	uint8_t i, cost;
+	routing_entry *e;
+	
+	for(i = 0; i < SINK_MAX_GROUPS; i++) {
+		if(!sink_groups[i].used) {
+			continue;
+		}
+		if(sink_groups[i].member) {
+			cost = 0;
+		} else {
+			e = rtable_lookup(&sink_groups[i].addr);
+			cost = (e != NULL && e->relation == REL_SINK) ? e->hop_count : 
+					SINK_COST_UNREACHABLE;
+		}
+		announcement_set_value(&sink_groups[i].a, 
+				(sink_groups[i].addr.u8[1] << 8) | cost);
+	}
+}
@@ -9,9 +9,15 @@
 #include "config.h"
 #include "subcast.h"
 #include "tikirimc-header.h"
+#include "srt.h"
+/* SINK_GROUP_PREFIX, shared with the query root addresses of tikiridb */
+#include "messages.h"
 
 
 #define BEACON_ID 200
+/* Sink groups announce their cost on SINK_BEACON_ID, SINK_BEACON_ID + 1, ... */
+#define SINK_BEACON_ID 201
+
 #define CHANNEL 150
 
 struct tikirimc_system_conn;
@@ -34,9 +40,15 @@ void tikirimc_system_close(struct tikirimc_system_conn *c);
 
 int tikirimc_system_send_broadcast(struct tikirimc_system_conn *c);
 
+int tikirimc_system_send_srt_broadcast(struct tikirimc_system_conn *c, 
+    const srt_pred *pred);
+
 int tikirimc_system_send_unicast(struct tikirimc_system_conn *c, 
     const rimeaddr_t *dest);
 
+int tikirimc_system_send_unicast_within(struct tikirimc_system_conn *c, 
+    const rimeaddr_t *dest, clock_time_t budget);
+
 int tikirimc_system_send_multicast(struct tikirimc_system_conn *c, 
     const rimeaddr_t *group);
 
@@ -55,6 +67,8 @@ int tikirimc_system_leave_multicast_group(struct tikirimc_system_conn *c,
 int tikirimc_system_remove_multicast_group(struct tikirimc_system_conn *c, 
     const rimeaddr_t *group);
 
+int tikirimc_system_join_sink_group(uint8_t group);
+
 /**
  * \brief       Initialize and start Beacon Process
  * 
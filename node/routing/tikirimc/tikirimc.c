@@ -40,12 +40,25 @@ tikirimc_send_broadcast(struct tikirimc_conn *c)
 }
 /*---------------------------------------------------------------------------*/
 int 
+tikirimc_send_srt_broadcast(struct tikirimc_conn *c, const srt_pred *pred)
+{
+  return tikirimc_system_send_srt_broadcast(&c->c, pred);
+}
+/*---------------------------------------------------------------------------*/
+int 
 tikirimc_send_unicast(struct tikirimc_conn *c, const rimeaddr_t *dest)
 {
   return tikirimc_system_send_unicast(&c->c, dest);
 }   
 /*---------------------------------------------------------------------------*/
 int 
+tikirimc_send_unicast_within(struct tikirimc_conn *c, const rimeaddr_t *dest,
+    clock_time_t budget)
+{
+  return tikirimc_system_send_unicast_within(&c->c, dest, budget);
+}
+/*---------------------------------------------------------------------------*/
+int 
 tikirimc_send_multicast(struct tikirimc_conn *c, const rimeaddr_t *group)
 {
   return tikirimc_system_send_multicast(&c->c, group);
@@ -82,3 +95,9 @@ tikirimc_remove_multicast_group(struct tikirimc_conn *c, const rimeaddr_t *group
   return tikirimc_system_remove_multicast_group(&c->c, group);
 }
 /*---------------------------------------------------------------------------*/
+int 
+tikirimc_join_sink_group(uint8_t group)
+{
+  return tikirimc_system_join_sink_group(group);
+}
+/*---------------------------------------------------------------------------*/
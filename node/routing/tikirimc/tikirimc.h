@@ -107,6 +107,19 @@ void tikirimc_open(struct tikirimc_conn *c, uint16_t channel,
  */
 int tikirimc_send_broadcast(struct tikirimc_conn *c); 
 
+/**
+ * \brief	Send a TikiriMC broadcast packet to the nodes matching a predicate
+ * \param c	The TikiriMC connection
+ * \param pred	Attribute ranges a node has to be in to receive the packet
+ * \retval	Non-zero if the packet could be sent. Zero otherwise.
+ * 			
+ * 			The packet is only forwarded into subtrees whose advertised 
+ * 			attribute ranges overlap pred, and only delivered on nodes whose 
+ * 			own attributes match it.
+ * 
+ */
+int tikirimc_send_srt_broadcast(struct tikirimc_conn *c, const srt_pred *pred);
+
 /**
  * \brief	Send a TikiriMC unicast packet
  * \param c	The TikiriMC connection
@@ -118,6 +131,23 @@ int tikirimc_send_broadcast(struct tikirimc_conn *c);
  */
 int tikirimc_send_unicast(struct tikirimc_conn *c, const rimeaddr_t *dest);   
 
+/**
+ * \brief	Send a TikiriMC unicast packet within a latency budget
+ * \param c	The TikiriMC connection
+ * \param dest	Address of the receiver
+ * \param budget	Time the packet may spend held for aggregation
+ * \retval	Non-zero if the packet could be sent. Zero otherwise.
+ * 			
+ * 			Small packets to the same destination are held and sent 
+ * 			together. The holds at this node and at every forwarder add up 
+ * 			to less than budget, so keep it within the latency the 
+ * 			application can accept, e.g. a fraction of the query epoch. A 
+ * 			budget of 0 sends the packet at once.
+ * 
+ */
+int tikirimc_send_unicast_within(struct tikirimc_conn *c, 
+		const rimeaddr_t *dest, clock_time_t budget);
+
 /**
  * \brief	Send a TikiriMC multicast packet
  * \param c	The TikiriMC connection
@@ -194,5 +224,17 @@ int tikirimc_leave_multicast_group(struct tikirimc_conn *c,
 int tikirimc_remove_multicast_group(struct tikirimc_conn *c, 
     const rimeaddr_t *group);
 
+/**
+ * \brief	Make this node a sink of a sink group
+ * \param group	Id of the sink group
+ * \retval	Non-zero if successfully joined. Zero otherwise.
+ * 			
+ * 			Every member announces itself as a sink of the group. Unicast 
+ * 			packets sent to {SINK_GROUP_PREFIX, group} are routed to the 
+ * 			member with the fewest hops from the sender.
+ * 
+ */
+int tikirimc_join_sink_group(uint8_t group);
+
 #endif /* __TIKIRIMC_H__ */
 /** @} */
@@ -40,8 +40,8 @@
 
 #include "tikiridb.h"
 #include "contiki.h"
-#include "routing.h"
 #include "qprocessor.h"
+#include "qtable.h"
 #include "packetizer.h"
 
 #define DEBUG 1
@@ -64,29 +64,171 @@
 #define ROUTING_CHANNEL 129
 #endif
 
+#if ROUTING_TIKIRIMC
+static void routing_recv(struct __routing_conn *c, const rimeaddr_t *from);
+#else
 static void routing_recv(struct routing_conn *c, const rimeaddr_t *from);
+#endif
 int qprocessor_send_data(const rimeaddr_t *receiver);
 
 static qprocessor_callbacks_t qprocessor_callbacks = {NULL, qprocessor_send_data};
+#if ROUTING_TIKIRIMC
+static struct __routing_conn routing_conn;
+static const struct __routing_callbacks routing_callbacks = {routing_recv};
+
+#define ADDRESS_ATTR_NONE 0xFF
+/* Attribute id of the node address, set by the platform. */
+static uint8_t address_attr = ADDRESS_ATTR_NONE;
+/* SRT predicate of the query being disseminated. */
+static srt_pred query_pred;
+
+/*
+ * The latency budget of the results of a query, 1/AGG_EPOCH_FRACTION of its
+ * epoch and never more than AGG_DELAY_MAX seconds. TikiriMC holds a result
+ * for aggregation on its way to the root for less than that in total.
+ */
+#ifdef CONF_AGG_EPOCH_FRACTION
+#define AGG_EPOCH_FRACTION CONF_AGG_EPOCH_FRACTION
+#else
+#define AGG_EPOCH_FRACTION 4
+#endif
+#define AGG_DELAY_MAX 30
+#else
 static struct routing_conn routing_conn;
 static const struct routing_callbacks routing_callbacks = {routing_recv};
+#endif
 
 PROCESS(tikiridb_process, "Tikiridb Process");
 
+#if ROUTING_TIKIRIMC
+/*---------------------------------------------------------------------------*/
+/*
+ * The latency budget of the result in packetbuf, from the epoch of its
+ * query, or 0 if it is not the result of a running SELECT query.
+ */
+static clock_time_t
+get_result_budget(const rimeaddr_t *receiver)
+{
+  message_header_t *message_header = packetbuf_dataptr();
+  qresult_header_t *qresult_header;
+  qtable_entry_t *qtable_entry;
+  rimeaddr_t qroot;
+  uint16_t epoch;
+
+  if(packetbuf_datalen() < sizeof(message_header_t) + sizeof(qresult_header_t) ||
+     message_header->type != MSG_QREPLY) {
+    return 0;
+  }
+  qresult_header = (qresult_header_t *)(message_header + 1);
+  /* results go to the root of their query, which names it with the qid */
+  rimeaddr_copy(&qroot, receiver);
+  qtable_entry = get_query_entry(qresult_header->qid, &qroot);
+  if(qtable_entry == NULL || qtable_entry->qtype != QTYPE_SELECT) {
+    return 0;
+  }
+  epoch = ntoh_leuint16(&((squery_data_t *)qtable_entry->qptr)->epoch_duration);
+  if(epoch > AGG_DELAY_MAX * AGG_EPOCH_FRACTION) {
+    epoch = AGG_DELAY_MAX * AGG_EPOCH_FRACTION;
+  }
+  return (clock_time_t)((uint32_t)epoch * CLOCK_SECOND / AGG_EPOCH_FRACTION);
+}
+#endif /* ROUTING_TIKIRIMC */
 /*---------------------------------------------------------------------------*/
 int 
 qprocessor_send_data(const rimeaddr_t *receiver)
 {
+#if ROUTING_TIKIRIMC
+  if(!rimeaddr_cmp(receiver, &rimeaddr_null)) {
+    return __routing_send_unicast_within(&routing_conn, receiver,
+                                         get_result_budget(receiver));
+  }
+  /* Queries only go down the subtrees that can match their WHERE clause. */
+  if(query_pred.attrs) {
+    return __routing_send_srt_broadcast(&routing_conn, &query_pred);
+  }
+  return __routing_send_broadcast(&routing_conn);
+#else
   //#Asanka: commented out the existing routing send function and added the new one.
   return routing_send(&routing_conn, receiver);
   //return routing_sendX(receiver);
+#endif
+
+}
+
+#if ROUTING_TIKIRIMC
+/*---------------------------------------------------------------------------*/
+void
+tikiridb_set_address_attr(uint8_t type)
+{
+  address_attr = type;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * The SELECT header of a query message of len bytes (without the message
+ * header), or NULL if it is not a complete SELECT query.
+ */
+static smessage_header_t *
+get_select_header(qmessage_header_t *qmessage_header, int len)
+{
+  smessage_header_t *smessage_header;
+
+  if(qmessage_header->qtype != QTYPE_SELECT) {
+    return NULL;
+  }
+  if(len < sizeof(qmessage_header_t) + sizeof(smessage_header_t)) {
+    return NULL;
+  }
+  smessage_header = (smessage_header_t *)(qmessage_header + 1);
+  if(len < sizeof(qmessage_header_t) + sizeof(smessage_header_t) +
+     smessage_header->nfields * sizeof(field_t) +
+     smessage_header->nexprs * sizeof(expression_t)) {
+    return NULL;
+  }
+  return smessage_header;
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Build the SRT predicate of a query from the WHERE clause terms on the
+ * node address. A node id range is only a hint to prune the tree, nodes
+ * still evaluate the full clause.
+ */
+static void
+set_query_pred(qmessage_header_t *qmessage_header, int len)
+{
+  smessage_header_t *smessage_header;
+  field_t *fields;
+  expression_t *exprs;
+  uint8_t i;
 
+  srt_pred_init(&query_pred);
 
+  smessage_header = get_select_header(qmessage_header, len);
+  if(smessage_header == NULL || address_attr == ADDRESS_ATTR_NONE) {
+    return;
+  }
+  fields = (field_t *)(smessage_header + 1);
+  exprs = (expression_t *)(fields + smessage_header->nfields);
+
+  for(i = 0; i < smessage_header->nexprs; i++) {
+    if(exprs[i].l_value_index >= smessage_header->nfields ||
+       fields[exprs[i].l_value_index].id != address_attr ||
+       exprs[i].op != EQ) {
+      continue;
+    }
+    srt_pred_restrict(&query_pred, SRT_ATTR_NODE_ID,
+                      (uint8_t)exprs[i].r_value.data_bytes[0],
+                      (uint8_t)exprs[i].r_value.data_bytes[0]);
+  }
 }
+#endif /* ROUTING_TIKIRIMC */
 
 /*---------------------------------------------------------------------------*/
 static void
+#if ROUTING_TIKIRIMC
+routing_recv(struct __routing_conn *c, const rimeaddr_t *from)
+#else
 routing_recv(struct routing_conn *c, const rimeaddr_t *from)
+#endif
 {
   if(qprocessor_callbacks.recv) {
     qprocessor_callbacks.recv(from);  
@@ -125,8 +267,18 @@ PROCESS_THREAD(tikiridb_process, ev, data)
     }
 
     qmessage_header = (qmessage_header_t *)((message_header_t *)data + 1);
-    // Set query root address to the node's address
+    // Set query root address to the node's address, unless the query
+    // names a sink group. The gateway hands such a query to every sink of
+    // the group, so this node joins the group and receives the results
+    // routed to it.
+#if ROUTING_TIKIRIMC
+    if(!is_sink_group(&qmessage_header->qroot) ||
+       !__routing_join_sink_group(qmessage_header->qroot.u8[1])) {
+      rimeaddr_copy(&qmessage_header->qroot, &rimeaddr_node_addr);
+    }
+#else
     rimeaddr_copy(&qmessage_header->qroot, &rimeaddr_node_addr);
+#endif
 
     //#Asanka: commented the packet buffer related functions and called something different
     packetbuf_clear();
@@ -135,6 +287,10 @@ PROCESS_THREAD(tikiridb_process, ev, data)
     packetbuf_copyfrom((char *)data, packet_length);
     //packetbuf_copyfrom("Hello", 6);
 
+#if ROUTING_TIKIRIMC
+    set_query_pred(qmessage_header, packet_length - sizeof(message_header_t));
+#endif
+
     qprocessor_send_data(&rimeaddr_null);
 
   }
@@ -144,14 +300,31 @@ PROCESS_THREAD(tikiridb_process, ev, data)
 void 
 tikiridb_init()
 {
+#if ROUTING_TIKIRIMC
+  attr_entry_t *entry;
+  attr_data_t address;
+
+  __routing_open(&routing_conn, ROUTING_CHANNEL, &routing_callbacks);
+#else
   //#Asanka: commented the existing routing open function and added our new one
   routing_open(&routing_conn, ROUTING_CHANNEL, &routing_callbacks);
   //routing_openX();
+#endif
 
   qprocessor_init(&qprocessor_callbacks);
   process_start(&tikiridb_process, NULL);
   packetizer_init();
   tikiridb_arch_init();
+
+#if ROUTING_TIKIRIMC
+  /* The SRT node id is the value queries on the node address match. */
+  if(address_attr != ADDRESS_ATTR_NONE) {
+    entry = get_attr_entry(address_attr);
+    if(entry != NULL && entry->get_data(&address) == 0) {
+      srt_set_value(SRT_ATTR_NODE_ID, (uint8_t)address.data_bytes[0]);
+    }
+  }
+#endif
 }
 
 
@@ -41,7 +41,11 @@
 #define __TIKIRIDB_H__
 
 #include "contiki.h"
+#if ROUTING_TIKIRIMC
+#include "routing-tikirimc.h"
+#else
 #include "routing.h"
+#endif
 #include "qprocessor.h"
 
 #include <stdio.h>
@@ -52,6 +56,16 @@ void tikiridb_init(void);
 
 void tikiridb_arch_init(void);
 
+#if ROUTING_TIKIRIMC
+/**
+ * \brief       Name the attribute holding the node address
+ *
+ *              Called from tikiridb_arch_init(). Queries restricting the
+ *              address are then only sent down the subtrees that hold it.
+ */
+void tikiridb_set_address_attr(uint8_t type);
+#endif
+
 #endif /* __TIKIRIDB_H__ */
 
 